@@ -21,7 +21,12 @@ MLIR_CAPI_EXPORTED void airRunnerRun(MlirModule module,
                                      const char *json_file_name,
                                      const char *output_file_name,
                                      const char *function,
-                                     const char *sim_granularity, bool verbose);
+                                     const char *sim_granularity, bool verbose,
+                                     const char *trace_format);
+
+/// Returns true if `trace_format` names a trace format accepted by
+/// airRunnerRun, i.e. one of json, json-compact and perfetto.
+MLIR_CAPI_EXPORTED bool airRunnerIsTraceFormat(const char *trace_format);
 
 #ifdef __cplusplus
 }
@@ -32,13 +32,74 @@ public:
     std::vector<OpCountMap> ops;
   };
 
+  // Compute tile parameters for analytical latency estimation. Zero disables
+  // the corresponding term of the model.
+  struct ComputeParams {
+    // Ops issued per cycle, and the fraction of it achieved in practice
+    double ops_per_cycle = 8;
+    double efficiency = 1.0;
+    // Elements per vector; a partially filled vector costs as much as a full
+    // one
+    unsigned vector_lanes = 0;
+    // Cycles before an accumulator can be reused by a reduction
+    double accumulator_latency = 0;
+    // Cycles spent per trip of the innermost loop
+    double loop_overhead_cycles = 0;
+    // L1 memory bandwidth
+    double read_bytes_per_cycle = 0;
+    double write_bytes_per_cycle = 0;
+  };
+
+  // DMA parameters of a transfer between memory levels, with the meaning they
+  // have in the air-runner device model. Zero disables the corresponding term.
+  struct TransferParams {
+    double bytes_per_cycle = 4;
+    double bd_setup_cycles = 0;
+    double wrap_cycles = 0;
+    double burst_bytes = 0;
+  };
+
   OpCountMap getOpCounts(mlir::Operation *op);
   std::string opCountsToJSON(mlir::ModuleOp module);
   void opCountToJSON(OpCountMap &opCounts, llvm::json::Object &top);
 
+  // Estimate the latency in cycles of a linalg op on one compute tile as the
+  // larger of its compute bound and its L1 memory bound (roofline). Returns 0
+  // if the op has dynamic loop ranges.
+  uint64_t getLinalgOpCycles(mlir::linalg::LinalgOp op,
+                             const ComputeParams &params);
+  // Roofline estimate from precomputed op and byte counts
+  uint64_t getRooflineCycles(double compute_cycles, uint64_t read_bytes,
+                             uint64_t write_bytes, const ComputeParams &params);
+  // Estimate the latency in cycles of one tile of a linalg op, whose loop
+  // ranges are given by `tile`, with the model of getLinalgOpCycles
+  uint64_t getLinalgTileCycles(mlir::linalg::LinalgOp op,
+                               llvm::ArrayRef<int64_t> tile,
+                               const ComputeParams &params);
+  // Get the footprint in bytes of an operand of a linalg op over a tile of
+  // its iteration space
+  static uint64_t getOperandTileBytes(mlir::linalg::LinalgOp op,
+                                      mlir::OpOperand &operand,
+                                      llvm::ArrayRef<int64_t> tile);
+  // Fraction of the DMA bandwidth used by contiguous runs of `run_bytes`
+  static double getBurstEfficiency(double run_bytes, double burst_bytes);
+  // Latency of a DMA streaming for `stream_cycles` at full bandwidth, with
+  // `runs` contiguous runs and the given burst efficiency
+  static uint64_t getDMACycles(double stream_cycles, uint64_t runs,
+                               double efficiency, const TransferParams &params);
+  // Latency of a DMA moving `bytes` in contiguous runs of `run_bytes`
+  static uint64_t getTransferCycles(uint64_t bytes, uint64_t run_bytes,
+                                    const TransferParams &params);
+  // Check if an op in a linalg payload is counted as a compute op
+  static bool isComputeOp(llvm::StringRef name);
+
 private:
   void getScfForOpCounts(OpCountMap &map, mlir::scf::ForOp op);
   void getLinalgOpCounts(OpCountMap &map, mlir::linalg::LinalgOp op);
+  uint64_t getLoopNestCycles(mlir::linalg::LinalgOp op,
+                             llvm::ArrayRef<int64_t> ranges,
+                             uint64_t read_bytes, uint64_t write_bytes,
+                             const ComputeParams &params);
 
   int LayerID;
 };
@@ -24,8 +24,10 @@
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
 #include "mlir/Transforms/RegionUtils.h"
+#include "llvm/ADT/StringMap.h"
 
 #include <numeric>
+#include <optional>
 #include <set>
 #include <string>
 
@@ -84,44 +86,90 @@ struct dependencyNodeEntry;
 struct dependencyGraph;
 class runnerNode;
 
+// Kind of async event represented by a dependency graph vertex
+enum class asyncEventKind : uint8_t {
+  none,
+  start,
+  execute,
+  dma,
+  channel,
+  hierarchy,
+  hierarchy_terminator,
+  terminator,
+  for_loop,
+  parallel_loop,
+  wait_all,
+};
+
+// GraphViz node style for visualization
+enum class graphNodeStyle : uint8_t {
+  none,
+  hierarchy,
+  control,
+  data,
+  compute,
+};
+
+// Interned storage for the display-only strings of dependency graph vertices.
+// Vertices hold a compact id into the table of their dependencyContext
+// instead of owning a std::string, and the strings are freed with the
+// context. The start vertex name and the event names compared by the runner
+// are interned first, at fixed ids. A table is only used by the thread which
+// builds or simulates its graphs, so neither interning nor lookup takes a lock.
+class dependencyStringTable {
+public:
+  enum fixedId : unsigned {
+    emptyId = 0,
+    startId,
+    allocOpId,
+    deallocOpId,
+    executeTerminatorOpId,
+  };
+
+  dependencyStringTable();
+  dependencyStringTable(const dependencyStringTable &) = delete;
+  dependencyStringTable &operator=(const dependencyStringTable &) = delete;
+
+  unsigned intern(llvm::StringRef str);
+  llvm::StringRef lookup(unsigned id) const {
+    assert(id < strings.size() && "unknown dependency string id");
+    return strings[id];
+  }
+
+private:
+  llvm::StringMap<unsigned> ids;
+  // Keys of ids, indexed by id
+  std::vector<llvm::StringRef> strings;
+};
+
 // GraphViz node properties for visualization
 struct graphNodeProperties {
-  std::string color;
-  std::string shape;
+  graphNodeStyle style;
   std::string detailed_description;
 
-  graphNodeProperties(std::string color, std::string shape,
-                      std::string detailed_description)
-      : color(color), shape(shape), detailed_description(detailed_description) {
-  }
   graphNodeProperties(std::string nodeType, std::string details = "") {
     detailed_description = details;
     if (nodeType == "hierarchy") {
-      color = "yellow";
-      shape = "box";
+      style = graphNodeStyle::hierarchy;
     } else if (nodeType == "control") {
-      color = "crimson";
-      shape = "box";
+      style = graphNodeStyle::control;
     } else if (nodeType == "data") {
-      color = "cyan";
-      shape = "oval";
+      style = graphNodeStyle::data;
     } else if (nodeType == "compute") {
-      color = "chartreuse";
-      shape = "oval";
+      style = graphNodeStyle::compute;
     } else {
-      color = "";
-      shape = "";
+      style = graphNodeStyle::none;
     }
   }
 };
 
 // Node entry for dependency graph
 struct dependencyNodeEntry {
-  std::string asyncEventName;
-  std::string asyncEventType;
-  std::string color;
-  std::string shape;
-  std::string detailed_description;
+  asyncEventKind asyncEventType;
+  graphNodeStyle style;
+  // Ids into the dependencyStringTable of the graph's dependencyContext
+  unsigned asyncEventNameId;
+  unsigned detailedDescriptionId;
   unsigned operationId;
   mlir::Operation *op;
   std::vector<dependencyGraph *> nextDependencyGraphs;
@@ -135,17 +183,36 @@ struct dependencyNodeEntry {
   bool is_started() { return (start_time != 0) && (end_time != 0); }
   bool is_done(uint64_t t) { return t >= end_time; }
 
-  dependencyNodeEntry(std::string asyncEventName = "",
-                      std::string asyncEventType = "", std::string color = "",
-                      std::string shape = "",
-                      std::string detailed_description = "",
+  llvm::StringRef
+  getAsyncEventName(const dependencyStringTable &strings) const {
+    return strings.lookup(asyncEventNameId);
+  }
+  void setAsyncEventName(dependencyStringTable &strings, llvm::StringRef name) {
+    asyncEventNameId = strings.intern(name);
+  }
+  llvm::StringRef
+  getDetailedDescription(const dependencyStringTable &strings) const {
+    return strings.lookup(detailedDescriptionId);
+  }
+  void setDetailedDescription(dependencyStringTable &strings,
+                              llvm::StringRef description) {
+    detailedDescriptionId = strings.intern(description);
+  }
+  llvm::StringRef getColor() const;
+  llvm::StringRef getShape() const;
+
+  dependencyNodeEntry(asyncEventKind asyncEventType = asyncEventKind::none,
+                      graphNodeStyle style = graphNodeStyle::none,
+                      unsigned asyncEventNameId = 0,
+                      unsigned detailedDescriptionId = 0,
                       unsigned operationId = 0, mlir::Operation *op = nullptr,
                       uint64_t start_time = 0, uint64_t end_time = 0,
                       int token_count = 0)
-      : asyncEventName(asyncEventName), asyncEventType(asyncEventType),
-        color(color), shape(shape), detailed_description(detailed_description),
-        operationId(operationId), op(op), start_time(start_time),
-        end_time(end_time), token_count(token_count) {}
+      : asyncEventType(asyncEventType), style(style),
+        asyncEventNameId(asyncEventNameId),
+        detailedDescriptionId(detailedDescriptionId), operationId(operationId),
+        op(op), start_time(start_time), end_time(end_time),
+        token_count(token_count) {}
 };
 
 // Dependency graph object
@@ -166,10 +233,9 @@ struct dependencyGraph {
     hierarchyOp = op;
     if (initStartVertex) {
       auto v = g.addVertex();
-      g[v].asyncEventType = "start";
-      g[v].asyncEventName = "start";
-      g[v].color = "yellow";
-      g[v].shape = "box";
+      g[v].asyncEventType = asyncEventKind::start;
+      g[v].asyncEventNameId = dependencyStringTable::startId;
+      g[v].style = graphNodeStyle::hierarchy;
       start_vertex = v;
     }
   }
@@ -183,10 +249,10 @@ struct dependencyGraph {
 };
 
 // Maps involving Graph and vertex
-typedef std::map<std::pair<std::string, unsigned>,
+typedef std::map<std::pair<asyncEventKind, unsigned>,
                  dependencyGraph::Graph::VertexId>
     operation_to_vertex_map;
-typedef std::map<std::pair<std::string, unsigned>, dependencyGraph *>
+typedef std::map<std::pair<asyncEventKind, unsigned>, dependencyGraph *>
     operation_to_graph_map;
 typedef std::map<dependencyGraph::VertexId, dependencyGraph::VertexId>
     vertex_to_vertex_map;
@@ -210,6 +276,10 @@ struct dependencyContext {
   uint64_t TerminatorID;
   operation_to_vertex_map op_to_v;
   operation_to_graph_map op_to_g;
+  // Event names and descriptions of the vertices of the context's graphs
+  dependencyStringTable strings;
+  // Channel puts/gets of the module being parsed, indexed by channel symbol
+  std::optional<ChannelUseAnalysis> channel_uses;
 
   dependencyContext()
       : ExecuteOpID(0), DmaOpID(0), ChannelOpID(0), HierarchyOpID(0),
@@ -235,7 +305,7 @@ public:
   void removeUnusedExecuteOp(func::FuncOp func);
   void removeRedundantWaitAllOps(func::FuncOp func);
   std::pair<VertexId, dependencyGraph *>
-  getVertexFromOp(Operation *op, dependencyContext dep_ctx,
+  getVertexFromOp(Operation *op, const dependencyContext &dep_ctx,
                   std::string front_or_back = "front");
   // CDFG show cores in herd
   unsigned getTripCountInHierarchyOp(air::HierarchyInterface hier);
@@ -261,8 +331,8 @@ private:
                                true, true, true, false});
   VertexId addVertexFromOpImpls(Operation *op, dependencyGraph *G,
                                 dependencyContext &dep_ctx);
-  VertexId addVertexFromOp(Operation *op, uint64_t &id, std::string event_type,
-                           std::string event_name,
+  VertexId addVertexFromOp(Operation *op, uint64_t &id,
+                           asyncEventKind event_type, std::string event_name,
                            graphNodeProperties properties, dependencyGraph *G,
                            dependencyContext &dep_ctx,
                            Operation *pointer_op = nullptr);
@@ -282,13 +352,13 @@ private:
                                   dependencyContext &dep_ctx);
   VertexId addVertexFromWaitAllOp(xilinx::air::WaitAllOp op, dependencyGraph *G,
                                   dependencyContext &dep_ctx);
-  std::pair<std::string, unsigned> getTypeIdPairFromOp(Operation *op);
-  std::string getOpTypeFromOpImpls(Operation *op);
-  void parseDependencyEdgesInGraph(Graph &g, dependencyContext dep_ctx);
+  std::pair<asyncEventKind, unsigned> getTypeIdPairFromOp(Operation *op);
+  asyncEventKind getOpTypeFromOpImpls(Operation *op);
+  void parseDependencyEdgesInGraph(Graph &g, const dependencyContext &dep_ctx);
   void connectOpToItsDepListImpls(Operation *op, Graph &g,
-                                  dependencyContext dep_ctx);
+                                  const dependencyContext &dep_ctx);
   void connectOpToItsDepList(Operation *op, SmallVector<Value, 1> dep_list,
-                             Graph &g, dependencyContext dep_ctx);
+                             Graph &g, const dependencyContext &dep_ctx);
   std::vector<Operation *> traceOpFromToken(Operation *op, Value dep_token);
   void connectTerminatorInGraph(Graph &g);
   void connectStartNodeInCommandGraph(dependencyGraph &G);
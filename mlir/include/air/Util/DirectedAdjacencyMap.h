@@ -6,19 +6,61 @@
 
 #include <cassert>
 #include <cstdint>
-#include <set>
 #include <vector>
 
 namespace xilinx {
 namespace air {
 
+/**
+ * A fixed-size set of bits, packed 64 to a word, so that unions of two sets
+ * are computed one word at a time. Used for the rows of a transitive closure.
+ * */
+class PackedBitset {
+
+public:
+  explicit PackedBitset(uint64_t size = 0)
+      : nBits(size), words((size + 63) / 64, 0) {}
+
+  uint64_t size() const { return nBits; }
+
+  bool test(uint64_t i) const {
+    assert(i < nBits);
+    return (words[i / 64] >> (i % 64)) & 1;
+  }
+
+  void set(uint64_t i) {
+    assert(i < nBits);
+    words[i / 64] |= uint64_t(1) << (i % 64);
+  }
+
+  /**
+   * Set every bit which is set in \p other. Both sets must be of equal size.
+   * */
+  void unionWith(const PackedBitset &other) {
+    assert(nBits == other.nBits);
+    for (uint64_t w = 0; w < words.size(); ++w) {
+      words[w] |= other.words[w];
+    }
+  }
+
+  bool operator==(const PackedBitset &other) const {
+    return nBits == other.nBits && words == other.words;
+  }
+  bool operator!=(const PackedBitset &other) const { return !(*this == other); }
+
+private:
+  uint64_t nBits;
+  std::vector<uint64_t> words;
+};
+
 /**
  * This class is functionally similar to the boost::adjacency_list class. It
  * provides minimal functionality to support the removal of boost in this
  * project. Additional functionality should be added as required.
  *
  * The class implements a directed acyclic graph, where each node can be queried
- * for outgoing edges and incoming edges.
+ * for outgoing edges and incoming edges. The edges of each vertex are kept in
+ * a sorted vector.
  * */
 class DirectedAdjacencyMap {
 
@@ -61,22 +103,20 @@ public:
    * \return true of the graph has an edge from \p src to \p dst, and false
    *         otherwise.
    * */
-  bool hasEdge(VertexId src, VertexId dst) const {
-    return src < numVertices() && (fwdEdges[src].count(dst) > 0);
-  }
+  bool hasEdge(VertexId src, VertexId dst) const;
 
   /**
-   * \return A vector of all vertices which have an edge to \p v.
+   * \return A sorted vector of all vertices which have an edge to \p v.
    * */
-  std::vector<VertexId> inverseAdjacentVertices(VertexId v) const {
-    return {bwdEdges[v].begin(), bwdEdges[v].end()};
+  const std::vector<VertexId> &inverseAdjacentVertices(VertexId v) const {
+    return bwdEdges[v];
   }
 
   /**
-   * \return A vector of all vertices which have an edge from \p v.
+   * \return A sorted vector of all vertices which have an edge from \p v.
    * */
-  std::vector<VertexId> adjacentVertices(VertexId i) const {
-    return {fwdEdges[i].begin(), fwdEdges[i].end()};
+  const std::vector<VertexId> &adjacentVertices(VertexId i) const {
+    return fwdEdges[i];
   }
 
   /**
@@ -91,10 +131,12 @@ public:
    * \return The topological closure of the graph. See
    *         https://en.wikipedia.org/wiki/Transitive_closure
    *
-   *         If out[i][j] is true, then there is a path from i to j (or i == i).
+   *         If out[i].test(j) is true, then there is a path from i to j (or
+   *         i == j).
    *
+   * O(n^2 / 8) bytes of memory, O(n * e / 64) word operations.
    * */
-  std::vector<std::vector<bool>> getClosure() const;
+  std::vector<PackedBitset> getClosure() const;
 
   /**
    * Apply a transitive reduction to this graph. This reduces the number of
@@ -102,7 +144,9 @@ public:
    * closure of this graph. See
    * https://en.wikipedia.org/wiki/Transitive_reduction
    *
-   * O(n^2) memory, O(n^3) operations (same as boost).
+   * The successors of each vertex are visited in topological order, and only
+   * the vertices reachable from retained successors, up to the topologically
+   * last successor, are searched. O(n + e) memory.
    * */
   void applyTransitiveReduction();
 
@@ -124,11 +168,11 @@ protected:
   void updateBwdEdgesFromFwdEdges();
 
 private:
-  // The edges.
-  std::vector<std::set<VertexId>> fwdEdges;
+  // The edges, sorted per vertex.
+  std::vector<std::vector<VertexId>> fwdEdges;
 
-  // The inverse edges.
-  std::vector<std::set<VertexId>> bwdEdges;
+  // The inverse edges, sorted per vertex.
+  std::vector<std::vector<VertexId>> bwdEdges;
 };
 
 /**
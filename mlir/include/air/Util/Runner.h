@@ -21,7 +21,9 @@ namespace air {
 struct AIRRunner {
 
   AIRRunner(llvm::raw_ostream &trace_stream, llvm::json::Value &json_model,
-            std::string sim_granularity = "herd", bool verbose = false);
+            std::string sim_granularity = "herd", bool verbose = false,
+            std::string launch_iterations = "simulate",
+            std::string trace_format = "json", std::string trace_filter = "");
   ~AIRRunner();
 
   void emitTraceStart(llvm::raw_ostream &s);
@@ -44,6 +46,9 @@ std::string to_string(mlir::Type t);
 std::string getElementTypeAsString(const mlir::Type ty);
 std::string lookUpMemorySpaceFromInt(unsigned memory_space);
 unsigned lookUpMemorySpaceIntFromString(std::string memory_space);
+// Comma-separated list of the trace formats accepted by AIRRunner
+llvm::StringRef getTraceFormats();
+bool isTraceFormat(llvm::StringRef format);
 template <typename T> void push_back_if_unique(std::vector<T> &vec, T entry);
 
 } // namespace air
@@ -53,6 +53,10 @@ std::optional<int64_t> getStaticScfForTripCountAsInt(scf::ForOp for_op);
 std::optional<int64_t>
 getStaticAffineForTripCountAsInt(affine::AffineForOp for_op);
 
+// Estimate the bytes moved by a channel put or get: the size of each transfer
+// times the static trip counts of the loops around it, up to scope if given
+uint64_t getChannelBytes(ChannelInterface op, Operation *scope = nullptr);
+
 // Erase a kernel operand from air.hierarchy op
 void eraseAIRHierarchyOperand(HierarchyInterface op, unsigned index);
 
@@ -92,6 +96,44 @@ std::vector<ChannelGetOp> getTheOtherChannelOpThroughSymbol(ChannelPutOp put);
 std::vector<ChannelPutOp> getTheOtherChannelOpThroughSymbol(ChannelGetOp get);
 std::vector<air::ChannelInterface>
 getTheOtherChannelOpThroughSymbol(air::ChannelInterface op);
+
+// Index of air.channel.put/get ops keyed by channel symbol, built by a single
+// walk of the scope op, so that repeated symbol lookups avoid walking the
+// module. Can be requested through the analysis manager, i.e.
+// getAnalysis<air::ChannelUseAnalysis>(). Passes which create, erase or rename
+// channel put/get ops must keep the index in sync, either incrementally, with
+// insert() for each new put/get and erase() once every put/get of a channel is
+// erased, or by calling invalidate(), so that the index is rebuilt on the next
+// lookup. With EXPENSIVE_CHECKS, each lookup asserts that the index is not
+// stale.
+class ChannelUseAnalysis {
+public:
+  ChannelUseAnalysis(Operation *scope) : scope(scope) {}
+
+  std::vector<ChannelPutOp> getChannelPuts(ChannelOp channel);
+  std::vector<ChannelGetOp> getChannelGets(ChannelOp channel);
+  std::vector<ChannelGetOp> getTheOtherChannelOps(ChannelPutOp put);
+  std::vector<ChannelPutOp> getTheOtherChannelOps(ChannelGetOp get);
+  std::vector<ChannelInterface> getTheOtherChannelOps(ChannelInterface op);
+
+  void invalidate() { stale = true; }
+  void insert(ChannelInterface op);
+  void erase(ChannelOp channel);
+
+private:
+  struct ChannelUses {
+    SmallVector<Operation *> puts;
+    SmallVector<Operation *> gets;
+  };
+
+  const ChannelUses *lookup(StringAttr symbol);
+  void rebuild();
+
+  Operation *scope;
+  bool stale = true;
+  llvm::DenseMap<StringAttr, ChannelUses> uses;
+};
+
 void getSizesFromIntegerSet(MLIRContext *ctx, IntegerSet int_set,
                             SmallVector<int, 2> &lbs_int,
                             SmallVector<int, 2> &ubs_int);
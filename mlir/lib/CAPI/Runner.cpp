@@ -20,7 +20,15 @@
 
 void airRunnerRun(MlirModule module, const char *jsonFileName,
                   const char *outputFileName, const char *topLevelFunction,
-                  const char *simGranularity, bool verbose) {
+                  const char *simGranularity, bool verbose,
+                  const char *traceFormat) {
+  if (!airRunnerIsTraceFormat(traceFormat)) {
+    llvm::errs() << "Unknown trace format " << traceFormat
+                 << " (expected one of " << xilinx::air::getTraceFormats()
+                 << ")\n";
+    return;
+  }
+
   auto moduleOp = unwrap(module);
   std::string errorMessage;
   auto json_file = mlir::openInputFile(jsonFileName, &errorMessage);
@@ -44,7 +52,7 @@ void airRunnerRun(MlirModule module, const char *jsonFileName,
   }
 
   xilinx::air::AIRRunner runner(output->os(), *jsonModel, simGranularity,
-                                verbose);
+                                verbose, "simulate", traceFormat);
 
   auto toplevel = moduleOp.lookupSymbol<mlir::func::FuncOp>(topLevelFunction);
   if (!toplevel) {
@@ -59,3 +67,7 @@ void airRunnerRun(MlirModule module, const char *jsonFileName,
   output->keep();
   return;
 }
+
+bool airRunnerIsTraceFormat(const char *traceFormat) {
+  return xilinx::air::isTraceFormat(traceFormat);
+}
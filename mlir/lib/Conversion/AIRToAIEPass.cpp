@@ -80,6 +80,15 @@ int getMemcpySizesAsInt(Value memref, SmallVector<Value> sizes) {
   }
 }
 
+// Channel put/get index of each aie.device, shared by the patterns lowering
+// its channels. Patterns which rewrite channel puts/gets keep it up to date.
+using DeviceChannelUses = std::map<Operation *, air::ChannelUseAnalysis>;
+
+air::ChannelUseAnalysis &getDeviceChannelUses(DeviceChannelUses &channelUses,
+                                              AIE::DeviceOp device) {
+  return channelUses.try_emplace(device, device.getOperation()).first->second;
+}
+
 struct ShimTileAllocator {
 
   std::vector<int> shim_columns;
@@ -90,10 +99,14 @@ struct ShimTileAllocator {
     int shim_col;
     int available_channels;
     std::vector<std::string> chan_names;
+    uint64_t bytes = 0;
   };
 
   std::vector<shim_allocation_info_t> mm2s_allocs, s2mm_allocs;
 
+  // Shim columns planned by planChannels for each channel to or from L3
+  std::map<std::string, std::vector<int>> mm2s_plan, s2mm_plan;
+
   ShimTileAllocator(const AIE::AIETargetModel &target) : aie_target(target) {
     for (int i = 0, e = aie_target.columns(); i < e; i++) {
       if (aie_target.isShimNOCTile(i, 0)) {
@@ -109,6 +122,15 @@ struct ShimTileAllocator {
     bool isMM2S = (src_memory_space < dst_memory_space);
     auto allocs = isMM2S ? &mm2s_allocs : &s2mm_allocs;
 
+    // use the column planned for the channel, if any
+    auto &plan = isMM2S ? mm2s_plan : s2mm_plan;
+    auto planned = plan.find(chan_name);
+    if (planned != plan.end() && !planned->second.empty()) {
+      int shim_col = planned->second.front();
+      planned->second.erase(planned->second.begin());
+      return getPhysTileOp(aie_device, shim_col, 0);
+    }
+
     // return first available shim tile with a free channel
     for (auto &t : *allocs) {
       if (t.available_channels > 0) {
@@ -117,11 +139,120 @@ struct ShimTileAllocator {
         return getPhysTileOp(aie_device, t.shim_col, 0);
       }
     }
-    auto shim_col = shim_columns[allocs->size()];
-    auto shim_tile = getPhysTileOp(aie_device, shim_col, 0);
-    allocs->push_back({shim_col, shim_dma_channels - 1, {chan_name}});
+    for (auto shim_col : shim_columns) {
+      if (getAlloc(*allocs, shim_col))
+        continue;
+      auto shim_tile = getPhysTileOp(aie_device, shim_col, 0);
+      allocs->push_back({shim_col, shim_dma_channels - 1, {chan_name}});
+      return shim_tile;
+    }
+    return nullptr;
+  }
 
-    return shim_tile;
+  // Assign shim columns to all channels in the device which read from or
+  // write to L3, ahead of lowering. Channels are assigned in decreasing order
+  // of their estimated bytes, each to the column with the lowest load in its
+  // direction, preferring the column closest to the tile at the other end of
+  // the channel. The resulting load of each column is reported in a remark.
+  void planChannels(AIE::DeviceOp device,
+                    std::map<AIE::BufferOp, AIE::TileOp> &bufferToMemtileMap,
+                    air::ChannelUseAnalysis &channelUses) {
+    struct request_t {
+      std::string chan_name;
+      bool isMM2S;
+      uint64_t bytes;
+      int col;
+      int count;
+    };
+    std::vector<request_t> requests;
+    for (auto channel : device.getOps<air::ChannelOp>()) {
+      auto puts = channelUses.getChannelPuts(channel);
+      auto gets = channelUses.getChannelGets(channel);
+      std::string name = channel.getName().str();
+      if (puts.empty() && !gets.empty()) {
+        requests.push_back({name, true, getChannelBytes(gets[0]),
+                            getChannelColumn(gets[0], bufferToMemtileMap), 1});
+        continue;
+      }
+      int expectedGets = channel.isBroadcast() ? channel.getBroadcastNum() : 1;
+      int missingGets = expectedGets - (int)gets.size();
+      if (puts.size() == 1 && missingGets > 0)
+        requests.push_back({name, false, getChannelBytes(puts[0]),
+                            getChannelColumn(puts[0], bufferToMemtileMap),
+                            missingGets});
+    }
+    if (requests.empty())
+      return;
+    std::stable_sort(requests.begin(), requests.end(),
+                     [](const request_t &a, const request_t &b) {
+                       return a.bytes > b.bytes;
+                     });
+
+    for (auto &r : requests) {
+      auto &allocs = r.isMM2S ? mm2s_allocs : s2mm_allocs;
+      auto &plan = r.isMM2S ? mm2s_plan : s2mm_plan;
+      for (int i = 0; i < r.count; i++) {
+        int best_col = -1;
+        uint64_t best_load = 0;
+        for (auto shim_col : shim_columns) {
+          auto alloc = getAlloc(allocs, shim_col);
+          if (alloc && alloc->available_channels == 0)
+            continue;
+          uint64_t load = alloc ? alloc->bytes : 0;
+          if (best_col < 0 || load < best_load ||
+              (load == best_load &&
+               std::abs(shim_col - r.col) < std::abs(best_col - r.col))) {
+            best_col = shim_col;
+            best_load = load;
+          }
+        }
+        if (best_col < 0)
+          break;
+        auto alloc = getAlloc(allocs, best_col);
+        if (!alloc) {
+          allocs.push_back({best_col, shim_dma_channels, {}});
+          alloc = &allocs.back();
+        }
+        alloc->available_channels -= 1;
+        alloc->chan_names.push_back(r.chan_name);
+        alloc->bytes += r.bytes;
+        plan[r.chan_name].push_back(best_col);
+      }
+    }
+
+    std::string loads;
+    llvm::raw_string_ostream os(loads);
+    for (auto shim_col : shim_columns) {
+      auto mm2s = getAlloc(mm2s_allocs, shim_col);
+      auto s2mm = getAlloc(s2mm_allocs, shim_col);
+      if (!mm2s && !s2mm)
+        continue;
+      os << " col " << shim_col << ": mm2s " << (mm2s ? mm2s->bytes : 0)
+         << ", s2mm " << (s2mm ? s2mm->bytes : 0) << ";";
+    }
+    device.emitRemark("shim dma load in bytes per column:") << os.str();
+  }
+
+private:
+  shim_allocation_info_t *getAlloc(std::vector<shim_allocation_info_t> &allocs,
+                                   int shim_col) {
+    for (auto &t : allocs)
+      if (t.shim_col == shim_col)
+        return &t;
+    return nullptr;
+  }
+
+  // Column of the tile at the device end of a channel put or get
+  int
+  getChannelColumn(air::ChannelInterface op,
+                   std::map<AIE::BufferOp, AIE::TileOp> &bufferToMemtileMap) {
+    if (auto core = op->getParentOfType<AIE::CoreOp>())
+      return core.getTileOp().getCol();
+    auto buffer =
+        dyn_cast_if_present<AIE::BufferOp>(op.getMemref().getDefiningOp());
+    if (buffer && bufferToMemtileMap.count(buffer))
+      return bufferToMemtileMap[buffer].getCol();
+    return 0;
   }
 };
 
@@ -1085,10 +1216,11 @@ struct LowerAIRChannelsPattern : public OpRewritePattern<air::ChannelOp> {
   LowerAIRChannelsPattern(
       MLIRContext *ctx, ShimTileAllocator &shimTileAlloc,
       std::map<AIE::BufferOp, AIE::TileOp> &bufferToMemtileMap,
-      std::map<Operation *, AIE::ObjectFifoCreateOp> &linksToComplete)
+      std::map<Operation *, AIE::ObjectFifoCreateOp> &linksToComplete,
+      DeviceChannelUses &channelUses)
       : OpRewritePattern(ctx), shimTileAlloc(shimTileAlloc),
         bufferToMemtileMap(bufferToMemtileMap),
-        linksToComplete(linksToComplete) {}
+        linksToComplete(linksToComplete), channelUses(channelUses) {}
 
   LogicalResult matchAndRewrite(air::ChannelOp channel,
                                 PatternRewriter &rewriter) const override {
@@ -1102,10 +1234,9 @@ struct LowerAIRChannelsPattern : public OpRewritePattern<air::ChannelOp> {
       return failure();
 
     AIE::AIEObjectFifoType datatype;
-    std::vector<ChannelPutOp> channelPuts =
-        getChannelPutOpThroughSymbol(channel, device);
-    std::vector<ChannelGetOp> channelGets =
-        getChannelGetOpThroughSymbol(channel, device);
+    auto &uses = getDeviceChannelUses(channelUses, device);
+    std::vector<ChannelPutOp> channelPuts = uses.getChannelPuts(channel);
+    std::vector<ChannelGetOp> channelGets = uses.getChannelGets(channel);
 
     channel->print(llvm::outs());
     llvm::outs() << "channelPuts" << channelPuts.size() << "\n";
@@ -1266,6 +1397,7 @@ struct LowerAIRChannelsPattern : public OpRewritePattern<air::ChannelOp> {
       rewriter.eraseOp(get);
     for (auto put : channelPuts)
       rewriter.eraseOp(put);
+    uses.erase(channel);
     // erase the channel
     rewriter.eraseOp(channel);
     // erase dangling allocs
@@ -1378,6 +1510,7 @@ private:
   ShimTileAllocator &shimTileAlloc;
   std::map<AIE::BufferOp, AIE::TileOp> &bufferToMemtileMap;
   std::map<Operation *, AIE::ObjectFifoCreateOp> &linksToComplete;
+  DeviceChannelUses &channelUses;
 };
 
 // This function replaces ChannelPutOp/ChannelGetOp with AIE_CreateObjectFifoOps
@@ -1390,8 +1523,10 @@ void lowerAIRChannels(
   auto ctx = d->getContext();
   RewritePatternSet patterns(ctx);
   std::map<Operation *, AIE::ObjectFifoCreateOp> linksToComplete;
+  DeviceChannelUses channelUses;
+  s.planChannels(d, bufferToMemtileMap, getDeviceChannelUses(channelUses, d));
   patterns.insert<LowerAIRChannelsPattern>(ctx, s, bufferToMemtileMap,
-                                           linksToComplete);
+                                           linksToComplete, channelUses);
   (void)applyPatternsAndFoldGreedily(d, std::move(patterns));
 }
 
@@ -1426,8 +1561,10 @@ struct SpecializeChannelBundlePattern
   using OpRewritePattern<air::ChannelOp>::OpRewritePattern;
 
   SpecializeChannelBundlePattern(
-      MLIRContext *ctx, std::map<std::string, std::string> &chan_to_chan_map)
-      : OpRewritePattern(ctx), chan_to_chan_map(chan_to_chan_map) {}
+      MLIRContext *ctx, std::map<std::string, std::string> &chan_to_chan_map,
+      DeviceChannelUses &channelUses)
+      : OpRewritePattern(ctx), chan_to_chan_map(chan_to_chan_map),
+        channelUses(channelUses) {}
 
   LogicalResult matchAndRewrite(air::ChannelOp channel,
                                 PatternRewriter &rewriter) const override {
@@ -1439,10 +1576,9 @@ struct SpecializeChannelBundlePattern
     if (channel.getBundleSize() <= 1)
       return failure();
 
-    std::vector<ChannelPutOp> channelPuts =
-        getChannelPutOpThroughSymbol(channel, device);
-    std::vector<ChannelGetOp> channelGets =
-        getChannelGetOpThroughSymbol(channel, device);
+    auto &uses = getDeviceChannelUses(channelUses, device);
+    std::vector<ChannelPutOp> channelPuts = uses.getChannelPuts(channel);
+    std::vector<ChannelGetOp> channelGets = uses.getChannelGets(channel);
 
     // Walk through each element in a channel bundle
     auto bundle_size = extractFromIntegerArrayAttr<int64_t>(channel.getSize());
@@ -1469,6 +1605,7 @@ struct SpecializeChannelBundlePattern
           rewriter.setInsertionPoint(put);
           auto new_put =
               createChannelPutGetWithoutBundle(rewriter, new_chan, put);
+          uses.insert(new_put);
           if (put.getAsyncToken()) {
             replaceAllUsesInRegionWith(put.getAsyncToken(),
                                        new_put.getAsyncToken(),
@@ -1484,6 +1621,7 @@ struct SpecializeChannelBundlePattern
           rewriter.setInsertionPoint(get);
           auto new_get =
               createChannelPutGetWithoutBundle(rewriter, new_chan, get);
+          uses.insert(new_get);
           if (get.getAsyncToken()) {
             replaceAllUsesInRegionWith(get.getAsyncToken(),
                                        new_get.getAsyncToken(),
@@ -1501,6 +1639,7 @@ struct SpecializeChannelBundlePattern
     for (auto get : channelGets) {
       rewriter.eraseOp(get);
     }
+    uses.erase(channel);
     rewriter.eraseOp(channel);
 
     return success();
@@ -1508,6 +1647,7 @@ struct SpecializeChannelBundlePattern
 
 private:
   std::map<std::string, std::string> &chan_to_chan_map;
+  DeviceChannelUses &channelUses;
   bool areIdenticalVectors(std::vector<unsigned> a,
                            std::vector<unsigned> b) const {
     if (a.empty())
@@ -1605,7 +1745,9 @@ void specializeChannelBundle(
     AIE::DeviceOp &d, std::map<std::string, std::string> &chan_to_chan_map) {
   auto ctx = d->getContext();
   RewritePatternSet patterns(ctx);
-  patterns.insert<SpecializeChannelBundlePattern>(ctx, chan_to_chan_map);
+  DeviceChannelUses channelUses;
+  patterns.insert<SpecializeChannelBundlePattern>(ctx, chan_to_chan_map,
+                                                  channelUses);
   (void)applyPatternsAndFoldGreedily(d, std::move(patterns));
 }
 
@@ -2005,14 +2147,6 @@ public:
       chanOps.push_back(op);
     return everyAIRChannelAccessIsNonOverlapping(chanOps);
   }
-  bool hasSinglePutAndGet(air::ChannelOp chan) {
-    auto puts = getChannelPutOpThroughSymbol(
-        chan, chan->getParentOfType<AIE::DeviceOp>());
-    auto gets = getChannelGetOpThroughSymbol(
-        chan, chan->getParentOfType<AIE::DeviceOp>());
-    return puts.size() == 1 && gets.size() == 1;
-  }
-
   void partitionMemref(std::vector<air::ChannelPutOp> &puts,
                        std::vector<air::ChannelGetOp> &gets) {
     std::map<int, SmallVector<air::ChannelInterface>> chanOpPartitions;
@@ -2350,7 +2484,7 @@ public:
     auto internalIndices = chan_o.getIndices();
     bool shim_chans_annotated = false;
     int subChannelIdx = 0;
-    for (auto the_other_chan_o : getTheOtherChannelOpThroughSymbol(chan_o)) {
+    for (auto the_other_chan_o : channelUses->getTheOtherChannelOps(chan_o)) {
       // Many on shim, one on air.hierarchy.
       if (!internalIndices.empty() &&
           internalIndices.size() == the_other_chan_o.getIndices().size()) {
@@ -3373,16 +3507,23 @@ public:
         AIE::AIEDeviceAttr::get(builder.getContext(), *device));
     ShimTileAllocator shimTileAlloc(deviceOp.getTargetModel());
     std::map<Operation *, AIE::ObjectFifoCreateOp> linksToComplete;
+    DeviceChannelUses deviceChannelUses;
     if (clTestPatterns.find("lower-air-channels") != std::string::npos) {
+      m.walk([&](AIE::DeviceOp d) {
+        shimTileAlloc.planChannels(d, bufferToMemtileMap,
+                                   getDeviceChannelUses(deviceChannelUses, d));
+      });
       patterns.insert<LowerAIRChannelsPattern>(
-          ctx, shimTileAlloc, bufferToMemtileMap, linksToComplete);
+          ctx, shimTileAlloc, bufferToMemtileMap, linksToComplete,
+          deviceChannelUses);
     }
     if (clTestPatterns.find("lower-air-ping-pong") != std::string::npos) {
       patterns.insert<LowerAIRPingPongPattern>(ctx);
     }
     std::map<std::string, std::string> chan_to_chan_map;
     if (clTestPatterns.find("specialize-channel-bundle") != std::string::npos) {
-      patterns.insert<SpecializeChannelBundlePattern>(ctx, chan_to_chan_map);
+      patterns.insert<SpecializeChannelBundlePattern>(ctx, chan_to_chan_map,
+                                                      deviceChannelUses);
     }
     if (clTestPatterns.find("insert-control-packet-flow") !=
         std::string::npos) {
@@ -3403,6 +3544,7 @@ public:
     auto module = getOperation();
     OpBuilder builder(module);
     builder.setInsertionPointToStart(module.getBody());
+    channelUses = &getAnalysis<air::ChannelUseAnalysis>();
 
     auto loc = builder.getUnknownLoc();
     auto module_meta = builder.create<airrt::ModuleMetadataOp>(loc);
@@ -3494,6 +3636,9 @@ public:
       if (options.insert_trace_packet_flow)
         createTracePacketFlow(device);
 
+      // The device lowering above rewrote channel puts/gets
+      channelUses->invalidate();
+
       SmallVector<air::HerdOp, 4> herds;
       SmallVector<air::SegmentOp, 4> segs;
       std::set<int64_t> dma_ids;
@@ -3603,6 +3748,10 @@ public:
 
   // Static flow id to ensure unique packet header per packet flow.
   int flowID = 0;
+
+  // Channel put/get index of the module, used to find the other ends of shim
+  // channels when labelling them with metadata.
+  air::ChannelUseAnalysis *channelUses = nullptr;
 };
 
 template <typename OpT>
@@ -23,6 +23,7 @@
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/IRMapping.h"
@@ -31,6 +32,8 @@
 #include "mlir/Pass/Pass.h"
 #include "mlir/Transforms/DialectConversion.h"
 
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
@@ -48,8 +51,10 @@ namespace {
 
 class AIRHerdOpConversion : public ConversionPattern {
 public:
-  explicit AIRHerdOpConversion(MLIRContext *context)
-      : ConversionPattern(air::HerdOp::getOperationName(), 1, context) {}
+  explicit AIRHerdOpConversion(MLIRContext *context, bool pinTiles = false,
+                               bool trace = false)
+      : ConversionPattern(air::HerdOp::getOperationName(), 1, context),
+        pinTiles(pinTiles), trace(trace) {}
 
   LogicalResult
   matchAndRewrite(Operation *op, ArrayRef<Value> operands,
@@ -72,9 +77,21 @@ public:
     //                                                 async::TokenType::get(op->getContext()),
     //                                                 operands[i]).getResult(0));
 
+    auto module = op->getParentOfType<ModuleOp>();
     auto herdExeOp = rewriter.create<async::ExecuteOp>(
         op->getLoc(), retTy, launch.getAsyncDependencies(), empty,
         [&](OpBuilder &r, Location loc, ValueRange v) {
+          // with tracing, the runtime records the herd and each of its tiles
+          Value herdId, herdBegin;
+          if (trace) {
+            herdId = r.create<arith::ConstantIndexOp>(loc, getIdAttr(op));
+            SmallVector<Value> args{
+                herdId, r.create<arith::ConstantIndexOp>(loc, herd_size_x),
+                r.create<arith::ConstantIndexOp>(loc, herd_size_y)};
+            auto fn = air::getMangledFunction(module, "air_trace_herd_begin",
+                                              args, {r.getIndexType()});
+            herdBegin = r.create<func::CallOp>(loc, fn, args).getResult(0);
+          }
           auto size =
               r.create<arith::ConstantIndexOp>(loc, herd_size_x * herd_size_y);
           auto group = r.create<async::CreateGroupOp>(loc, size);
@@ -102,15 +119,47 @@ public:
           auto coreExeOp = r.create<async::ExecuteOp>(
               loc, retTy, empty, empty,
               [&](OpBuilder &b, Location loc, ValueRange v) {
+                if (pinTiles)
+                  createPinTileCall(b, loc, module, outer.getInductionVar(),
+                                    inner.getInductionVar(), herd_size);
+                Value tile;
+                if (trace) {
+                  SmallVector<Value> args{herdId, herdBegin,
+                                          outer.getInductionVar(),
+                                          inner.getInductionVar()};
+                  args.push_back(
+                      b.create<arith::ConstantIndexOp>(loc, herd_size_x));
+                  args.push_back(
+                      b.create<arith::ConstantIndexOp>(loc, herd_size_y));
+                  auto fn = air::getMangledFunction(
+                      module, "air_trace_tile_begin", args, {b.getIndexType()});
+                  tile = b.create<func::CallOp>(loc, fn, args).getResult(0);
+                }
                 for (auto &o : launch.getBody().front().getOperations())
                   if (!isa<air::HerdTerminatorOp>(o))
                     b.clone(o, mapper);
+                if (trace) {
+                  auto fn = air::getMangledFunction(
+                      module, "air_trace_tile_end", {tile}, {});
+                  b.create<func::CallOp>(loc, fn, tile);
+                }
+                if (pinTiles) {
+                  auto fn = air::getMangledFunction(
+                      module, "air_herd_unpin_tile", {}, {});
+                  b.create<func::CallOp>(loc, fn, ValueRange{});
+                }
                 b.create<async::YieldOp>(loc, empty);
               });
           r.create<async::AddToGroupOp>(loc, coreExeOp.getResult(0), group);
 
           r.setInsertionPointAfter(outer);
           r.create<async::AwaitAllOp>(loc, group);
+          if (trace) {
+            SmallVector<Value> args{herdId, herdBegin};
+            auto fn =
+                air::getMangledFunction(module, "air_trace_herd_end", args, {});
+            r.create<func::CallOp>(loc, fn, args);
+          }
           r.create<async::YieldOp>(loc, empty);
         });
     rewriter.setInsertionPointAfter(herdExeOp);
@@ -122,6 +171,154 @@ public:
 
     return success();
   }
+
+private:
+  // Pin the thread running tile (x, y) to a core chosen by the runtime from
+  // the host topology. The tile restores the thread's affinity with
+  // air_herd_unpin_tile when it ends.
+  static void createPinTileCall(OpBuilder &b, Location loc, ModuleOp module,
+                                Value x, Value y, ValueRange herd_size) {
+    SmallVector<Value> operands{x, y};
+    for (auto s : herd_size)
+      operands.push_back(b.create<arith::ConstantIndexOp>(
+          loc, cast<arith::ConstantIndexOp>(s.getDefiningOp()).value()));
+    auto fn =
+        air::getMangledFunction(module, "air_herd_pin_tile", operands, {});
+    b.create<func::CallOp>(loc, fn, operands);
+  }
+
+  bool pinTiles;
+  bool trace;
+};
+
+// Lower an air hierarchy op (herd, segment or launch) to the parallel-for
+// executor of the aircpu runtime: one async task per worker, each taking tiles
+// from the runtime's work-stealing scheduler until the iteration space is
+// exhausted. This bounds the number of tasks by the number of workers rather
+// than the number of tiles.
+template <typename OpT>
+class AIRHierarchyToParallelForConversion : public OpConversionPattern<OpT> {
+public:
+  AIRHierarchyToParallelForConversion(MLIRContext *context, unsigned workers,
+                                      unsigned chunk)
+      : OpConversionPattern<OpT>(context), workers(workers), chunk(chunk) {}
+
+  LogicalResult
+  matchAndRewrite(OpT op, typename OpT::Adaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto hier = cast<air::HierarchyInterface>(op.getOperation());
+    SmallVector<int64_t> sizes;
+    for (auto s : hier.getSizeOperands()) {
+      auto c = getConstantIntValue(s);
+      if (!c)
+        return rewriter.notifyMatchFailure(op, "expected static sizes");
+      sizes.push_back(*c);
+    }
+    int64_t total = 1;
+    for (auto s : sizes)
+      total *= s;
+
+    auto module = op->template getParentOfType<ModuleOp>();
+    auto indexTy = rewriter.getIndexType();
+    SmallVector<Value> empty;
+    SmallVector<Type> retTy;
+
+    // kernel operands follow the async dependencies and the sizes
+    auto operands = adaptor.getOperands();
+    unsigned kernelOperandsBegin =
+        op.getAsyncDependencies().size() + hier.getNumDims();
+
+    auto exeOp = rewriter.create<async::ExecuteOp>(
+        op->getLoc(), retTy, op.getAsyncDependencies(), empty,
+        [&](OpBuilder &r, Location loc, ValueRange v) {
+          auto constant = [&](int64_t i) -> Value {
+            return r.create<arith::ConstantIndexOp>(loc, i);
+          };
+          Value totalVal = constant(total);
+          SmallVector<Value> beginOperands{totalVal, constant(workers),
+                                           constant(chunk)};
+          auto beginFn = air::getMangledFunction(module, "air_executor_begin",
+                                                 beginOperands, {indexTy});
+          Value handle =
+              r.create<func::CallOp>(loc, beginFn, beginOperands).getResult(0);
+          auto workersFn = air::getMangledFunction(
+              module, "air_executor_workers", {handle}, {indexTy});
+          Value numWorkers =
+              r.create<func::CallOp>(loc, workersFn, ValueRange{handle})
+                  .getResult(0);
+
+          auto group = r.create<async::CreateGroupOp>(loc, numWorkers);
+          auto loop =
+              r.create<scf::ForOp>(loc, constant(0), numWorkers, constant(1));
+          r.setInsertionPointToStart(loop.getBody());
+          SmallVector<Value> nextOperands{handle, loop.getInductionVar()};
+          auto nextFn = air::getMangledFunction(module, "air_executor_next",
+                                                nextOperands, {indexTy});
+          auto workerExeOp = r.create<async::ExecuteOp>(
+              loc, retTy, empty, empty,
+              [&](OpBuilder &b, Location loc, ValueRange v) {
+                b.create<scf::WhileOp>(
+                    loc, TypeRange{indexTy}, ValueRange{},
+                    [&](OpBuilder &b, Location loc, ValueRange args) {
+                      Value tile =
+                          b.create<func::CallOp>(loc, nextFn, nextOperands)
+                              .getResult(0);
+                      Value more = b.create<arith::CmpIOp>(
+                          loc, arith::CmpIPredicate::ult, tile, totalVal);
+                      b.create<scf::ConditionOp>(loc, more, tile);
+                    },
+                    [&](OpBuilder &b, Location loc, ValueRange args) {
+                      cloneBodyForTile(b, loc, op, sizes, args[0], operands,
+                                       kernelOperandsBegin);
+                      b.create<scf::YieldOp>(loc);
+                    });
+                b.create<async::YieldOp>(loc, empty);
+              });
+          r.create<async::AddToGroupOp>(loc, workerExeOp.getResult(0), group);
+
+          r.setInsertionPointAfter(loop);
+          r.create<async::AwaitAllOp>(loc, group);
+          auto endFn = air::getMangledFunction(module, "air_executor_end",
+                                               {handle}, {});
+          r.create<func::CallOp>(loc, endFn, ValueRange{handle});
+          r.create<async::YieldOp>(loc, empty);
+        });
+    rewriter.setInsertionPointAfter(exeOp);
+    rewriter.create<async::AwaitOp>(op->getLoc(), exeOp.getResult(0));
+
+    if (auto t = op.getAsyncToken())
+      t.replaceAllUsesWith(exeOp.getResult(0));
+    rewriter.eraseOp(op);
+
+    return success();
+  }
+
+private:
+  // Clone the body of the hierarchy op for the tile with a linear index,
+  // whose last dimension varies fastest
+  static void cloneBodyForTile(OpBuilder &b, Location loc, OpT op,
+                               ArrayRef<int64_t> sizes, Value tile,
+                               ValueRange operands,
+                               unsigned kernelOperandsBegin) {
+    auto hier = cast<air::HierarchyInterface>(op.getOperation());
+    IRMapping mapper;
+    Value rem = tile;
+    for (int d = sizes.size() - 1; d >= 0; d--) {
+      Value size = b.create<arith::ConstantIndexOp>(loc, sizes[d]);
+      mapper.map(hier.getIds()[d], b.create<arith::RemUIOp>(loc, rem, size));
+      rem = b.create<arith::DivUIOp>(loc, rem, size);
+      mapper.map(hier.getSize()[d], hier.getSizeOperands()[d]);
+    }
+    unsigned i = kernelOperandsBegin;
+    for (auto arg : hier.getKernelArguments())
+      mapper.map(arg, operands[i++]);
+    for (auto &o : op.getBody().front().getOperations())
+      if (!o.template hasTrait<OpTrait::IsTerminator>())
+        b.clone(o, mapper);
+  }
+
+  unsigned workers;
+  unsigned chunk;
 };
 
 static func::CallOp convertOpToFunction(Operation *op, ArrayRef<Value> operands,
@@ -570,8 +767,14 @@ struct CallOpConversion : public OpConversionPattern<func::CallOp> {
   }
 };
 
+// The functions which put to or get from each channel, by channel name
+using ChannelUsers = llvm::StringMap<SmallVector<func::FuncOp>>;
+
 struct ChannelOpConversion : public OpConversionPattern<air::ChannelOp> {
-  using OpConversionPattern::OpConversionPattern;
+  ChannelOpConversion(MLIRContext *context, const ChannelUsers &channelUsers,
+                      bool trace = false)
+      : OpConversionPattern(context), channelUsers(channelUsers),
+        trace(trace) {}
 
   LogicalResult
   matchAndRewrite(air::ChannelOp op, OpAdaptor adaptor,
@@ -589,6 +792,9 @@ struct ChannelOpConversion : public OpConversionPattern<air::ChannelOp> {
     auto memrefType =
         MemRefType::get(shape, IntegerType::get(op->getContext(), 64));
     auto name = op.getSymName();
+
+    // find the functions which put to or get from the channel
+    SmallVector<func::FuncOp> users = channelUsers.lookup(name);
     rewriter.eraseOp(op);
 
     auto ptrType = rewriter.getIntegerType(64);
@@ -602,8 +808,100 @@ struct ChannelOpConversion : public OpConversionPattern<air::ChannelOp> {
     if (op->getAttr("broadcast_shape")) {
       globalOp->setAttr("broadcast_shape", op->getAttr("broadcast_shape"));
     }
+    // attach the channel's buffer count, which sets the depth of the
+    // runtime's channel ring buffer
+    globalOp->setAttr("buffer_resources",
+                      rewriter.getI64IntegerAttr(op.getBufferResources()));
+
+    // with tracing, the runtime is told the channel's name for its events
+    memref::GlobalOp nameOp;
+    if (trace) {
+      SmallVector<int8_t> bytes(name.begin(), name.end());
+      auto nameTy = MemRefType::get({(int64_t)bytes.size()},
+                                    rewriter.getIntegerType(8));
+      nameOp = rewriter.create<memref::GlobalOp>(
+          op->getLoc(), ("__air_trace_name_" + name).str(),
+          rewriter.getStringAttr("private"), nameTy,
+          mlir::DenseElementsAttr::get(
+              mlir::RankedTensorType::get(nameTy.getShape(),
+                                          nameTy.getElementType()),
+              ArrayRef<int8_t>(bytes)),
+          /*constant=*/true, nullptr);
+    }
+
+    // each function which uses the channel creates it on entry and destroys
+    // it on return, once its puts and gets have completed (see
+    // awaitChannelTokensBeforeDestroy); the runtime reference counts nested
+    // creations
+    SmallVector<int64_t, 2> bcast_shape(shape.begin(), shape.end());
+    if (auto attr = op->getAttrOfType<ArrayAttr>("broadcast_shape")) {
+      bcast_shape.clear();
+      for (auto i : attr)
+        bcast_shape.push_back(llvm::cast<IntegerAttr>(i).getInt());
+    }
+    for (auto f : users)
+      createChannelLifetimeCalls(rewriter, f, globalOp, nameOp, shape,
+                                 bcast_shape, op.getBufferResources());
     return success();
   }
+
+private:
+  const ChannelUsers &channelUsers;
+  bool trace;
+
+  // Get a global (the channel or its name) as the dynamically shaped memref
+  // taken by the runtime
+  static Value getGlobalMemref(OpBuilder &builder, Location loc,
+                               memref::GlobalOp global) {
+    auto memrefType = global.getType();
+    auto globalPtr = builder.create<memref::GetGlobalOp>(loc, memrefType,
+                                                         global.getSymName());
+    auto dynTy = MemRefType::get(
+        SmallVector<int64_t>(memrefType.getRank(), ShapedType::kDynamic),
+        memrefType.getElementType());
+    return builder.create<memref::CastOp>(loc, dynTy, globalPtr);
+  }
+
+  static void createChannelLifetimeCalls(ConversionPatternRewriter &rewriter,
+                                         func::FuncOp f,
+                                         memref::GlobalOp global,
+                                         memref::GlobalOp nameGlobal,
+                                         ArrayRef<int64_t> shape,
+                                         ArrayRef<int64_t> bcast_shape,
+                                         int64_t depth) {
+    if (f.isExternal())
+      return;
+    OpBuilder::InsertionGuard guard(rewriter);
+    auto module = f->getParentOfType<ModuleOp>();
+    auto loc = f.getLoc();
+
+    rewriter.setInsertionPointToStart(&f.front());
+    SmallVector<Value> operands{getGlobalMemref(rewriter, loc, global)};
+    for (int64_t i : shape)
+      operands.push_back(rewriter.create<arith::ConstantIndexOp>(loc, i));
+    for (int64_t i : bcast_shape)
+      operands.push_back(rewriter.create<arith::ConstantIndexOp>(loc, i));
+    operands.push_back(rewriter.create<arith::ConstantIndexOp>(loc, depth));
+    auto create_fn =
+        air::getMangledFunction(module, "air_channel_create", operands, {});
+    rewriter.create<func::CallOp>(loc, create_fn, operands);
+    if (nameGlobal) {
+      SmallVector<Value> args{operands[0],
+                              getGlobalMemref(rewriter, loc, nameGlobal)};
+      auto name_fn =
+          air::getMangledFunction(module, "air_trace_channel_name", args, {});
+      rewriter.create<func::CallOp>(loc, name_fn, args);
+    }
+
+    f.walk([&](func::ReturnOp ret) {
+      rewriter.setInsertionPoint(ret);
+      Value channel = getGlobalMemref(rewriter, ret.getLoc(), global);
+      auto destroy_fn =
+          air::getMangledFunction(module, "air_channel_destroy", {channel}, {});
+      rewriter.create<func::CallOp>(ret.getLoc(), destroy_fn,
+                                    ValueRange{channel});
+    });
+  }
 };
 
 class ChannelGetOpConversion : public OpConversionPattern<air::ChannelGetOp> {
@@ -673,6 +971,12 @@ public:
       operands.push_back(
           rewriter.create<arith::ConstantIndexOp>(op->getLoc(), 1));
     }
+    // add channel depth, in number of buffers
+    int64_t depth = 1;
+    if (auto attr = channelOp->getAttrOfType<IntegerAttr>("buffer_resources"))
+      depth = attr.getInt();
+    operands.push_back(
+        rewriter.create<arith::ConstantIndexOp>(op->getLoc(), depth));
     operands.append(adaptor.getOperands().begin(), adaptor.getOperands().end());
     auto call = convertOpToFunction(op, operands, rewriter, "air_channel_put");
     if (call)
@@ -682,6 +986,42 @@ public:
   }
 };
 
+// Channel puts and gets with async tokens run in async.execute regions, which
+// may still be queued when the function returns. Before each
+// air_channel_destroy call, await the tokens of the regions preceding it in
+// its block which put to or get from a channel, so that the channel outlives
+// them.
+static void awaitChannelTokensBeforeDestroy(ModuleOp module) {
+  auto isChannelCall = [](Operation *op) {
+    auto call = dyn_cast<func::CallOp>(op);
+    return call && (call.getCallee().starts_with("air_channel_put") ||
+                    call.getCallee().starts_with("air_channel_get"));
+  };
+  SmallVector<func::CallOp> destroys;
+  module.walk([&](func::CallOp call) {
+    if (call.getCallee().starts_with("air_channel_destroy"))
+      destroys.push_back(call);
+  });
+  llvm::DenseSet<Value> awaited;
+  for (auto destroy : destroys) {
+    OpBuilder builder(destroy);
+    Block *block = destroy->getBlock();
+    for (auto &op : llvm::make_range(block->begin(), destroy->getIterator())) {
+      if (!op.getNumRegions())
+        continue;
+      auto walkResult = op.walk([&](Operation *o) {
+        return isChannelCall(o) ? WalkResult::interrupt()
+                                : WalkResult::advance();
+      });
+      if (!walkResult.wasInterrupted())
+        continue;
+      for (auto r : op.getResults())
+        if (isa<async::TokenType>(r.getType()) && awaited.insert(r).second)
+          builder.create<async::AwaitOp>(destroy.getLoc(), r);
+    }
+  }
+}
+
 class AIRToAsyncPass : public air::impl::AIRToAsyncBase<AIRToAsyncPass> {
 
 public:
@@ -698,6 +1038,21 @@ public:
     auto module = getOperation();
     auto context = module.getContext();
 
+    // the runtime trace identifies herds by their id, as air-runner does;
+    // number the herds without one after the others, keeping pid 0 for the
+    // host
+    if (clTrace) {
+      int next_id = 1;
+      module.walk([&](air::HerdOp h) {
+        next_id = std::max(next_id, getIdAttr(h) + 1);
+      });
+      module.walk([&](air::HerdOp h) {
+        if (getIdAttr(h) < 0)
+          h->setAttr("id", IntegerAttr::get(IntegerType::get(context, 32),
+                                            next_id++));
+      });
+    }
+
     TypeConverter converter;
     converter.addConversion([&](Type type) -> std::optional<Type> {
       // convert air::AsyncTokenType to async::TokenType
@@ -730,7 +1085,17 @@ public:
     RewritePatternSet air_dma_patterns(context);
 
     air_dma_patterns.add<AIRDmaMemcpyNdToMemcpyConversion, ExecuteOpConversion,
-                         WaitAllOpConversion, ChannelOpConversion>(context);
+                         WaitAllOpConversion>(context);
+    // find the users of all channels in one walk, rather than walking every
+    // function for each channel
+    ChannelUsers channelUsers;
+    for (auto f : module.getOps<func::FuncOp>())
+      f.walk([&](air::ChannelInterface chanOp) {
+        auto &users = channelUsers[chanOp.getChanName()];
+        if (users.empty() || users.back() != f)
+          users.push_back(f);
+      });
+    air_dma_patterns.add<ChannelOpConversion>(context, channelUsers, clTrace);
 
     if (failed(applyPartialConversion(module, target,
                                       std::move(air_dma_patterns)))) {
@@ -739,7 +1104,18 @@ public:
     }
 
     RewritePatternSet air_herd_patterns(context);
-    air_herd_patterns.add<AIRHerdOpConversion>(context);
+    if (clHerdExecutor == "parallel-for") {
+      air_herd_patterns.add<AIRHierarchyToParallelForConversion<air::LaunchOp>,
+                            AIRHierarchyToParallelForConversion<air::SegmentOp>,
+                            AIRHierarchyToParallelForConversion<air::HerdOp>>(
+          context, clExecutorWorkers, clExecutorChunk);
+    } else if (clHerdExecutor == "async") {
+      air_herd_patterns.add<AIRHerdOpConversion>(context, clPinHerdTiles,
+                                                 clTrace);
+    } else {
+      module.emitOpError("unknown herd executor '") << clHerdExecutor << "'";
+      return signalPassFailure();
+    }
     if (failed(applyPartialConversion(module, target,
                                       std::move(air_herd_patterns)))) {
       emitError(UnknownLoc::get(context), "error lowering air.herd\n");
@@ -807,6 +1183,8 @@ public:
       signalPassFailure();
     }
 
+    awaitChannelTokensBeforeDestroy(module);
+
     for (auto func : module.getOps<func::FuncOp>())
       func->setAttr("llvm.emit_c_interface", UnitAttr::get(func.getContext()));
   }
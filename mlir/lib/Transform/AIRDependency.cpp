@@ -508,7 +508,7 @@ public:
                            async_execute_op);
           // Keep track of processed async execute region ops. Deps should point
           // to the past, not future.
-          async_execute_op_history.push_back(async_execute_op);
+          async_execute_op_history.insert(async_execute_op);
         } else if (auto dma_op =
                        mlir::dyn_cast<xilinx::air::DmaMemcpyNdOp>(op)) {
           traceDeps<air::DmaMemcpyNdOp>(sink_op_memref_reads, dma_op, "RAW");
@@ -516,7 +516,7 @@ public:
                                         "WAW/WAR");
           traceTileIndices(sink_op_memref_reads, sink_op_memref_writes,
                            sink_op_scalar_ins, sink_op_scalar_outs, dma_op);
-          dma_op_history.push_back(dma_op);
+          dma_op_history.insert(dma_op);
         } else if (auto channel_op =
                        mlir::dyn_cast<xilinx::air::ChannelInterface>(op)) {
           traceDeps<air::ChannelInterface>(sink_op_memref_reads, channel_op,
@@ -525,9 +525,9 @@ public:
                                            "WAW/WAR");
           traceTileIndices(sink_op_memref_reads, sink_op_memref_writes,
                            sink_op_scalar_ins, sink_op_scalar_outs, channel_op);
-          channel_op_history.push_back(channel_op);
+          channel_op_history.insert(channel_op);
         } else if (auto hier_op = dyn_cast<air::HierarchyInterface>(op)) {
-          hier_op_history.push_back(hier_op);
+          hier_op_history.insert(hier_op);
         }
       });
     }
@@ -672,11 +672,12 @@ private:
   // Creating async events
   //===----------------------------------------------------------------------===//
 
-  // Air async op history
-  std::vector<air::ExecuteOp> async_execute_op_history;
-  std::vector<air::DmaMemcpyNdOp> dma_op_history;
-  std::vector<air::ChannelInterface> channel_op_history;
-  std::vector<air::HierarchyInterface> hier_op_history;
+  // Air async op history, in program order. Set-backed so that checking
+  // whether a use has already been traced is O(1).
+  llvm::SetVector<air::ExecuteOp> async_execute_op_history;
+  llvm::SetVector<air::DmaMemcpyNdOp> dma_op_history;
+  llvm::SetVector<air::ChannelInterface> channel_op_history;
+  llvm::SetVector<air::HierarchyInterface> hier_op_history;
 
   // Create air execute op with async interface (no ssa result returned); update
   // graph
@@ -1915,35 +1916,19 @@ private:
   //===----------------------------------------------------------------------===//
 
   bool foundAsyncOpUsesAboveCurrentLine(air::ExecuteOp *op) {
-    if (!async_execute_op_history.empty())
-      for (auto &iter : async_execute_op_history)
-        if (iter.getResult(0) == op->getResult(0))
-          return true;
-    return false;
+    return async_execute_op_history.contains(*op);
   }
 
   bool foundAsyncOpUsesAboveCurrentLine(air::DmaMemcpyNdOp *op) {
-    if (!dma_op_history.empty())
-      for (auto &iter : dma_op_history)
-        if (iter->getResult(0) == op->getOperation()->getResult(0))
-          return true;
-    return false;
+    return dma_op_history.contains(*op);
   }
 
   bool foundAsyncOpUsesAboveCurrentLine(air::ChannelInterface *op) {
-    if (!channel_op_history.empty())
-      for (auto &iter : channel_op_history)
-        if (iter->getResult(0) == op->getOperation()->getResult(0))
-          return true;
-    return false;
+    return channel_op_history.contains(*op);
   }
 
   bool foundAsyncOpUsesAboveCurrentLine(air::HierarchyInterface *op) {
-    if (!hier_op_history.empty())
-      for (auto &iter : hier_op_history)
-        if (iter->getResult(0) == op->getOperation()->getResult(0))
-          return true;
-    return false;
+    return hier_op_history.contains(*op);
   }
 
   // Check if two partial memref tiles have identical indices
@@ -349,6 +349,10 @@ private:
 struct HoistAIRChannelInAccumPattern : public OpRewritePattern<scf::ForOp> {
   using OpRewritePattern<scf::ForOp>::OpRewritePattern;
 
+  HoistAIRChannelInAccumPattern(MLIRContext *ctx,
+                                air::ChannelUseAnalysis &channelUses)
+      : OpRewritePattern(ctx), channelUses(channelUses) {}
+
   LogicalResult matchAndRewrite(scf::ForOp for_op,
                                 PatternRewriter &rewriter) const override {
 
@@ -387,10 +391,10 @@ struct HoistAIRChannelInAccumPattern : public OpRewritePattern<scf::ForOp> {
         SmallVector<Operation *> other_chan_ops;
         SmallVector<scf::ForOp> other_for_ops;
         if (auto chan_op_1 = dyn_cast<air::ChannelGetOp>(op_1))
-          for (auto o : getTheOtherChannelOpThroughSymbol(chan_op_1))
+          for (auto o : channelUses.getTheOtherChannelOps(chan_op_1))
             other_chan_ops.push_back(o.getOperation());
         if (auto chan_op_2 = dyn_cast<air::ChannelPutOp>(op_2))
-          for (auto o : getTheOtherChannelOpThroughSymbol(chan_op_2))
+          for (auto o : channelUses.getTheOtherChannelOps(chan_op_2))
             other_chan_ops.push_back(o.getOperation());
         for (auto other_chan_op : other_chan_ops) {
           auto parent_for_op = other_chan_op->getParentOfType<scf::ForOp>();
@@ -495,6 +499,9 @@ struct HoistAIRChannelInAccumPattern : public OpRewritePattern<scf::ForOp> {
   }
 
 private:
+  // Channel put/get index. Hoisting only moves channel ops, so it stays valid.
+  air::ChannelUseAnalysis &channelUses;
+
   // Check if two dma ops are symmetric
   bool areSymmetricChannelOps(air::ChannelGetOp op_1,
                               air::ChannelPutOp op_2) const {
@@ -921,12 +928,12 @@ struct ConstructPingPongDependencyPattern
   LogicalResult matchAndRewrite(scf::ForOp for_op,
                                 PatternRewriter &rewriter) const override {
 
-    // Check if the loop has been unrolled by factor 2
+    // Check if the loop has been unrolled into two or more buffers
     if (!for_op->hasAttr("unroll"))
       return failure();
     uint64_t unroll_factor =
         for_op->getAttrOfType<IntegerAttr>("unroll").getInt();
-    if (unroll_factor != 2)
+    if (unroll_factor < 2)
       return failure();
 
     // Find ping and pong allocs and deallocs
@@ -1021,104 +1028,95 @@ struct ConstructPingPongDependencyPattern
 
     // Construct essential dep edges
 
-    // Part 1: alloc to for
-
-    auto alloc_ping_exec = dyn_cast<air::ExecuteOp>(alloc_execs[0]);
-    auto alloc_pong_exec = dyn_cast<air::ExecuteOp>(alloc_execs[1]);
-    auto alloc_ping_token = alloc_ping_exec.getAsyncToken();
-    auto alloc_pong_token = alloc_pong_exec.getAsyncToken();
-    SmallVector<Value> upstream_tokens = alloc_pong_exec.getAsyncDependencies();
-    clearAsyncDependenciesOfAsyncOp(alloc_ping_exec);
-    for (auto t : upstream_tokens) {
-      alloc_ping_exec.addAsyncDependency(t);
+    // Part 1: alloc to for. The allocs of the first unroll_factor - 1 buffers
+    // take the dependencies of the last one, so that all buffers are
+    // allocated in parallel before entering the loop.
+    if (alloc_execs.size() < unroll_factor)
+      return failure();
+    auto alloc_last_exec =
+        dyn_cast<air::ExecuteOp>(alloc_execs[unroll_factor - 1]);
+    auto alloc_last_token = alloc_last_exec.getAsyncToken();
+    SmallVector<Value> upstream_tokens = alloc_last_exec.getAsyncDependencies();
+    SmallVector<Value, 1> iter_operands;
+    for (unsigned i = 0; i < unroll_factor - 1; i++) {
+      auto alloc_exec = dyn_cast<air::ExecuteOp>(alloc_execs[i]);
+      clearAsyncDependenciesOfAsyncOp(alloc_exec);
+      for (auto t : upstream_tokens) {
+        alloc_exec.addAsyncDependency(t);
+      }
+      alloc_exec->moveBefore(alloc_last_exec);
+      iter_operands.push_back(alloc_exec.getAsyncToken());
     }
-    alloc_ping_exec->moveBefore(alloc_pong_exec);
 
-    SmallVector<Value, 1> iter_operands = {alloc_ping_token, alloc_pong_token,
-                                           alloc_pong_token, alloc_pong_token};
+    // Iter args: one "buffer free" token per buffer, followed by the last
+    // consumer and the last producer tokens
+    iter_operands.push_back(alloc_last_token);
+    iter_operands.push_back(alloc_last_token);
+    iter_operands.push_back(alloc_last_token);
     scf::ForOp new_loop_op =
         replaceForLoopAndAddIterArgs(rewriter, for_op, iter_operands);
-    for_op.getResult(0).replaceAllUsesWith(new_loop_op.getResult(1));
-
-    // Collect ping/pong producer/consumer fronts and backs for ping pong
-    // dependency edge connection
-    SmallVector<Operation *> ping_producer_fronts;
-    SmallVector<Operation *> ping_producer_backs;
-    SmallVector<Operation *> ping_consumer_fronts;
-    SmallVector<Operation *> ping_consumer_backs;
-    SmallVector<Operation *> pong_producer_fronts;
-    SmallVector<Operation *> pong_producer_backs;
-    SmallVector<Operation *> pong_consumer_fronts;
-    SmallVector<Operation *> pong_consumer_backs;
+    for_op.getResult(0).replaceAllUsesWith(
+        new_loop_op.getResult(unroll_factor - 1));
+    auto iter_args = new_loop_op.getRegionIterArgs();
+    Value last_consumer_arg = iter_args[unroll_factor];
+    Value last_producer_arg = iter_args[unroll_factor + 1];
+
+    // Collect producer/consumer fronts and backs of each buffer for
+    // multi-buffering dependency edge connection
+    SmallVector<SmallVector<Operation *>> producer_fronts(unroll_factor);
+    SmallVector<SmallVector<Operation *>> producer_backs(unroll_factor);
+    SmallVector<SmallVector<Operation *>> consumer_fronts(unroll_factor);
+    SmallVector<SmallVector<Operation *>> consumer_backs(unroll_factor);
 
     new_loop_op.getBody()->walk([&](Operation *op) {
       if (op->hasAttr("ping_pong") || op->hasAttr("unrolled_iteration")) {
-        auto ping_pong_id =
+        uint64_t ping_pong_id =
             op->hasAttr("ping_pong")
                 ? (op->getAttrOfType<IntegerAttr>("ping_pong").getUInt())
                 : (op->getAttrOfType<IntegerAttr>("unrolled_iteration")
                        .getInt());
-        // "Ping" producer fronts
-        if (op->hasAttr("async_front") && ping_pong_id == 0) {
-          ping_producer_fronts.push_back(op);
-        }
-        // "Pong" producer fronts
-        else if (op->hasAttr("async_front") && ping_pong_id == 1) {
-          pong_producer_fronts.push_back(op);
-        }
-        // "Ping" consumer backs
-        else if (op->hasAttr("async_back") && ping_pong_id == 0) {
-          ping_consumer_backs.push_back(op);
-        }
-        // "Pong" consumer backs
-        else if (op->hasAttr("async_back") && ping_pong_id == 1) {
-          pong_consumer_backs.push_back(op);
-        }
-        // "Ping" producer backs
-        if (op->hasAttr("producer") && ping_pong_id == 0) {
-          ping_producer_backs.push_back(op);
-        }
-        // "Pong" producer backs
-        if (op->hasAttr("producer") && ping_pong_id == 1) {
-          pong_producer_backs.push_back(op);
-        }
-        // "Ping" consumer fronts
-        if (op->hasAttr("consumer") && ping_pong_id == 0) {
-          ping_consumer_fronts.push_back(op);
-        }
-        // "Pong" consumer fronts
-        if (op->hasAttr("consumer") && ping_pong_id == 1) {
-          pong_consumer_fronts.push_back(op);
-        }
+        if (ping_pong_id >= unroll_factor)
+          return;
+        if (op->hasAttr("async_front"))
+          producer_fronts[ping_pong_id].push_back(op);
+        else if (op->hasAttr("async_back"))
+          consumer_backs[ping_pong_id].push_back(op);
+        if (op->hasAttr("producer"))
+          producer_backs[ping_pong_id].push_back(op);
+        if (op->hasAttr("consumer"))
+          consumer_fronts[ping_pong_id].push_back(op);
       }
     });
 
-    // Part 2: Connect producers
-    for (auto sink : ping_producer_fronts) {
-      // "Ping" producers
-      addAsyncDependencyIfNew(sink, new_loop_op.getRegionIterArgs()[0]);
-      addAsyncDependencyIfNew(sink, new_loop_op.getRegionIterArgs()[3]);
-    }
-    for (auto sink : pong_producer_fronts) {
-      // "Pong" producers
-      clearAsyncDependenciesOfAsyncOp(sink);
-      addAsyncDependencyIfNew(sink, new_loop_op.getRegionIterArgs()[1]);
-      for (auto source : ping_producer_backs) {
-        Value token = getTokenFromOutermostParentAffineIfOp(source);
-        addAsyncDependencyIfNew(sink, token);
+    // Part 2: Connect producers. The producers of buffer 0 wait for the
+    // buffer to be freed and for the last producer of the previous
+    // iteration; the producers of every other buffer wait for it to be freed
+    // and for the producers of the buffer before it.
+    for (auto sink : producer_fronts[0]) {
+      addAsyncDependencyIfNew(sink, iter_args[0]);
+      addAsyncDependencyIfNew(sink, last_producer_arg);
+    }
+    for (unsigned i = 1; i < unroll_factor; i++) {
+      for (auto sink : producer_fronts[i]) {
+        clearAsyncDependenciesOfAsyncOp(sink);
+        addAsyncDependencyIfNew(sink, iter_args[i]);
+        for (auto source : producer_backs[i - 1]) {
+          Value token = getTokenFromOutermostParentAffineIfOp(source);
+          addAsyncDependencyIfNew(sink, token);
+        }
       }
     }
 
-    // Part 3: Connect consumers
-    for (auto sink : ping_consumer_fronts) {
-      // "Ping" consumers
-      addAsyncDependencyIfNew(sink, new_loop_op.getRegionIterArgs()[2]);
+    // Part 3: Connect consumers, in buffer order
+    for (auto sink : consumer_fronts[0]) {
+      addAsyncDependencyIfNew(sink, last_consumer_arg);
     }
-    for (auto sink : pong_consumer_fronts) {
-      // "Pong" consumers
-      for (auto source : ping_consumer_backs) {
-        Value token = getTokenFromOutermostParentAffineIfOp(source);
-        addAsyncDependencyIfNew(sink, token);
+    for (unsigned i = 1; i < unroll_factor; i++) {
+      for (auto sink : consumer_fronts[i]) {
+        for (auto source : consumer_backs[i - 1]) {
+          Value token = getTokenFromOutermostParentAffineIfOp(source);
+          addAsyncDependencyIfNew(sink, token);
+        }
       }
     }
 
@@ -1126,11 +1124,14 @@ struct ConstructPingPongDependencyPattern
     // Note: currently only supports producer and consumer dep graphs with
     // single back
     rewriter.setInsertionPointToEnd(new_loop_op.getBody());
-    SmallVector<Value, 1> yield_operands = {
-        getJointTokenFromOps(rewriter, ping_consumer_backs),
-        getJointTokenFromOps(rewriter, pong_consumer_backs),
-        getJointTokenFromOps(rewriter, pong_consumer_backs),
-        getJointTokenFromOps(rewriter, pong_producer_backs)};
+    SmallVector<Value, 1> yield_operands;
+    for (unsigned i = 0; i < unroll_factor; i++)
+      yield_operands.push_back(
+          getJointTokenFromOps(rewriter, consumer_backs[i]));
+    yield_operands.push_back(
+        getJointTokenFromOps(rewriter, consumer_backs[unroll_factor - 1]));
+    yield_operands.push_back(
+        getJointTokenFromOps(rewriter, producer_backs[unroll_factor - 1]));
     for (auto v : yield_operands) {
       if (!v)
         return failure();
@@ -1402,12 +1403,12 @@ struct HoistOpsNotUsingPingPongPattern : public OpRewritePattern<scf::ForOp> {
     if (for_op->hasAttr("isolated"))
       return failure();
 
-    // Check if the loop has been unrolled by factor 2
+    // Check if the loop has been unrolled into two or more buffers
     if (!for_op->hasAttr("unroll"))
       return failure();
     uint64_t unroll_factor =
         for_op->getAttrOfType<IntegerAttr>("unroll").getInt();
-    if (unroll_factor != 2)
+    if (unroll_factor < 2)
       return failure();
     if (for_op.getInitArgs().size() != 1)
       return failure();
@@ -1459,6 +1460,11 @@ private:
 struct LabelScfForLoopForPingPongPattern : public OpRewritePattern<scf::ForOp> {
   using OpRewritePattern<scf::ForOp>::OpRewritePattern;
 
+  LabelScfForLoopForPingPongPattern(MLIRContext *ctx, int maxBuffers,
+                                    uint64_t l1Size, uint64_t l2Size)
+      : OpRewritePattern(ctx), maxBuffers(maxBuffers), l1Size(l1Size),
+        l2Size(l2Size) {}
+
   LogicalResult matchAndRewrite(scf::ForOp for_op,
                                 PatternRewriter &rewriter) const override {
 
@@ -1477,8 +1483,7 @@ struct LabelScfForLoopForPingPongPattern : public OpRewritePattern<scf::ForOp> {
       return failure();
 
     // Label the scf.for loop and all its child memref.allocs
-    int unroll_factor = 2; // Unroll factor hardened as 2. TODO: add support for
-                           // an arbitrary factor.
+    int unroll_factor = getBufferCount(for_op, alloc_ops);
     for_op->setAttr("unroll", rewriter.getI32IntegerAttr(unroll_factor));
     for (auto op : alloc_ops) {
       op->setAttr("hoist_alloc", rewriter.getBoolAttr(true));
@@ -1488,6 +1493,72 @@ struct LabelScfForLoopForPingPongPattern : public OpRewritePattern<scf::ForOp> {
   }
 
 private:
+  int maxBuffers;
+  uint64_t l1Size;
+  uint64_t l2Size;
+
+  // Get the number of buffers to rotate through in the loop: as many as fit
+  // in the L1 and L2 space left over by allocations outside of the loop in
+  // the parent herd and segment, at least two (ping-pong) and at most
+  // maxBuffers. A static trip count must be a multiple of it, so that
+  // unrolling leaves no remainder iterations.
+  //
+  // The other loops of the herd or segment which rotate through buffers are
+  // budgeted together with this one: a loop labelled earlier takes its
+  // buffers times its count, and the loops yet to be labelled split the
+  // headroom with this one, so that sibling loops do not each take all of it.
+  int getBufferCount(scf::ForOp for_op,
+                     SmallVector<Operation *> &alloc_ops) const {
+    int64_t count = std::max(maxBuffers, 2);
+    auto getAllocBytes = [](memref::AllocOp alloc, unsigned memSpace) {
+      auto ty = alloc.getType();
+      if (ty.getMemorySpaceAsInt() != memSpace || !ty.hasStaticShape())
+        return (uint64_t)0;
+      return air::getTensorVolume(ty) * air::getElementSizeInBytes(ty);
+    };
+    std::vector<std::tuple<unsigned, uint64_t, Operation *>> spaces = {
+        {(unsigned)air::MemorySpace::L1, l1Size,
+         for_op->getParentOfType<air::HerdOp>()},
+        {(unsigned)air::MemorySpace::L2, l2Size,
+         for_op->getParentOfType<air::SegmentOp>()}};
+    for (auto [memSpace, capacity, scope] : spaces) {
+      uint64_t buffer_bytes = 0;
+      for (auto op : alloc_ops)
+        buffer_bytes += getAllocBytes(cast<memref::AllocOp>(op), memSpace);
+      if (!buffer_bytes || !scope)
+        continue;
+      uint64_t other_bytes = 0;
+      uint64_t pending_bytes = buffer_bytes;
+      scope->walk([&](memref::AllocOp alloc) {
+        if (for_op->isAncestor(alloc))
+          return;
+        uint64_t bytes = getAllocBytes(alloc, memSpace);
+        auto loop = getBufferedLoop(alloc);
+        if (!loop)
+          other_bytes += bytes;
+        else if (auto unroll = loop->getAttrOfType<IntegerAttr>("unroll"))
+          other_bytes += bytes * unroll.getInt();
+        else
+          pending_bytes += bytes;
+      });
+      uint64_t headroom = capacity > other_bytes ? capacity - other_bytes : 0;
+      count = std::min(count, (int64_t)(headroom / pending_bytes));
+    }
+    count = std::max(count, (int64_t)2);
+    if (auto tripCount = getStaticScfForTripCountAsInt(for_op))
+      while (count > 2 && *tripCount % count)
+        count--;
+    return count;
+  }
+
+  // The loop an allocation rotates through buffers in if it is labelled by
+  // this pattern, i.e. the scf.for of the air.execute holding it
+  static scf::ForOp getBufferedLoop(memref::AllocOp alloc) {
+    auto exec = dyn_cast<air::ExecuteOp>(alloc->getParentOp());
+    if (!exec)
+      return nullptr;
+    return dyn_cast<scf::ForOp>(exec->getParentOp());
+  }
 };
 
 struct LabelScfForLoopInAIRSegment : public OpRewritePattern<scf::ForOp> {
@@ -2964,7 +3035,8 @@ public:
   void runOptPatterns(func::FuncOp funcOp) {
     MLIRContext *ctx = funcOp.getContext();
     RewritePatternSet patterns(&getContext());
-    patterns.insert<LabelScfForLoopForPingPongPattern>(ctx);
+    patterns.insert<LabelScfForLoopForPingPongPattern>(ctx, clMaxBuffers,
+                                                       clL1Size, clL2Size);
     (void)applyPatternsAndFoldGreedily(funcOp, std::move(patterns));
   }
 
@@ -3401,6 +3473,7 @@ public:
       }
     }
     renameSymbols(channelOps, chan_merge_map);
+    channelUses->invalidate();
     if (!targetMemorySpaces.empty()) {
       for (unsigned i = 0; i < channelOps.size() - 1; i++) {
         for (unsigned j = i + 1; j < channelOps.size(); j++) {
@@ -3413,6 +3486,7 @@ public:
       }
     }
     renameSymbols(channelOps, chan_merge_map);
+    channelUses->invalidate();
   }
 
   void runOnOperation() override {
@@ -3422,6 +3496,7 @@ public:
     std::vector<air::ChannelOp> channelOps;
     module.walk([&](air::ChannelOp op) { channelOps.push_back(op); });
     module.walk([&](func::FuncOp op) { funcOps.push_back(op); });
+    channelUses = &getAnalysis<air::ChannelUseAnalysis>();
     for (auto f : funcOps) {
       runOnFunction(f, channelOps);
     }
@@ -3446,6 +3521,9 @@ public:
   SmallVector<unsigned> targetMemorySpaces;
 
 private:
+  // Channel put/get index; invalidated whenever channel ops are rewritten.
+  air::ChannelUseAnalysis *channelUses = nullptr;
+
   // Get a vector of channel ops which can be fused using a new for loop.
   template <typename T>
   bool areConsistentMemoryAccessPattern(std::vector<T> a_vec,
@@ -3470,8 +3548,8 @@ private:
   }
   std::vector<air::ChannelPutOp>
   getChannelPutsFusableByFor(air::ChannelOp chanA, air::ChannelOp chanB) {
-    std::vector<air::ChannelPutOp> a_puts = getChannelPutOpThroughSymbol(chanA);
-    std::vector<air::ChannelPutOp> b_puts = getChannelPutOpThroughSymbol(chanB);
+    std::vector<air::ChannelPutOp> a_puts = channelUses->getChannelPuts(chanA);
+    std::vector<air::ChannelPutOp> b_puts = channelUses->getChannelPuts(chanB);
 
     if (areConsistentMemoryAccessPattern<air::ChannelPutOp>(a_puts, b_puts))
       return a_puts;
@@ -3480,8 +3558,8 @@ private:
   }
   std::vector<air::ChannelGetOp>
   getChannelGetsFusableByFor(air::ChannelOp chanA, air::ChannelOp chanB) {
-    std::vector<air::ChannelGetOp> a_gets = getChannelGetOpThroughSymbol(chanA);
-    std::vector<air::ChannelGetOp> b_gets = getChannelGetOpThroughSymbol(chanB);
+    std::vector<air::ChannelGetOp> a_gets = channelUses->getChannelGets(chanA);
+    std::vector<air::ChannelGetOp> b_gets = channelUses->getChannelGets(chanB);
 
     if (areConsistentMemoryAccessPattern<air::ChannelGetOp>(a_gets, b_gets))
       return a_gets;
@@ -3523,18 +3601,15 @@ private:
     }
     for (auto e : ops)
       e->erase();
+    channelUses->invalidate();
     return;
   }
 
   void sortChannelsByLoopNests(air::ChannelOp &chan_a, air::ChannelOp &chan_b) {
-    std::vector<air::ChannelPutOp> a_puts =
-        getChannelPutOpThroughSymbol(chan_a);
-    std::vector<air::ChannelPutOp> b_puts =
-        getChannelPutOpThroughSymbol(chan_b);
-    std::vector<air::ChannelGetOp> a_gets =
-        getChannelGetOpThroughSymbol(chan_a);
-    std::vector<air::ChannelGetOp> b_gets =
-        getChannelGetOpThroughSymbol(chan_b);
+    std::vector<air::ChannelPutOp> a_puts = channelUses->getChannelPuts(chan_a);
+    std::vector<air::ChannelPutOp> b_puts = channelUses->getChannelPuts(chan_b);
+    std::vector<air::ChannelGetOp> a_gets = channelUses->getChannelGets(chan_a);
+    std::vector<air::ChannelGetOp> b_gets = channelUses->getChannelGets(chan_b);
     assert(a_puts.size() == 1);
     assert(b_puts.size() == 1);
     assert(a_gets.size() == 1);
@@ -3586,14 +3661,10 @@ private:
     // Check which memory space to time-multiplex channels onto.
     if (targetMemorySpaces.empty())
       return false;
-    std::vector<air::ChannelPutOp> a_puts =
-        getChannelPutOpThroughSymbol(chan_a);
-    std::vector<air::ChannelPutOp> b_puts =
-        getChannelPutOpThroughSymbol(chan_b);
-    std::vector<air::ChannelGetOp> a_gets =
-        getChannelGetOpThroughSymbol(chan_a);
-    std::vector<air::ChannelGetOp> b_gets =
-        getChannelGetOpThroughSymbol(chan_b);
+    std::vector<air::ChannelPutOp> a_puts = channelUses->getChannelPuts(chan_a);
+    std::vector<air::ChannelPutOp> b_puts = channelUses->getChannelPuts(chan_b);
+    std::vector<air::ChannelGetOp> a_gets = channelUses->getChannelGets(chan_a);
+    std::vector<air::ChannelGetOp> b_gets = channelUses->getChannelGets(chan_b);
     if (a_puts.size() != b_puts.size())
       return false;
     if (a_gets.size() != b_gets.size())
@@ -3785,14 +3856,10 @@ private:
   // for loop (NFL).
   std::tuple<bool, std::string>
   checkIfTemporalMergeable(air::ChannelOp chan_a, air::ChannelOp chan_b) {
-    std::vector<air::ChannelPutOp> a_puts =
-        getChannelPutOpThroughSymbol(chan_a);
-    std::vector<air::ChannelPutOp> b_puts =
-        getChannelPutOpThroughSymbol(chan_b);
-    std::vector<air::ChannelGetOp> a_gets =
-        getChannelGetOpThroughSymbol(chan_a);
-    std::vector<air::ChannelGetOp> b_gets =
-        getChannelGetOpThroughSymbol(chan_b);
+    std::vector<air::ChannelPutOp> a_puts = channelUses->getChannelPuts(chan_a);
+    std::vector<air::ChannelPutOp> b_puts = channelUses->getChannelPuts(chan_b);
+    std::vector<air::ChannelGetOp> a_gets = channelUses->getChannelGets(chan_a);
+    std::vector<air::ChannelGetOp> b_gets = channelUses->getChannelGets(chan_b);
     std::tuple<bool, std::string> notMergeable = {false, ""};
     std::tuple<bool, std::string> mergeableToLB = {true, "LB"};
     std::tuple<bool, std::string> mergeableToUB = {true, "UB"};
@@ -4016,6 +4083,7 @@ private:
     if (async_b.getAsyncToken())
       async_b.addAsyncDependency(
           dyn_cast<air::AsyncOpInterface>(a.getOperation()).getAsyncToken());
+    channelUses->invalidate();
   }
   void mergeChannelOpsTemporally(air::ChannelInterface a,
                                  air::ChannelInterface b,
@@ -4041,16 +4109,13 @@ private:
     } else
       assert(false && "invalid mergeByLBOrUB flag");
     eraseParentLoopIfEmpty(*b);
+    channelUses->invalidate();
   }
   void mergeChannels(air::ChannelOp chan_a, air::ChannelOp chan_b) {
-    std::vector<air::ChannelPutOp> a_puts =
-        getChannelPutOpThroughSymbol(chan_a);
-    std::vector<air::ChannelPutOp> b_puts =
-        getChannelPutOpThroughSymbol(chan_b);
-    std::vector<air::ChannelGetOp> a_gets =
-        getChannelGetOpThroughSymbol(chan_a);
-    std::vector<air::ChannelGetOp> b_gets =
-        getChannelGetOpThroughSymbol(chan_b);
+    std::vector<air::ChannelPutOp> a_puts = channelUses->getChannelPuts(chan_a);
+    std::vector<air::ChannelPutOp> b_puts = channelUses->getChannelPuts(chan_b);
+    std::vector<air::ChannelGetOp> a_gets = channelUses->getChannelGets(chan_a);
+    std::vector<air::ChannelGetOp> b_gets = channelUses->getChannelGets(chan_b);
     // Interleave puts and gets
     for (unsigned i = 0; i < a_puts.size(); i++)
       mergeChannelOps(a_puts[i], b_puts[i]);
@@ -4059,14 +4124,10 @@ private:
   }
   void mergeChannelOpsTemporally(air::ChannelOp chan_a, air::ChannelOp chan_b,
                                  std::string mergeByLBOrUB) {
-    std::vector<air::ChannelPutOp> a_puts =
-        getChannelPutOpThroughSymbol(chan_a);
-    std::vector<air::ChannelPutOp> b_puts =
-        getChannelPutOpThroughSymbol(chan_b);
-    std::vector<air::ChannelGetOp> a_gets =
-        getChannelGetOpThroughSymbol(chan_a);
-    std::vector<air::ChannelGetOp> b_gets =
-        getChannelGetOpThroughSymbol(chan_b);
+    std::vector<air::ChannelPutOp> a_puts = channelUses->getChannelPuts(chan_a);
+    std::vector<air::ChannelPutOp> b_puts = channelUses->getChannelPuts(chan_b);
+    std::vector<air::ChannelGetOp> a_gets = channelUses->getChannelGets(chan_a);
+    std::vector<air::ChannelGetOp> b_gets = channelUses->getChannelGets(chan_b);
     if (!b_puts[0]->getParentOfType<air::HerdOp>()) {
       mergeChannelOpsTemporally(a_puts[0], b_puts[0], mergeByLBOrUB);
     }
@@ -4299,11 +4360,12 @@ public:
 
     // Post processing, hoisting air.herd ops out of perfectly nested scf.for
     // loop.
+    air::ChannelUseAnalysis channelUses(module);
     for (auto f : funcOps) {
       RewritePatternSet patterns_1(f.getContext());
-      patterns_1
-          .insert<HoistAIRHerdInForPattern, HoistAIRChannelInAccumPattern>(
-              f.getContext(), false);
+      patterns_1.insert<HoistAIRHerdInForPattern>(f.getContext(), false);
+      patterns_1.insert<HoistAIRChannelInAccumPattern>(f.getContext(),
+                                                       channelUses);
       (void)applyPatternsAndFoldGreedily(f, std::move(patterns_1));
     }
   }
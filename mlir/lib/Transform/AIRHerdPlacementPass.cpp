@@ -25,6 +25,7 @@
 #include "llvm/Support/raw_ostream.h"
 
 #include <algorithm>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -138,6 +139,14 @@ public:
     }
   }
 
+  void removeHerd(std::unique_ptr<Herd> &herd, int32_t row, int32_t col) {
+    for (int i = numRows - row - herd->getNumRows(); i < numRows - row; i++) {
+      for (int j = col; j < herd->getNumCols() + col; j++) {
+        grid[i][j] = -1;
+      }
+    }
+  }
+
   void printSegment() const {
     for (uint32_t i = 0; i < grid.size(); i++) {
       for (uint32_t j = 0; j < grid[i].size(); j++) {
@@ -157,6 +166,35 @@ private:
   int32_t locY;
 };
 
+// Bytes moved through air.channel ops by the herds of a segment, indexed by
+// herd number: between pairs of herds, and between each herd and memtiles
+// (L2) or shim DMAs (L3) outside of any herd.
+struct HerdTraffic {
+  std::map<std::pair<uint32_t, uint32_t>, double> herds;
+  std::map<uint32_t, double> memtile;
+  std::map<uint32_t, double> shim;
+
+  static std::pair<uint32_t, uint32_t> getKey(uint32_t a, uint32_t b) {
+    return a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+  }
+
+  bool empty() const {
+    return herds.empty() && memtile.empty() && shim.empty();
+  }
+
+  double getTotal(uint32_t herd) const {
+    double total = 0;
+    for (auto &t : herds)
+      if (t.first.first == herd || t.first.second == herd)
+        total += t.second;
+    if (memtile.count(herd))
+      total += memtile.at(herd);
+    if (shim.count(herd))
+      total += shim.at(herd);
+    return total;
+  }
+};
+
 class AIRHerdPlacementPass
     : public xilinx::air::impl::AIRHerdPlacementPassBase<AIRHerdPlacementPass> {
 
@@ -177,6 +215,11 @@ public:
       llvm::errs() << "Ensure all input parameters are greater than zero.\n";
       return;
     }
+    if (clPlacement != "naive" && clPlacement != "communication") {
+      llvm::errs() << "Unknown placement '" << clPlacement
+                   << "', expected 'naive' or 'communication'.\n";
+      return;
+    }
 
     auto module = getOperation();
 
@@ -217,7 +260,10 @@ public:
       auto col_offset = col_offset_op ? *col_offset_op : clAnchorPointCol;
       auto segment =
           std::make_unique<Segment>(num_rows, num_cols, row_offset, col_offset);
-      placeHerdsInSegment(segmentHerds, segment);
+      HerdTraffic traffic;
+      if (clPlacement == "communication")
+        traffic = getHerdTraffic(part, segmentHerds);
+      placeHerdsInSegment(segmentHerds, segment, traffic);
 
       auto intTy = IntegerType::get(part->getContext(), 64);
       part->setAttr(part.getRowOffsetAttrName(),
@@ -253,7 +299,7 @@ public:
             std::make_unique<Herd>(herd, herd_size_y, herd_size_x, number);
         unplacedHerds.push_back(std::move(herdPtr));
 
-        placeHerdsInSegment(unplacedHerds, segment);
+        placeHerdsInSegment(unplacedHerds, segment, HerdTraffic());
       });
     });
     return;
@@ -261,7 +307,8 @@ public:
 
 private:
   void placeHerdsInSegment(std::vector<std::unique_ptr<Herd>> &unplacedHerds,
-                           std::unique_ptr<Segment> &segment) {
+                           std::unique_ptr<Segment> &segment,
+                           const HerdTraffic &traffic) {
 
     std::sort(
         unplacedHerds.begin(), unplacedHerds.end(),
@@ -282,6 +329,9 @@ private:
       return;
     }
 
+    if (!traffic.empty())
+      searchPlacement(segment, placedHerds, traffic);
+
     auto xLocName = xilinx::air::HerdOp::getColOffsetAttrName();
     auto yLocName = xilinx::air::HerdOp::getRowOffsetAttrName();
 
@@ -328,6 +378,217 @@ private:
     return;
   }
 
+  HerdTraffic
+  getHerdTraffic(air::SegmentOp part,
+                 std::vector<std::unique_ptr<Herd>> &segmentHerds) {
+    std::map<Operation *, uint32_t> herdNumbers;
+    for (auto &herd : segmentHerds)
+      for (auto herdOp : herd->getHerdOps())
+        herdNumbers[herdOp.getOperation()] = herd->getNumber();
+
+    // Channel endpoints by channel name, with the number of the herd they
+    // are in, or -1 for ops outside of herds
+    using Endpoint = std::pair<int64_t, air::ChannelInterface>;
+    std::map<std::string, std::vector<Endpoint>> puts, gets;
+    part.walk([&](air::ChannelInterface op) {
+      int64_t number = -1;
+      if (auto herd = op->getParentOfType<air::HerdOp>())
+        number = herdNumbers[herd.getOperation()];
+      auto endpoint = std::make_pair(number, op);
+      if (isa<air::ChannelPutOp>(op))
+        puts[op.getChanName().str()].push_back(endpoint);
+      else
+        gets[op.getChanName().str()].push_back(endpoint);
+    });
+
+    auto getBytes = [&](air::ChannelInterface op) {
+      return (double)getChannelBytes(op, part);
+    };
+    HerdTraffic traffic;
+    for (auto &put : puts) {
+      for (auto &src : put.second) {
+        for (auto &dst : gets[put.first]) {
+          if (src.first == dst.first)
+            continue;
+          if (src.first >= 0 && dst.first >= 0) {
+            auto key = HerdTraffic::getKey(src.first, dst.first);
+            traffic.herds[key] += getBytes(src.second);
+            continue;
+          }
+          auto &herdEnd = src.first >= 0 ? src : dst;
+          auto &otherEnd = src.first >= 0 ? dst : src;
+          auto memSpace =
+              llvm::cast<MemRefType>(otherEnd.second.getMemref().getType())
+                  .getMemorySpaceAsInt();
+          if (memSpace == (int)air::MemorySpace::L2)
+            traffic.memtile[herdEnd.first] += getBytes(herdEnd.second);
+          else
+            traffic.shim[herdEnd.first] += getBytes(herdEnd.second);
+        }
+      }
+    }
+    return traffic;
+  }
+
+  // Cost of a placement: the bytes each pair of herds exchanges weighted by
+  // the Manhattan distance between them, the bytes each herd exchanges with
+  // memtiles and shims weighted by its row distance from the bottom of the
+  // segment, and a port contention term which grows with the square of the
+  // memtile and shim traffic entering each column.
+  struct PlacementCost {
+    PlacementCost(const HerdTraffic &traffic, int32_t numCols)
+        : traffic(traffic), memtileLoad(numCols, 0), shimLoad(numCols, 0) {
+      for (auto &t : traffic.memtile)
+        totalMemtile += t.second;
+      for (auto &t : traffic.shim)
+        totalShim += t.second;
+    }
+
+    // Cost added by placing herd after all herds in placed
+    double add(const std::unique_ptr<Herd> &herd,
+               const std::vector<const Herd *> &placed) {
+      double cost = 0;
+      for (auto other : placed) {
+        auto key = HerdTraffic::getKey(herd->getNumber(), other->getNumber());
+        auto it = traffic.herds.find(key);
+        if (it != traffic.herds.end())
+          cost += it->second * getDistance(*herd, *other);
+      }
+      cost += addPortLoad(*herd, traffic.memtile, memtileLoad, totalMemtile);
+      cost += addPortLoad(*herd, traffic.shim, shimLoad, totalShim);
+      return cost;
+    }
+
+    void remove(const std::unique_ptr<Herd> &herd) {
+      removePortLoad(*herd, traffic.memtile, memtileLoad);
+      removePortLoad(*herd, traffic.shim, shimLoad);
+    }
+
+  private:
+    const HerdTraffic &traffic;
+    std::vector<double> memtileLoad;
+    std::vector<double> shimLoad;
+    double totalMemtile = 0;
+    double totalShim = 0;
+
+    static int32_t getDistance(const Herd &a, const Herd &b) {
+      auto gap = [](int32_t loA, int32_t sizeA, int32_t loB, int32_t sizeB) {
+        return std::max({0, loB - (loA + sizeA - 1), loA - (loB + sizeB - 1)});
+      };
+      return gap(a.getLocX(), a.getNumCols(), b.getLocX(), b.getNumCols()) +
+             gap(a.getLocY(), a.getNumRows(), b.getLocY(), b.getNumRows());
+    }
+
+    // Herd traffic to memtiles or shims is spread evenly over its columns
+    double addPortLoad(const Herd &herd, const std::map<uint32_t, double> &t,
+                       std::vector<double> &load, double total) {
+      auto it = t.find(herd.getNumber());
+      if (it == t.end())
+        return 0;
+      double cost = it->second * herd.getLocY();
+      double perCol = it->second / herd.getNumCols();
+      for (int32_t j = herd.getLocX(); j < herd.getLocX() + herd.getNumCols();
+           j++) {
+        cost += ((load[j] + perCol) * (load[j] + perCol) - load[j] * load[j]) /
+                total;
+        load[j] += perCol;
+      }
+      return cost;
+    }
+
+    void removePortLoad(const Herd &herd, const std::map<uint32_t, double> &t,
+                        std::vector<double> &load) {
+      auto it = t.find(herd.getNumber());
+      if (it == t.end())
+        return;
+      double perCol = it->second / herd.getNumCols();
+      for (int32_t j = herd.getLocX(); j < herd.getLocX() + herd.getNumCols();
+           j++)
+        load[j] -= perCol;
+    }
+  };
+
+  // Improves on a complete placement by branch-and-bound search over the
+  // positions of each herd, placing the herds with the most traffic first.
+  // Placements are only replaced by strictly cheaper ones, and the search
+  // stops after a fixed number of nodes, keeping the best placement found so
+  // far, so the result is deterministic.
+  void searchPlacement(std::unique_ptr<Segment> &segment,
+                       std::vector<std::unique_ptr<Herd>> &herds,
+                       const HerdTraffic &traffic) {
+    std::stable_sort(herds.begin(), herds.end(),
+                     [&](const std::unique_ptr<Herd> &l,
+                         const std::unique_ptr<Herd> &r) {
+                       return traffic.getTotal(l->getNumber()) >
+                              traffic.getTotal(r->getNumber());
+                     });
+
+    std::vector<const Herd *> placed;
+    std::vector<std::pair<int32_t, int32_t>> best;
+    double bestCost = 0;
+    {
+      PlacementCost cost(traffic, segment->getNumCols());
+      for (auto &herd : herds) {
+        bestCost += cost.add(herd, placed);
+        placed.push_back(herd.get());
+        best.emplace_back(herd->getLocY(), herd->getLocX());
+      }
+      placed.clear();
+    }
+    double initialCost = bestCost;
+
+    for (uint32_t k = 0; k < herds.size(); k++)
+      segment->removeHerd(herds[k], best[k].first, best[k].second);
+
+    // bound the search by the nodes it visits rather than by time, so that
+    // the placement does not depend on the speed of the host
+    bool exhausted = false;
+    uint64_t visited = 0;
+    PlacementCost cost(traffic, segment->getNumCols());
+    std::function<void(uint32_t, double)> search = [&](uint32_t k,
+                                                       double partialCost) {
+      if (++visited > clSearchBudget)
+        exhausted = true;
+      if (exhausted)
+        return;
+      if (k == herds.size()) {
+        bestCost = partialCost;
+        for (uint32_t i = 0; i < herds.size(); i++)
+          best[i] = {herds[i]->getLocY(), herds[i]->getLocX()};
+        return;
+      }
+      for (int32_t i = 0; i < segment->getNumRows(); i++) {
+        for (int32_t j = 0; j < segment->getNumCols(); j++) {
+          if (!segment->isLegalPlacement(herds[k], i, j))
+            continue;
+          herds[k]->setLocX(j);
+          herds[k]->setLocY(i);
+          double c = partialCost + cost.add(herds[k], placed);
+          // costs are non-negative, so no completion of a placement at least
+          // as expensive as the best one can improve on it
+          if (c < bestCost) {
+            segment->placeHerd(herds[k], i, j);
+            placed.push_back(herds[k].get());
+            search(k + 1, c);
+            placed.pop_back();
+            segment->removeHerd(herds[k], i, j);
+          }
+          cost.remove(herds[k]);
+        }
+      }
+    };
+    search(0, 0);
+
+    for (uint32_t k = 0; k < herds.size(); k++) {
+      herds[k]->setLocY(best[k].first);
+      herds[k]->setLocX(best[k].second);
+      segment->placeHerd(herds[k], best[k].first, best[k].second);
+    }
+    LLVM_DEBUG(llvm::dbgs()
+               << "communication cost " << initialCost << " -> " << bestCost
+               << (exhausted ? " (search budget exhausted)" : "") << "\n");
+  }
+
 }; // end AIRHerdPlacementPass
 
 } // end namespace
@@ -32,7 +32,12 @@
 
 #include "llvm/ADT/ScopeExit.h"
 #include "llvm/ADT/SetVector.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
 
+#include <functional>
+#include <map>
 #include <numeric>
 #include <optional>
 
@@ -1124,6 +1129,369 @@ void AIRPipelineReducePass::runOnOperation() {
 
   (void)applyPatternsAndFoldGreedily(func, std::move(patterns));
 }
+//===----------------------------------------------------------------------===//
+// Tiling autotuner
+//===----------------------------------------------------------------------===//
+
+// A tiling of a linalg op chosen by the autotuner. An empty l2_tile_size
+// means the op is not tiled for L2.
+struct LinalgTilingConfig {
+  SmallVector<int64_t> l2_tile_size;
+  SmallVector<int64_t> herd_size;
+  SmallVector<int64_t> l1_tile_size;
+  SmallVector<unsigned> l1_tile_interchange;
+  uint64_t cycles = 0;
+};
+
+// Search the tilings of a linalg op with static shapes for the lowest
+// estimated latency. Each L2 tile is fetched from L3, then split over the
+// herd, whose cores compute their L1 tiles while fetching the next ones from
+// L2. An operand tile is refetched whenever a loop it depends on, or any loop
+// outside of that one, advances.
+class LinalgTilingAutotuner {
+public:
+  LinalgTilingAutotuner(uint64_t l1Size, uint64_t l2Size,
+                        SmallVector<int64_t, 2> maxHerd, std::string cachePath)
+      : l1Size(l1Size), l2Size(l2Size), maxHerd(maxHerd),
+        cachePath(cachePath) {
+    if (cachePath.empty())
+      return;
+    auto buffer = llvm::MemoryBuffer::getFile(cachePath);
+    if (!buffer)
+      return;
+    auto json = llvm::json::parse((*buffer)->getBuffer());
+    if (!json) {
+      llvm::consumeError(json.takeError());
+      return;
+    }
+    auto *top = json->getAsObject();
+    if (!top)
+      return;
+    for (auto &entry : *top) {
+      auto *obj = entry.second.getAsObject();
+      if (!obj)
+        continue;
+      LinalgTilingConfig config;
+      auto getList = [&](StringRef key, auto &list) {
+        if (auto *array = obj->getArray(key))
+          for (auto &v : *array)
+            if (auto i = v.getAsInteger())
+              list.push_back(*i);
+      };
+      getList("l2-tile-size", config.l2_tile_size);
+      getList("herd-size", config.herd_size);
+      getList("l1-tile-size", config.l1_tile_size);
+      getList("l1-tile-permute", config.l1_tile_interchange);
+      config.cycles = obj->getInteger("cycles").value_or(0);
+      cache[entry.first.str()] = config;
+    }
+  }
+
+  // Get the best tiling of op. With implicitHerd the L1 tile loops along the
+  // first two dimensions form the herd, as in the matmul strategy, so each
+  // core computes a single L1 tile along them.
+  std::optional<LinalgTilingConfig> getConfig(linalg::LinalgOp op,
+                                              bool implicitHerd) {
+    std::string key = getSignature(op, implicitHerd);
+    auto it = cache.find(key);
+    if (it != cache.end() && isValid(op, it->second)) {
+      LLVM_DEBUG(llvm::outs() << "autotune cache hit: " << key << "\n");
+      return it->second;
+    }
+    auto config = search(op, implicitHerd);
+    if (config) {
+      cache[key] = *config;
+      dirty = true;
+    }
+    return config;
+  }
+
+  // Write the cache back to its file if it has new entries
+  void save() {
+    if (cachePath.empty() || !dirty)
+      return;
+    llvm::json::Object top;
+    for (auto &[key, config] : cache) {
+      llvm::json::Object obj;
+      obj["l2-tile-size"] = llvm::json::Array(config.l2_tile_size);
+      obj["herd-size"] = llvm::json::Array(config.herd_size);
+      obj["l1-tile-size"] = llvm::json::Array(config.l1_tile_size);
+      obj["l1-tile-permute"] = llvm::json::Array(config.l1_tile_interchange);
+      obj["cycles"] = config.cycles;
+      top[key] = std::move(obj);
+    }
+    std::error_code ec;
+    llvm::raw_fd_ostream os(cachePath, ec);
+    if (ec) {
+      llvm::errs() << "failed to write autotune cache " << cachePath << ": "
+                   << ec.message() << "\n";
+      return;
+    }
+    os << llvm::formatv("{0:2}", llvm::json::Value(std::move(top))) << "\n";
+    dirty = false;
+  }
+
+private:
+  struct Operand {
+    OpOperand *operand;
+    AffineMap map;
+    ArrayRef<int64_t> shape;
+    uint64_t element_bytes;
+    // Number of transfers per fetch: one to read, one to write back
+    unsigned transfers;
+  };
+
+  // Check that a cached configuration fits the loop nest of op
+  static bool isValid(linalg::LinalgOp op, const LinalgTilingConfig &config) {
+    size_t nLoops = op.getNumLoops();
+    return (config.l2_tile_size.empty() ||
+            config.l2_tile_size.size() == nLoops) &&
+           config.herd_size.size() == 2 &&
+           config.l1_tile_size.size() == nLoops &&
+           config.l1_tile_interchange.size() == nLoops;
+  }
+
+  // The op, its operand types, indexing maps, iterators and payload, and the
+  // search limits
+  std::string getSignature(linalg::LinalgOp op, bool implicitHerd) {
+    std::string sig;
+    llvm::raw_string_ostream os(sig);
+    os << op->getName();
+    for (auto ty : op->getOperandTypes())
+      os << " " << ty;
+    for (auto map : op.getIndexingMapsArray())
+      os << " " << map;
+    os << " ";
+    for (auto it : op.getIteratorTypesArray())
+      os << (linalg::isParallelIterator(it) ? "p" : "r");
+    for (auto &o : op->getRegion(0).getOps())
+      os << " " << o.getName();
+    os << " l1=" << l1Size << " l2=" << l2Size << " herd=" << maxHerd[0] << "x"
+       << maxHerd[1] << (implicitHerd ? " implicit" : "");
+    return os.str();
+  }
+
+  static SmallVector<int64_t> getDivisors(int64_t n, int64_t max) {
+    SmallVector<int64_t> divisors;
+    for (int64_t d = 1; d <= std::min(n, max); d++)
+      if (n % d == 0)
+        divisors.push_back(d);
+    return divisors;
+  }
+
+  // Call fn on each tuple in the cartesian product of choices
+  static void
+  forEachTuple(ArrayRef<SmallVector<int64_t>> choices,
+               llvm::function_ref<void(ArrayRef<int64_t>)> fn) {
+    SmallVector<unsigned> idx(choices.size(), 0);
+    SmallVector<int64_t> tuple(choices.size());
+    if (llvm::any_of(choices, [](auto &c) { return c.empty(); }))
+      return;
+    while (true) {
+      for (unsigned i = 0; i < choices.size(); i++)
+        tuple[i] = choices[i][idx[i]];
+      fn(tuple);
+      unsigned i = 0;
+      for (; i < choices.size(); i++) {
+        if (++idx[i] < choices[i].size())
+          break;
+        idx[i] = 0;
+      }
+      if (i == choices.size())
+        return;
+    }
+  }
+
+  uint64_t getFootprint(linalg::LinalgOp op, ArrayRef<int64_t> tile) {
+    uint64_t bytes = 0;
+    for (auto &o : operands)
+      bytes += air::CostModel::getOperandTileBytes(op, *o.operand, tile);
+    return bytes;
+  }
+
+  // Bytes in each contiguous run of an operand tile: the innermost dims of
+  // the tile, up to and including the first one not spanning its operand
+  static uint64_t getRunBytes(const Operand &o, ArrayRef<int64_t> tile) {
+    uint64_t run = 1;
+    for (int i = o.map.getNumResults() - 1; i >= 0; i--) {
+      unsigned d = o.map.getDimPosition(i);
+      run *= tile[d];
+      if (tile[d] != o.shape[i])
+        break;
+    }
+    return run * o.element_bytes;
+  }
+
+  // Latency of fetching the operand tiles of a loop nest with the given trip
+  // counts, from the outermost loop inwards
+  uint64_t getTransferCycles(linalg::LinalgOp op, ArrayRef<int64_t> tile,
+                             ArrayRef<int64_t> counts,
+                             ArrayRef<unsigned> order,
+                             const air::CostModel::TransferParams &params) {
+    uint64_t cycles = 0;
+    for (auto &o : operands) {
+      int last = -1;
+      for (unsigned q = 0; q < order.size(); q++)
+        if (counts[order[q]] > 1 && o.map.isFunctionOfDim(order[q]))
+          last = q;
+      uint64_t fetches = 1;
+      for (int q = 0; q <= last; q++)
+        fetches *= counts[order[q]];
+      uint64_t bytes =
+          air::CostModel::getOperandTileBytes(op, *o.operand, tile);
+      cycles += fetches * o.transfers *
+                air::CostModel::getTransferCycles(
+                    bytes, getRunBytes(o, tile), params);
+    }
+    return cycles;
+  }
+
+  std::optional<LinalgTilingConfig> search(linalg::LinalgOp op,
+                                           bool implicitHerd) {
+    SmallVector<int64_t> trips = op.getStaticLoopRanges();
+    unsigned nLoops = trips.size();
+    if (!nLoops || llvm::any_of(trips, ShapedType::isDynamic))
+      return std::nullopt;
+
+    operands.clear();
+    for (auto &oper : op->getOpOperands()) {
+      auto ty = dyn_cast<MemRefType>(oper.get().getType());
+      auto map = op.getMatchingIndexingMap(&oper);
+      if (!ty || !ty.hasStaticShape() || !map.isProjectedPermutation())
+        return std::nullopt;
+      bool is_init = op.isDpsInit(&oper);
+      unsigned transfers = is_init ? 1 : 0;
+      if (!is_init || op.payloadUsesValueFromOperand(&oper))
+        transfers++;
+      operands.push_back({&oper, map, ty.getShape(),
+                          air::getElementSizeInBytes(ty), transfers});
+    }
+
+    // The herd spans the first two loops if they are parallel
+    auto iterators = op.getIteratorTypesArray();
+    SmallVector<int64_t> herdLimit(nLoops, 1);
+    for (unsigned i = 0; i < std::min(2u, nLoops); i++)
+      if (linalg::isParallelIterator(iterators[i]))
+        herdLimit[i] = maxHerd[i];
+
+    SmallVector<int64_t> ones(nLoops, 1);
+    SmallVector<unsigned> identity(nLoops);
+    std::iota(identity.begin(), identity.end(), 0);
+    SmallVector<SmallVector<unsigned>> orders;
+    if (nLoops <= 4) {
+      auto order = identity;
+      do
+        orders.push_back(order);
+      while (std::next_permutation(order.begin(), order.end()));
+    } else
+      orders.push_back(identity);
+
+    // The L1 tiles fitting in L1, and their compute latency
+    SmallVector<SmallVector<int64_t>> tripDivisors;
+    for (auto t : trips)
+      tripDivisors.push_back(getDivisors(t, t));
+    std::vector<std::pair<SmallVector<int64_t>, uint64_t>> l1Tiles;
+    air::CostModel model;
+    forEachTuple(tripDivisors, [&](ArrayRef<int64_t> t1) {
+      if (getFootprint(op, t1) <= l1Size)
+        l1Tiles.push_back(
+            {SmallVector<int64_t>(t1),
+             model.getLinalgTileCycles(op, t1, computeParams)});
+    });
+
+    SmallVector<SmallVector<int64_t>> l2Choices;
+    if (l2Size)
+      l2Choices = tripDivisors;
+    else
+      for (auto t : trips)
+        l2Choices.push_back({t});
+
+    std::optional<LinalgTilingConfig> best;
+    forEachTuple(l2Choices, [&](ArrayRef<int64_t> t2) {
+      if (l2Size && getFootprint(op, t2) > l2Size)
+        return;
+      SmallVector<int64_t> l2Counts(nLoops);
+      for (unsigned i = 0; i < nLoops; i++)
+        l2Counts[i] = trips[i] / t2[i];
+      uint64_t l2Tiles = std::accumulate(l2Counts.begin(), l2Counts.end(),
+                                         (uint64_t)1, std::multiplies<>());
+      uint64_t l3Cycles =
+          getTransferCycles(op, t2, l2Counts, identity, l3Params);
+
+      SmallVector<SmallVector<int64_t>> herdChoices;
+      for (unsigned i = 0; i < nLoops; i++)
+        herdChoices.push_back(getDivisors(t2[i], herdLimit[i]));
+      forEachTuple(herdChoices, [&](ArrayRef<int64_t> h) {
+        for (auto &[t1, tileCycles] : l1Tiles) {
+          SmallVector<int64_t> l1Counts(nLoops);
+          bool legal = true;
+          for (unsigned i = 0; i < nLoops && legal; i++) {
+            legal = (t2[i] / h[i]) % t1[i] == 0;
+            l1Counts[i] = t2[i] / h[i] / t1[i];
+            if (implicitHerd && i < 2 && l1Counts[i] != 1)
+              legal = false;
+          }
+          if (!legal)
+            continue;
+          uint64_t n1 = std::accumulate(l1Counts.begin(), l1Counts.end(),
+                                        (uint64_t)1, std::multiplies<>());
+          // The first fetch and the last write back are not overlapped
+          uint64_t fill = getTransferCycles(op, t1, ones, identity, l2Params);
+          for (auto &order : orders) {
+            uint64_t dma = getTransferCycles(op, t1, l1Counts, order, l2Params);
+            uint64_t core = std::max(n1 * tileCycles, dma) + fill;
+            uint64_t cycles = l3Cycles + l2Tiles * core;
+            if (best && cycles >= best->cycles)
+              continue;
+            best = LinalgTilingConfig();
+            if (ArrayRef<int64_t>(trips) != t2)
+              best->l2_tile_size.assign(t2.begin(), t2.end());
+            best->herd_size = {h[0], nLoops > 1 ? h[1] : 1};
+            best->l1_tile_size = t1;
+            best->l1_tile_interchange = order;
+            best->cycles = cycles;
+          }
+        }
+      });
+    });
+
+    if (best)
+      LLVM_DEBUG(llvm::outs() << "autotuned " << op->getName() << " to "
+                              << best->cycles << " cycles\n");
+    return best;
+  }
+
+  // A compute tile issuing 8 ops per cycle on vectors of 8 elements, and DMAs
+  // streaming 4 bytes per cycle, with a buffer descriptor setup cost and a
+  // small cost per wrap of the access pattern. L3 transfers lose bandwidth
+  // to partially used bursts.
+  static air::CostModel::ComputeParams getComputeParams() {
+    air::CostModel::ComputeParams params;
+    params.ops_per_cycle = 8;
+    params.vector_lanes = 8;
+    return params;
+  }
+  static air::CostModel::TransferParams getTransferParams(unsigned burst) {
+    air::CostModel::TransferParams params;
+    params.bytes_per_cycle = 4;
+    params.bd_setup_cycles = 32;
+    params.wrap_cycles = 1;
+    params.burst_bytes = burst;
+    return params;
+  }
+  const air::CostModel::ComputeParams computeParams = getComputeParams();
+  const air::CostModel::TransferParams l3Params = getTransferParams(64);
+  const air::CostModel::TransferParams l2Params = getTransferParams(0);
+
+  uint64_t l1Size;
+  uint64_t l2Size;
+  SmallVector<int64_t, 2> maxHerd;
+  std::string cachePath;
+  std::map<std::string, LinalgTilingConfig> cache;
+  bool dirty = false;
+  SmallVector<Operand> operands;
+};
+
 class AIRLinalgCodegen
     : public air::impl::AIRLinalgCodegenBase<AIRLinalgCodegen> {
 
@@ -1328,6 +1696,17 @@ public:
       for (int i = 0, e = std::min(2, (int)clHerdSize.size()); i < e; i++)
         herd_size[i] = clHerdSize[i];
 
+      std::optional<LinalgTilingConfig> tuned;
+      if (autotuner)
+        tuned = autotuner->getConfig(genericOp, /*implicitHerd=*/false);
+      if (tuned) {
+        tileForL2 = !tuned->l2_tile_size.empty();
+        if (tileForL2)
+          l2_tile_size.assign(tuned->l2_tile_size);
+        std::iota(l2_tile_interchange.begin(), l2_tile_interchange.end(), 0);
+        herd_size.assign(tuned->herd_size);
+      }
+
       // outline the operation for convenience
       air::AIROutliner olnr;
       func::CallOp call =
@@ -1373,7 +1752,9 @@ public:
       // compute L1 tile size
 
       called.walk([&](linalg::GenericOp l1_op) {
-        if (clL1TileSize.size())
+        if (tuned)
+          l1_tile_size.assign(tuned->l1_tile_size);
+        else if (clL1TileSize.size())
           for (int i = 0, e = std::min(nLoops, clL1TileSize.size()); i < e; i++)
             l1_tile_size[i] = clL1TileSize[i];
         else if (clL1MaxSize > 0) {
@@ -1385,6 +1766,8 @@ public:
       for (int i = 0, e = std::min(nLoops, clL1TileInterchange.size()); i < e;
            i++)
         l1_tile_interchange[i] = clL1TileInterchange[i];
+      if (tuned)
+        l1_tile_interchange.assign(tuned->l1_tile_interchange);
 
       // tile to the herd size
 
@@ -1530,6 +1913,19 @@ public:
         tileForL2 = true;
       }
 
+      // The herd is formed by the L1 tile loops
+      std::optional<LinalgTilingConfig> tuned;
+      if (autotuner)
+        tuned = autotuner->getConfig(matmulOp, /*implicitHerd=*/true);
+      if (tuned) {
+        l1_tile_size.assign(tuned->l1_tile_size);
+        l1_tile_interchange.assign(tuned->l1_tile_interchange);
+        tileForL2 = !tuned->l2_tile_size.empty();
+        if (tileForL2)
+          l2_tile_size.assign(tuned->l2_tile_size);
+        l2_tile_interchange = {0, 1, 2};
+      }
+
       if (tileForL2) {
         RewritePatternSet stageL2Patterns(ctx);
         stageL2Patterns.insert<TileLinalgOpPattern>(
@@ -1733,13 +2129,25 @@ public:
 
   void runOnOperation() override {
     auto module = getOperation();
+    if (clAutotune && !clLinalgCodegenTestPatterns) {
+      // herd-size bounds the herd shape searched
+      SmallVector<int64_t, 2> maxHerd{4, 4};
+      for (int i = 0, e = std::min(2, (int)clHerdSize.size()); i < e; i++)
+        maxHerd[i] = clHerdSize[i];
+      autotuner = std::make_unique<LinalgTilingAutotuner>(
+          clL1MaxSize, clL2MaxSize, maxHerd, clAutotuneCache);
+    }
     SmallVector<func::FuncOp, 4> funcOps;
     module.walk([&](func::FuncOp op) { funcOps.push_back(op); });
     for (auto f : funcOps)
       runOnFunction(f);
+    if (autotuner)
+      autotuner->save();
+    autotuner.reset();
   }
 
 private:
+  std::unique_ptr<LinalgTilingAutotuner> autotuner;
 };
 
 } // namespace
@@ -12,14 +12,18 @@
 #include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Math/IR/Math.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
 
+#include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/JSON.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <cmath>
+#include <functional>
 #include <map>
 #include <string>
 
@@ -152,6 +156,194 @@ CostModel::getScfForOpCounts(CostModel::OpCountMap &map, scf::ForOp op)
   return;
 }
 
+uint64_t CostModel::getOperandTileBytes(linalg::LinalgOp op, OpOperand &operand,
+                                        ArrayRef<int64_t> tile) {
+  auto ty = llvm::dyn_cast<ShapedType>(operand.get().getType());
+  if (!ty || !ty.hasRank())
+    return getTensorVolume(operand.get().getType());
+  // Extent of each result of the indexing map over the tile; an expression
+  // which is not a sum of scaled loop dims keeps the full operand dimension
+  std::function<int64_t(AffineExpr)> getExtent =
+      [&](AffineExpr e) -> int64_t {
+    if (auto d = dyn_cast<AffineDimExpr>(e))
+      return d.getPosition() < tile.size() ? tile[d.getPosition()] : 1;
+    if (isa<AffineConstantExpr>(e))
+      return 1;
+    if (auto bin = dyn_cast<AffineBinaryOpExpr>(e)) {
+      if (e.getKind() == AffineExprKind::Add) {
+        auto l = getExtent(bin.getLHS());
+        auto r = getExtent(bin.getRHS());
+        return l < 0 || r < 0 ? -1 : l + r - 1;
+      }
+      if (e.getKind() == AffineExprKind::Mul) {
+        auto c = dyn_cast<AffineConstantExpr>(bin.getRHS());
+        auto l = getExtent(bin.getLHS());
+        if (c && l >= 0)
+          return (l - 1) * std::abs(c.getValue()) + 1;
+      }
+    }
+    return -1;
+  };
+  auto map = op.getMatchingIndexingMap(&operand);
+  uint64_t volume = 1;
+  for (unsigned i = 0; i < map.getNumResults(); i++) {
+    int64_t extent = getExtent(map.getResult(i));
+    if (extent < 0 || ty.isDynamicDim(i))
+      extent = ty.getDimSize(i);
+    if (!ty.isDynamicDim(i))
+      extent = std::min(extent, ty.getDimSize(i));
+    volume *= std::max(extent, (int64_t)1);
+  }
+  return volume * (ty.getElementTypeBitWidth() / 8);
+}
+
+double CostModel::getBurstEfficiency(double run_bytes, double burst_bytes) {
+  if (burst_bytes <= 0 || run_bytes <= 0)
+    return 1;
+  return run_bytes / (ceil(run_bytes / burst_bytes) * burst_bytes);
+}
+
+uint64_t CostModel::getDMACycles(double stream_cycles, uint64_t runs,
+                                 double efficiency,
+                                 const TransferParams &params) {
+  double cycles = ceil(stream_cycles / efficiency);
+  cycles += params.bd_setup_cycles;
+  cycles += params.wrap_cycles * (runs - 1);
+  return (uint64_t)cycles;
+}
+
+uint64_t CostModel::getTransferCycles(uint64_t bytes, uint64_t run_bytes,
+                                      const TransferParams &params) {
+  if (!bytes || params.bytes_per_cycle <= 0)
+    return 0;
+  run_bytes = std::max(std::min(run_bytes, bytes), (uint64_t)1);
+  uint64_t runs = llvm::divideCeil(bytes, run_bytes);
+  return getDMACycles(ceil(bytes / params.bytes_per_cycle), runs,
+                      getBurstEfficiency(run_bytes, params.burst_bytes),
+                      params);
+}
+
+bool CostModel::isComputeOp(StringRef name) {
+  static const llvm::StringSet<> cpuops = {
+      math::RsqrtOp::getOperationName(),
+      arith::AddFOp::getOperationName(),
+      arith::SubFOp::getOperationName(),
+      arith::MulFOp::getOperationName(),
+      arith::DivFOp::getOperationName(),
+      arith::TruncFOp::getOperationName(),
+      arith::CmpFOp::getOperationName(),
+      arith::MaximumFOp::getOperationName(),
+      arith::MinimumFOp::getOperationName(),
+      arith::MaxNumFOp::getOperationName(),
+      arith::MinNumFOp::getOperationName(),
+      arith::AddIOp::getOperationName(),
+      arith::SubIOp::getOperationName(),
+      arith::MulIOp::getOperationName(),
+      arith::DivSIOp::getOperationName(),
+      arith::DivUIOp::getOperationName(),
+      arith::TruncIOp::getOperationName(),
+      arith::CmpIOp::getOperationName(),
+      arith::MaxSIOp::getOperationName(),
+      arith::MaxUIOp::getOperationName(),
+      arith::MinSIOp::getOperationName(),
+      arith::MinUIOp::getOperationName(),
+      arith::SelectOp::getOperationName()};
+  return cpuops.contains(name);
+}
+
+uint64_t CostModel::getRooflineCycles(double compute_cycles,
+                                      uint64_t read_bytes,
+                                      uint64_t write_bytes,
+                                      const ComputeParams &params) {
+  double memory_cycles = 0;
+  if (params.read_bytes_per_cycle > 0)
+    memory_cycles = read_bytes / params.read_bytes_per_cycle;
+  if (params.write_bytes_per_cycle > 0)
+    memory_cycles =
+        std::max(memory_cycles, write_bytes / params.write_bytes_per_cycle);
+  return (uint64_t)ceil(std::max(compute_cycles, memory_cycles));
+}
+
+uint64_t CostModel::getLinalgOpCycles(linalg::LinalgOp op,
+                                      const ComputeParams &params) {
+  SmallVector<int64_t> ranges = op.getStaticLoopRanges();
+  if (llvm::any_of(ranges, ShapedType::isDynamic))
+    return 0;
+
+  // Bytes moved between L1 and the core
+  uint64_t read_bytes = 0;
+  uint64_t write_bytes = 0;
+  for (auto &oper : op->getOpOperands()) {
+    bool is_init = op.isDpsInit(&oper);
+    if (!is_init || op.payloadUsesValueFromOperand(&oper))
+      read_bytes += getTensorVolume(oper.get().getType());
+    if (is_init)
+      write_bytes += getTensorVolume(oper.get().getType());
+  }
+  return getLoopNestCycles(op, ranges, read_bytes, write_bytes, params);
+}
+
+uint64_t CostModel::getLinalgTileCycles(linalg::LinalgOp op,
+                                        ArrayRef<int64_t> tile,
+                                        const ComputeParams &params) {
+  uint64_t read_bytes = 0;
+  uint64_t write_bytes = 0;
+  for (auto &oper : op->getOpOperands()) {
+    bool is_init = op.isDpsInit(&oper);
+    if (!is_init || op.payloadUsesValueFromOperand(&oper))
+      read_bytes += getOperandTileBytes(op, oper, tile);
+    if (is_init)
+      write_bytes += getOperandTileBytes(op, oper, tile);
+  }
+  return getLoopNestCycles(op, tile, read_bytes, write_bytes, params);
+}
+
+uint64_t CostModel::getLoopNestCycles(linalg::LinalgOp op,
+                                      ArrayRef<int64_t> ranges,
+                                      uint64_t read_bytes, uint64_t write_bytes,
+                                      const ComputeParams &params) {
+  // Compute ops issued per innermost loop iteration
+  uint64_t payload_ops = 0;
+  op->getRegion(0).walk([&](Operation *o) {
+    if (isComputeOp(o->getName().getStringRef()))
+      payload_ops++;
+  });
+
+  double compute_cycles = 0;
+  double overhead_cycles = 0;
+  if (payload_ops) {
+    double ops_per_cycle = params.ops_per_cycle * params.efficiency;
+    if (ops_per_cycle <= 0)
+      return 0;
+    // Split the iteration space into trips of the innermost loop
+    int64_t inner = ranges.empty() ? 1 : ranges.back();
+    int64_t outer = 1;
+    for (unsigned i = 0; i + 1 < ranges.size(); i++)
+      outer *= ranges[i];
+    compute_cycles = (double)(outer * inner * payload_ops) / ops_per_cycle;
+    // A partially filled vector costs as much as a full one
+    double lanes = params.vector_lanes ? params.vector_lanes
+                                       : ops_per_cycle / payload_ops;
+    double steps = outer * ceil(inner / lanes);
+    if (params.vector_lanes)
+      compute_cycles = steps * lanes * payload_ops / ops_per_cycle;
+    // A reduction along the innermost loop waits on its accumulator at every
+    // vector step
+    auto iterators = op.getIteratorTypesArray();
+    if (!iterators.empty() && linalg::isReductionIterator(iterators.back()))
+      compute_cycles =
+          std::max(compute_cycles, steps * params.accumulator_latency);
+    overhead_cycles = outer * params.loop_overhead_cycles;
+  }
+
+  LLVM_DEBUG(llvm::dbgs() << "roofline " << op->getName() << ": compute "
+                          << compute_cycles << ", overhead " << overhead_cycles
+                          << ", read " << read_bytes << "B, write "
+                          << write_bytes << "B\n");
+  return getRooflineCycles(compute_cycles + overhead_cycles, read_bytes,
+                           write_bytes, params);
+}
+
 CostModel::OpCountMap
 CostModel::getOpCounts(Operation* op)
 {
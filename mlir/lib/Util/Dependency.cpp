@@ -829,6 +829,50 @@ LogicalResult unrollAIRChannelPutGetInScfParallel(OpBuilder builder,
 // Dependency graph
 //===----------------------------------------------------------------------===//
 
+dependencyStringTable::dependencyStringTable() {
+  // in the order of fixedId
+  for (llvm::StringRef str :
+       {"", "start", "AllocOp", "DeallocOp", "ExecuteTerminatorOp"})
+    intern(str);
+}
+
+unsigned dependencyStringTable::intern(llvm::StringRef str) {
+  auto [it, inserted] = ids.try_emplace(str, strings.size());
+  if (inserted)
+    strings.push_back(it->getKey());
+  return it->getValue();
+}
+
+llvm::StringRef dependencyNodeEntry::getColor() const {
+  switch (style) {
+  case graphNodeStyle::hierarchy:
+    return "yellow";
+  case graphNodeStyle::control:
+    return "crimson";
+  case graphNodeStyle::data:
+    return "cyan";
+  case graphNodeStyle::compute:
+    return "chartreuse";
+  case graphNodeStyle::none:
+    return "";
+  }
+  return "";
+}
+
+llvm::StringRef dependencyNodeEntry::getShape() const {
+  switch (style) {
+  case graphNodeStyle::hierarchy:
+  case graphNodeStyle::control:
+    return "box";
+  case graphNodeStyle::data:
+  case graphNodeStyle::compute:
+    return "oval";
+  case graphNodeStyle::none:
+    return "";
+  }
+  return "";
+}
+
 void dependencyCanonicalizer::parseCommandGraphs(func::FuncOp &toplevel,
                                                  dependencyGraph &global_graph,
                                                  dependencyContext &dep_ctx,
@@ -849,6 +893,12 @@ void dependencyCanonicalizer::parseCommandGraphs(func::FuncOp &toplevel,
     return;
   }
 
+  // Index channel puts/gets once, so that finding the other end of each
+  // channel op does not walk the module. Rebuilt on every parse, as the IR may
+  // have changed since the last one.
+  Operation *scope = toplevel->getParentOfType<ModuleOp>();
+  dep_ctx.channel_uses.emplace(scope ? scope : toplevel.getOperation());
+
   // Create vertices for graphs
   // Build up host graph
   toplevel.walk([&](Operation *op) {
@@ -939,7 +989,7 @@ void dependencyCanonicalizer::addVerticesInHerd(
       std::string position_str = "core position: ";
       position_str += toPositionString(current_position);
       current_herd_graph->g[current_herd_graph->start_vertex]
-          .detailed_description = position_str;
+          .setDetailedDescription(dep_ctx.strings, position_str);
 
       herd.walk([&](Operation *herd_childop) {
         if (!dyn_cast<air::HerdOp>(herd_childop)) {
@@ -1015,10 +1065,12 @@ dependencyCanonicalizer::addVertexFromOpImpls(Operation *op, dependencyGraph *G,
   } else if (auto wa_op = dyn_cast<xilinx::air::WaitAllOp>(op)) {
     return addVertexFromWaitAllOp(wa_op, G, dep_ctx);
   } else if (auto forop = dyn_cast<scf::ForOp>(op)) {
-    return addVertexFromOp(op, dep_ctx.ForOpID, "for_loop", "ScfForOp",
+    return addVertexFromOp(op, dep_ctx.ForOpID, asyncEventKind::for_loop,
+                           "ScfForOp",
                            graphNodeProperties("control"), G, dep_ctx);
   } else if (auto parallelop = dyn_cast<scf::ParallelOp>(op)) {
-    return addVertexFromOp(op, dep_ctx.ParallelOpID, "parallel_loop",
+    return addVertexFromOp(op, dep_ctx.ParallelOpID,
+                           asyncEventKind::parallel_loop,
                            "ScfParallelOp", graphNodeProperties("control"), G,
                            dep_ctx);
   } else if (auto hier_op =
@@ -1034,17 +1086,17 @@ dependencyCanonicalizer::addVertexFromOpImpls(Operation *op, dependencyGraph *G,
 
 // Create graph vertex from op
 Graph::VertexId dependencyCanonicalizer::addVertexFromOp(
-    Operation *op, uint64_t &id, std::string event_type, std::string event_name,
-    graphNodeProperties properties, dependencyGraph *G,
+    Operation *op, uint64_t &id, asyncEventKind event_type,
+    std::string event_name, graphNodeProperties properties, dependencyGraph *G,
     dependencyContext &dep_ctx, Operation *pointer_op) {
   op->setAttr("id", mlir::IntegerAttr::get(
                         mlir::IntegerType::get(op->getContext(), 32), ++id));
   auto v = G->g.addVertex();
-  G->g[v].asyncEventName = event_name;
+  G->g[v].setAsyncEventName(dep_ctx.strings, event_name);
   G->g[v].asyncEventType = event_type;
-  G->g[v].color = properties.color;
-  G->g[v].shape = properties.shape;
-  G->g[v].detailed_description = properties.detailed_description;
+  G->g[v].style = properties.style;
+  G->g[v].setDetailedDescription(dep_ctx.strings,
+                                 properties.detailed_description);
   G->g[v].operationId = id;
   if (pointer_op)
     G->g[v].op = pointer_op;
@@ -1062,7 +1114,8 @@ dependencyCanonicalizer::addVertexFromDmaOp(xilinx::air::DmaMemcpyNdOp op,
                                             dependencyGraph *G,
                                             dependencyContext &dep_ctx) {
   if (dyn_cast<xilinx::air::DmaMemcpyNdOp>(op.getOperation())) {
-    return addVertexFromOp(op, dep_ctx.DmaOpID, "dma", "DmaMemcpyNdOp",
+    return addVertexFromOp(op, dep_ctx.DmaOpID, asyncEventKind::dma,
+                           "DmaMemcpyNdOp",
                            graphNodeProperties("data"), G, dep_ctx);
   } else {
     op->emitOpError("unknown dma op");
@@ -1078,7 +1131,7 @@ Graph::VertexId dependencyCanonicalizer::addVertexFromChannelOp(
     std::string memorySpaceSrcStr =
         getMemorySpaceAsString(channel_put.getSrc());
     std::vector<air::ChannelGetOp> channel_gets =
-        getTheOtherChannelOpThroughSymbol(channel_put);
+        dep_ctx.channel_uses->getTheOtherChannelOps(channel_put);
     if (!channel_gets.size())
       op->emitOpError("found channel op not in pairs");
     std::string memorySpaceDstStr =
@@ -1106,7 +1159,8 @@ Graph::VertexId dependencyCanonicalizer::addVertexFromChannelOp(
       }
       detailed_description += "])";
     }
-    return addVertexFromOp(op, dep_ctx.ChannelOpID, "channel", event_name,
+    return addVertexFromOp(op, dep_ctx.ChannelOpID, asyncEventKind::channel,
+                           event_name,
                            graphNodeProperties("data", detailed_description), G,
                            dep_ctx);
   } else if (auto channel_get =
@@ -1114,7 +1168,7 @@ Graph::VertexId dependencyCanonicalizer::addVertexFromChannelOp(
     std::string memorySpaceDstStr =
         getMemorySpaceAsString(channel_get.getDst());
     std::vector<air::ChannelPutOp> channel_puts =
-        getTheOtherChannelOpThroughSymbol(channel_get);
+        dep_ctx.channel_uses->getTheOtherChannelOps(channel_get);
     if (!channel_puts.size())
       op->emitOpError("found channel op not in pairs");
     std::string memorySpaceSrcStr =
@@ -1142,7 +1196,8 @@ Graph::VertexId dependencyCanonicalizer::addVertexFromChannelOp(
       }
       detailed_description += "])";
     }
-    return addVertexFromOp(op, dep_ctx.ChannelOpID, "channel", event_name,
+    return addVertexFromOp(op, dep_ctx.ChannelOpID, asyncEventKind::channel,
+                           event_name,
                            graphNodeProperties("data", detailed_description), G,
                            dep_ctx);
   } else {
@@ -1162,7 +1217,7 @@ Graph::VertexId dependencyCanonicalizer::addVertexFromHierarchyOp(
     detailed_description += "(" + nameAttr.str() + ")";
   if (dyn_cast<xilinx::air::LaunchOp>(op.getOperation())) {
     return addVertexFromOp(
-        op, dep_ctx.HierarchyOpID, "hierarchy", "LaunchOp",
+        op, dep_ctx.HierarchyOpID, asyncEventKind::hierarchy, "LaunchOp",
         graphNodeProperties("hierarchy", detailed_description), G, dep_ctx);
   } else if (auto seg = dyn_cast<xilinx::air::SegmentOp>(op.getOperation())) {
     // Annotate with physical address, if already placed
@@ -1171,7 +1226,7 @@ Graph::VertexId dependencyCanonicalizer::addVertexFromHierarchyOp(
                               std::to_string(*seg.getNumRows()) + "]";
     }
     return addVertexFromOp(
-        op, dep_ctx.HierarchyOpID, "hierarchy", "SegmentOp",
+        op, dep_ctx.HierarchyOpID, asyncEventKind::hierarchy, "SegmentOp",
         graphNodeProperties("hierarchy", detailed_description), G, dep_ctx);
   } else if (auto herd = dyn_cast<xilinx::air::HerdOp>(op.getOperation())) {
     // Annotate with physical address, if already placed
@@ -1180,7 +1235,7 @@ Graph::VertexId dependencyCanonicalizer::addVertexFromHierarchyOp(
                               std::to_string(herd.getNumRows()) + "]";
     }
     return addVertexFromOp(
-        op, dep_ctx.HierarchyOpID, "hierarchy", "HerdOp",
+        op, dep_ctx.HierarchyOpID, asyncEventKind::hierarchy, "HerdOp",
         graphNodeProperties("hierarchy", detailed_description), G, dep_ctx);
   } else {
     op->emitOpError("unknown hierarchy op");
@@ -1193,11 +1248,13 @@ Graph::VertexId dependencyCanonicalizer::addVertexFromTerminatorOp(
   std::string detailed_description = "";
   if (dyn_cast<xilinx::air::LaunchTerminatorOp>(op)) {
     return addVertexFromOp(
-        op, dep_ctx.TerminatorID, "hierarchy_terminator", "LaunchTerminator",
+        op, dep_ctx.TerminatorID, asyncEventKind::hierarchy_terminator,
+        "LaunchTerminator",
         graphNodeProperties("hierarchy", detailed_description), G, dep_ctx);
   } else if (dyn_cast<xilinx::air::SegmentTerminatorOp>(op)) {
     return addVertexFromOp(
-        op, dep_ctx.TerminatorID, "hierarchy_terminator", "SegmentTerminator",
+        op, dep_ctx.TerminatorID, asyncEventKind::hierarchy_terminator,
+        "SegmentTerminator",
         graphNodeProperties("hierarchy", detailed_description), G, dep_ctx);
   } else if (dyn_cast<xilinx::air::HerdTerminatorOp>(op)) {
     // Annotate core id, if showing cores
@@ -1206,7 +1263,8 @@ Graph::VertexId dependencyCanonicalizer::addVertexFromTerminatorOp(
       detailed_description += toPositionString(G->position);
     }
     return addVertexFromOp(
-        op, dep_ctx.TerminatorID, "hierarchy_terminator", "HerdTerminator",
+        op, dep_ctx.TerminatorID, asyncEventKind::hierarchy_terminator,
+        "HerdTerminator",
         graphNodeProperties("hierarchy", detailed_description), G, dep_ctx);
   } else if (isa<scf::YieldOp>(op)) {
     if (getScfParentOpFromYieldOp<scf::ParallelOp>(op)) {
@@ -1216,7 +1274,7 @@ Graph::VertexId dependencyCanonicalizer::addVertexFromTerminatorOp(
       //                        dep_ctx);
     } else if (getScfParentOpFromYieldOp<scf::ForOp>(op)) {
       return addVertexFromOp(
-          op, dep_ctx.TerminatorID, "terminator", "ScfForYieldOp",
+          op, dep_ctx.TerminatorID, asyncEventKind::terminator, "ScfForYieldOp",
           graphNodeProperties("control", detailed_description), G, dep_ctx);
     }
   }
@@ -1227,8 +1285,9 @@ Graph::VertexId dependencyCanonicalizer::addVertexFromTerminatorOp(
 // the ssa value. Hence, here we parse reduce op as a terminator.
 Graph::VertexId dependencyCanonicalizer::addVertexFromReduceOp(
     Operation *op, dependencyGraph *G, dependencyContext &dep_ctx) {
-  return addVertexFromOp(op, dep_ctx.TerminatorID, "terminator", "ScfReduceOp",
-                         graphNodeProperties("control"), G, dep_ctx);
+  return addVertexFromOp(op, dep_ctx.TerminatorID, asyncEventKind::terminator,
+                         "ScfReduceOp", graphNodeProperties("control"), G,
+                         dep_ctx);
 }
 
 Graph::VertexId dependencyCanonicalizer::addVertexFromExecuteOp(
@@ -1248,7 +1307,8 @@ Graph::VertexId dependencyCanonicalizer::addVertexFromExecuteOp(
       } else {
         detailed_description += "(" + to_string(&child_op) + ")";
       }
-      v = addVertexFromOp(&child_op, dep_ctx.ExecuteOpID, "execute", "LinalgOp",
+      v = addVertexFromOp(&child_op, dep_ctx.ExecuteOpID,
+                          asyncEventKind::execute, "LinalgOp",
                           graphNodeProperties("compute", detailed_description),
                           G, dep_ctx, pointer_op);
     } else if (auto alloc_child_op = dyn_cast<memref::AllocOp>(child_op)) {
@@ -1260,7 +1320,8 @@ Graph::VertexId dependencyCanonicalizer::addVertexFromExecuteOp(
       detailed_description += "(" + memorySpaceStr + ", " +
                               std::to_string(getTensorVolume(ty)) + ", " +
                               getElementTypeAsString(ty) + ")";
-      v = addVertexFromOp(&child_op, dep_ctx.ExecuteOpID, "execute", "AllocOp",
+      v = addVertexFromOp(&child_op, dep_ctx.ExecuteOpID,
+                          asyncEventKind::execute, "AllocOp",
                           graphNodeProperties("compute", detailed_description),
                           G, dep_ctx, pointer_op);
     } else if (auto dealloc_child_op = dyn_cast<memref::DeallocOp>(child_op)) {
@@ -1272,27 +1333,30 @@ Graph::VertexId dependencyCanonicalizer::addVertexFromExecuteOp(
       detailed_description += "(" + memorySpaceStr + ", " +
                               std::to_string(getTensorVolume(ty)) + ", " +
                               getElementTypeAsString(ty) + ")";
-      v = addVertexFromOp(&child_op, dep_ctx.ExecuteOpID, "execute",
-                          "DeallocOp",
+      v = addVertexFromOp(&child_op, dep_ctx.ExecuteOpID,
+                          asyncEventKind::execute, "DeallocOp",
                           graphNodeProperties("compute", detailed_description),
                           G, dep_ctx, pointer_op);
     } else if (dyn_cast<memref::CopyOp>(child_op)) {
-      v = addVertexFromOp(&child_op, dep_ctx.ExecuteOpID, "execute", "CopyOp",
+      v = addVertexFromOp(&child_op, dep_ctx.ExecuteOpID,
+                          asyncEventKind::execute, "CopyOp",
                           graphNodeProperties("data"), G, dep_ctx, pointer_op);
     } else if (dyn_cast<xilinx::air::ExecuteTerminatorOp>(child_op)) {
-      v = addVertexFromOp(&child_op, dep_ctx.ExecuteOpID, "execute",
-                          "ExecuteTerminatorOp", graphNodeProperties("compute"),
-                          G, dep_ctx, pointer_op);
+      v = addVertexFromOp(&child_op, dep_ctx.ExecuteOpID,
+                          asyncEventKind::execute, "ExecuteTerminatorOp",
+                          graphNodeProperties("compute"), G, dep_ctx,
+                          pointer_op);
     } else if (isa_and_present<memref::ReshapeOp, memref::ExpandShapeOp,
                                memref::CollapseShapeOp>(child_op)) {
-      v = addVertexFromOp(&child_op, dep_ctx.ExecuteOpID, "execute",
-                          "ReshapeOp", graphNodeProperties("data"), G, dep_ctx,
-                          pointer_op);
+      v = addVertexFromOp(&child_op, dep_ctx.ExecuteOpID,
+                          asyncEventKind::execute, "ReshapeOp",
+                          graphNodeProperties("data"), G, dep_ctx, pointer_op);
       num_non_shape_alt_ops--;
     } else {
-      v = addVertexFromOp(
-          &child_op, dep_ctx.ExecuteOpID, "execute", air::to_string(&child_op),
-          graphNodeProperties("compute"), G, dep_ctx, pointer_op);
+      v = addVertexFromOp(&child_op, dep_ctx.ExecuteOpID,
+                          asyncEventKind::execute, air::to_string(&child_op),
+                          graphNodeProperties("compute"), G, dep_ctx,
+                          pointer_op);
     }
     // Make connections within execute
     if (iter_count > 0)
@@ -1314,49 +1378,50 @@ Graph::VertexId dependencyCanonicalizer::addVertexFromWaitAllOp(
       return 0;
     }
   }
-  return addVertexFromOp(op, dep_ctx.WaitAllOpID, "wait_all", "WaitAllOp",
-                         graphNodeProperties("control"), G, dep_ctx);
+  return addVertexFromOp(op, dep_ctx.WaitAllOpID, asyncEventKind::wait_all,
+                         "WaitAllOp", graphNodeProperties("control"), G,
+                         dep_ctx);
 }
 
 // Get type-id pair from op, which will be used to look up vertex in op_to_v
-std::pair<std::string, unsigned>
+std::pair<asyncEventKind, unsigned>
 dependencyCanonicalizer::getTypeIdPairFromOp(Operation *op) {
-  std::pair<std::string, unsigned> output;
-  std::string type = getOpTypeFromOpImpls(op);
+  std::pair<asyncEventKind, unsigned> output;
+  asyncEventKind type = getOpTypeFromOpImpls(op);
   output.first = type;
   output.second = xilinx::air::getIdAttr(op);
   return output;
 }
 
-std::string dependencyCanonicalizer::getOpTypeFromOpImpls(Operation *op) {
+asyncEventKind dependencyCanonicalizer::getOpTypeFromOpImpls(Operation *op) {
   if (isa<air::DmaMemcpyNdOp>(op)) {
-    return "dma";
+    return asyncEventKind::dma;
   } else if (isa<air::ChannelInterface>(op)) {
-    return "channel";
+    return asyncEventKind::channel;
   } else if (isa<air::WaitAllOp>(op)) {
-    return "wait_all";
+    return asyncEventKind::wait_all;
   } else if (isa<xilinx::air::HierarchyInterface>(op)) {
-    return "hierarchy";
+    return asyncEventKind::hierarchy;
   } else if (isa<scf::ForOp>(op)) {
-    return "for_loop";
+    return asyncEventKind::for_loop;
   } else if (isa<scf::ParallelOp>(op)) {
-    return "parallel_loop";
+    return asyncEventKind::parallel_loop;
   } else if (isa<xilinx::air::LaunchTerminatorOp>(op)) {
-    return "hierarchy_terminator";
+    return asyncEventKind::hierarchy_terminator;
   } else if (isa<xilinx::air::SegmentTerminatorOp>(op)) {
-    return "hierarchy_terminator";
+    return asyncEventKind::hierarchy_terminator;
   } else if (isa<xilinx::air::HerdTerminatorOp>(op)) {
-    return "hierarchy_terminator";
+    return asyncEventKind::hierarchy_terminator;
   } else if (isa<scf::YieldOp>(op)) {
-    return "terminator";
+    return asyncEventKind::terminator;
   } else if (isa<scf::ReduceOp>(op)) {
-    return "terminator";
+    return asyncEventKind::terminator;
   } else {
     if (isa<xilinx::air::ExecuteOp>(op->getParentOp())) {
-      return "execute";
+      return asyncEventKind::execute;
     } else {
       op->emitOpError("unknown op type");
-      return "";
+      return asyncEventKind::none;
     }
   }
 }
@@ -1366,32 +1431,32 @@ std::string dependencyCanonicalizer::getOpTypeFromOpImpls(Operation *op) {
 // in region, while "back" returns the terminator in region.
 std::pair<Graph::VertexId, dependencyGraph *>
 dependencyCanonicalizer::getVertexFromOp(Operation *op,
-                                         dependencyContext dep_ctx,
+                                         const dependencyContext &dep_ctx,
                                          std::string front_or_back) {
-  std::pair<Graph::VertexId, dependencyGraph *> output;
+  std::pair<Graph::VertexId, dependencyGraph *> output = {0, nullptr};
+  std::pair<asyncEventKind, unsigned> entry_pair;
   if (auto execute_op = dyn_cast<xilinx::air::ExecuteOp>(op)) {
     if (front_or_back == "front") {
       auto execute_front_op = execute_op.getChildOp();
-      std::pair<std::string, unsigned> entry_pair =
-          getTypeIdPairFromOp(execute_front_op);
-      output.first = dep_ctx.op_to_v[entry_pair];
-      output.second = dep_ctx.op_to_g[entry_pair];
+      entry_pair = getTypeIdPairFromOp(execute_front_op);
     } else if (front_or_back == "back") {
       auto execute_end_op =
           execute_op.getBody().getBlocks().front().getTerminator();
-      std::pair<std::string, unsigned> entry_pair =
-          getTypeIdPairFromOp(execute_end_op);
-      output.first = dep_ctx.op_to_v[entry_pair];
-      output.second = dep_ctx.op_to_g[entry_pair];
+      entry_pair = getTypeIdPairFromOp(execute_end_op);
     } else {
       op->emitOpError(
           "unknown string operand (only accepts 'front' or 'back')");
+      return output;
     }
   } else {
-    std::pair<std::string, unsigned> entry_pair = getTypeIdPairFromOp(op);
-    output.first = dep_ctx.op_to_v[entry_pair];
-    output.second = dep_ctx.op_to_g[entry_pair];
-  }
+    entry_pair = getTypeIdPairFromOp(op);
+  }
+  auto v_it = dep_ctx.op_to_v.find(entry_pair);
+  if (v_it != dep_ctx.op_to_v.end())
+    output.first = v_it->second;
+  auto g_it = dep_ctx.op_to_g.find(entry_pair);
+  if (g_it != dep_ctx.op_to_g.end())
+    output.second = g_it->second;
   return output;
 }
 
@@ -1421,7 +1486,7 @@ std::vector<Graph::VertexId> dependencyCanonicalizer::getVerticesWithAffineIf(
 
 // Trace dependency of every op in a graph
 void dependencyCanonicalizer::parseDependencyEdgesInGraph(
-    Graph &g, dependencyContext dep_ctx) {
+    Graph &g, const dependencyContext &dep_ctx) {
   auto vp = g.getVertices();
   for (auto vit : vp) {
     auto op = g[vit].op;
@@ -1432,7 +1497,7 @@ void dependencyCanonicalizer::parseDependencyEdgesInGraph(
 }
 
 void dependencyCanonicalizer::connectOpToItsDepListImpls(
-    Operation *op, Graph &g, dependencyContext dep_ctx) {
+    Operation *op, Graph &g, const dependencyContext &dep_ctx) {
   SmallVector<Value, 1> dep_list;
   // air.asyncopinterface
   if (auto async_op = mlir::dyn_cast<xilinx::air::AsyncOpInterface>(op)) {
@@ -1472,7 +1537,7 @@ void dependencyCanonicalizer::connectOpToItsDepListImpls(
 // Connect an async op to ops in its dependency list
 void dependencyCanonicalizer::connectOpToItsDepList(
     Operation *op, SmallVector<Value, 1> dep_list, Graph &g,
-    dependencyContext dep_ctx) {
+    const dependencyContext &dep_ctx) {
   auto dst_v = getVertexFromOp(op, dep_ctx, "front").first;
   if (dep_list.size()) {
     for (auto dep_token : dep_list) {
@@ -1568,7 +1633,7 @@ dependencyCanonicalizer::traceOpFromToken(Operation *op, Value dep_token) {
 void dependencyCanonicalizer::connectTerminatorInGraph(Graph &g) {
   Graph::VertexId terminator_v = 0;
   for (auto vit : g.getVertices()) {
-    if (g[vit].asyncEventType == "hierarchy_terminator") {
+    if (g[vit].asyncEventType == asyncEventKind::hierarchy_terminator) {
       terminator_v = vit;
     }
   }
@@ -1577,7 +1642,7 @@ void dependencyCanonicalizer::connectTerminatorInGraph(Graph &g) {
 
   for (auto vit : g.getVertices()) {
     if ((terminator_v != vit) && !g.outDegree(vit) &&
-        (g[vit].asyncEventType != "start")) {
+        (g[vit].asyncEventType != asyncEventKind::start)) {
       g.addEdge(vit, terminator_v);
     }
   }
@@ -1600,7 +1665,7 @@ void dependencyCanonicalizer::updatePointerFromGraphToHierarchyTerminator(
     dependencyGraph &G) {
   auto vp = G.g.getVertices();
   for (auto v : vp) {
-    if (G.g[v].asyncEventType == "hierarchy_terminator") {
+    if (G.g[v].asyncEventType == asyncEventKind::hierarchy_terminator) {
       G.terminator_vertex = v;
       return;
     }
@@ -1611,7 +1676,7 @@ void dependencyCanonicalizer::updatePointerFromGraphToHierarchyTerminator(
 void dependencyCanonicalizer::updatePointerFromHierarchyTerminatorToGraph(
     dependencyGraph &G, dependencyGraph &subG) {
   for (auto v : subG.g.getVertices()) {
-    if (subG.g[v].asyncEventType == "hierarchy_terminator") {
+    if (subG.g[v].asyncEventType == asyncEventKind::hierarchy_terminator) {
       subG.g[v].nextDependencyGraphs.push_back(&G);
       return;
     }
@@ -1625,7 +1690,7 @@ void dependencyCanonicalizer::updatePointerFromHierarchyOpToGraph(
   std::vector<Graph::VertexId> hier_vs;
   auto vp = G.g.getVertices();
   for (auto v : vp) {
-    if (G.g[v].asyncEventType == "hierarchy") {
+    if (G.g[v].asyncEventType == asyncEventKind::hierarchy) {
       hier_vs.push_back(v);
     }
   }
@@ -1773,13 +1838,15 @@ void dependencyCanonicalizer::fillAIRDepListUsingGraphTR(
     for (auto TRVertex : incoming_deps) {
       auto src_op = graph.g[TRVertex].op;
       if (src_op && op != src_op) { // Avoid dep to itself
-        if (graph.g[TRVertex].asyncEventType == "for_loop") {
+        if (graph.g[TRVertex].asyncEventType == asyncEventKind::for_loop) {
           auto value = dyn_cast<scf::ForOp>(src_op).getRegionIterArgs()[0];
           async_op.addAsyncDependency(value);
-        } else if (graph.g[TRVertex].asyncEventType == "parallel_loop") {
+        } else if (graph.g[TRVertex].asyncEventType ==
+                   asyncEventKind::parallel_loop) {
           auto value = dyn_cast<scf::ParallelOp>(src_op).getInitVals()[0];
           async_op.addAsyncDependency(value);
-        } else if (graph.g[TRVertex].asyncEventType == "terminator") {
+        } else if (graph.g[TRVertex].asyncEventType ==
+                   asyncEventKind::terminator) {
           auto parent_op = src_op->getParentOp();
           auto value = parent_op->getResult(0);
           async_op.addAsyncDependency(value);
@@ -4,6 +4,8 @@
 
 #include "air/Util/DirectedAdjacencyMap.h"
 
+#include <algorithm>
+
 namespace xilinx {
 namespace air {
 
@@ -39,20 +41,45 @@ std::vector<VertexId> DirectedAdjacencyMap::getSchedule() const {
   return schedule;
 }
 
+namespace {
+
+// Insert \p v into the sorted vector \p vs, if not already present.
+void insertSorted(std::vector<VertexId> &vs, VertexId v) {
+  auto it = std::lower_bound(vs.begin(), vs.end(), v);
+  if (it == vs.end() || *it != v) {
+    vs.insert(it, v);
+  }
+}
+
+// Erase \p v from the sorted vector \p vs, if present.
+void eraseSorted(std::vector<VertexId> &vs, VertexId v) {
+  auto it = std::lower_bound(vs.begin(), vs.end(), v);
+  if (it != vs.end() && *it == v) {
+    vs.erase(it);
+  }
+}
+
+} // namespace
+
 void DirectedAdjacencyMap::addEdge(VertexId src, VertexId dst) {
   assert(src < numVertices());
   assert(dst < numVertices());
-  fwdEdges[src].insert(dst);
-  bwdEdges[dst].insert(src);
+  insertSorted(fwdEdges[src], dst);
+  insertSorted(bwdEdges[dst], src);
+}
+
+bool DirectedAdjacencyMap::hasEdge(VertexId src, VertexId dst) const {
+  return src < numVertices() &&
+         std::binary_search(fwdEdges[src].begin(), fwdEdges[src].end(), dst);
 }
 
 void DirectedAdjacencyMap::removeEdge(VertexId src, VertexId dst) {
   if (src >= numVertices() || dst >= numVertices()) {
     return;
   }
-  if (fwdEdges[src].count(dst) > 0) {
-    fwdEdges[src].erase(dst);
-    bwdEdges[dst].erase(src);
+  if (hasEdge(src, dst)) {
+    eraseSorted(fwdEdges[src], dst);
+    eraseSorted(bwdEdges[dst], src);
   }
 }
 
@@ -65,44 +92,77 @@ std::vector<VertexId> DirectedAdjacencyMap::getVertices() const {
   return vs;
 }
 
-std::vector<std::vector<bool>> DirectedAdjacencyMap::getClosure() const {
+std::vector<PackedBitset> DirectedAdjacencyMap::getClosure() const {
 
-  std::vector<std::vector<bool>> closure(
-      numVertices(), std::vector<bool>(numVertices(), false));
+  std::vector<PackedBitset> closure(numVertices(),
+                                    PackedBitset(numVertices()));
 
+  // Rows are completed in reverse topological order, so that the rows of all
+  // successors are final before they are merged into their predecessor's row.
   auto schedule = getSchedule();
   for (uint64_t i = 0; i < numVertices(); ++i) {
     auto vertexId = schedule[numVertices() - i - 1];
-    closure[vertexId][vertexId] = true;
+    closure[vertexId].set(vertexId);
     for (auto nxt : adjacentVertices(vertexId)) {
-      for (uint64_t j = 0; j < numVertices(); ++j) {
-        closure[vertexId][j] = closure[vertexId][j] || closure[nxt][j];
-      }
+      closure[vertexId].unionWith(closure[nxt]);
     }
   }
   return closure;
 }
 
 void DirectedAdjacencyMap::applyTransitiveReduction() {
-  auto closure = getClosure();
-  for (uint64_t i = 0; i < numVertices(); ++i) {
-    std::set<VertexId> reducedEdges;
-    for (auto nxt : adjacentVertices(i)) {
-      bool retain = true;
-      for (auto other : adjacentVertices(i)) {
-        if (nxt == other) {
-          continue;
-        }
-        // if nxt is in the transitive closure of other, don't keep it.
-        if (closure[other][nxt]) {
-          retain = false;
-        }
+
+  // Position of each vertex in a topological order. A vertex can only reach
+  // vertices which are later than itself in this order.
+  auto schedule = getSchedule();
+  std::vector<uint64_t> order(numVertices());
+  for (uint64_t i = 0; i < schedule.size(); ++i) {
+    order[schedule[i]] = i;
+  }
+
+  // visitedBy[u] == v + 1 if u has been reached while reducing the edges of v.
+  std::vector<uint64_t> visitedBy(numVertices(), 0);
+  std::vector<VertexId> successors;
+  std::vector<VertexId> stack;
+
+  for (uint64_t v = 0; v < numVertices(); ++v) {
+    if (fwdEdges[v].size() < 2) {
+      continue;
+    }
+    const uint64_t stamp = v + 1;
+
+    // Visit successors in topological order: a successor can only be implied
+    // by a successor which precedes it in this order.
+    successors = fwdEdges[v];
+    std::sort(successors.begin(), successors.end(),
+              [&](VertexId a, VertexId b) { return order[a] < order[b]; });
+    const uint64_t lastOrder = order[successors.back()];
+
+    std::vector<VertexId> reducedEdges;
+    for (auto nxt : successors) {
+      if (visitedBy[nxt] == stamp) {
+        // nxt is reachable through a retained successor.
+        continue;
       }
-      if (retain) {
-        reducedEdges.insert(nxt);
+      reducedEdges.push_back(nxt);
+      if (order[nxt] == lastOrder) {
+        break;
+      }
+      // Mark everything reachable from nxt which could still be a successor.
+      stack.push_back(nxt);
+      while (!stack.empty()) {
+        auto u = stack.back();
+        stack.pop_back();
+        for (auto w : fwdEdges[u]) {
+          if (visitedBy[w] != stamp && order[w] <= lastOrder) {
+            visitedBy[w] = stamp;
+            stack.push_back(w);
+          }
+        }
       }
     }
-    fwdEdges[i] = reducedEdges;
+    std::sort(reducedEdges.begin(), reducedEdges.end());
+    fwdEdges[v] = std::move(reducedEdges);
   }
   updateBwdEdgesFromFwdEdges();
 }
@@ -112,7 +172,8 @@ void DirectedAdjacencyMap::updateBwdEdgesFromFwdEdges() {
   bwdEdges.resize(numVertices());
   for (uint64_t i = 0; i < numVertices(); ++i) {
     for (auto nxt : fwdEdges[i]) {
-      bwdEdges[nxt].insert(i);
+      // Visiting i in increasing order keeps each bwdEdges vector sorted.
+      bwdEdges[nxt].push_back(i);
     }
   }
 }
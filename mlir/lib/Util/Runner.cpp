@@ -14,6 +14,7 @@
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/Any.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/JSON.h"
@@ -23,6 +24,7 @@
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
 #include "mlir/IR/IntegerSet.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/Support/LogicalResult.h"
@@ -30,8 +32,11 @@
 
 #include <algorithm>
 #include <float.h>
+#include <limits>
 #include <list>
 #include <map>
+#include <memory>
+#include <queue>
 #include <sstream>
 #include <vector>
 
@@ -42,6 +47,7 @@
 #include "./Runner/Resource.cpp"
 #include "./Runner/ResourceHierarchy.cpp"
 #include "./Runner/RunnerNode.cpp"
+#include "./Runner/TraceSink.cpp"
 
 #define DEBUG_TYPE "air-runner"
 
@@ -87,9 +93,22 @@ class AIRRunner::AIRRunner_impl {
 
 public:
   AIRRunner_impl(llvm::raw_ostream &trace_stream, llvm::json::Value &json_model,
-                 std::string sim_granularity = "herd", bool verbose = false)
-      : traceStream(trace_stream), jsonModel(json_model),
-        sim_granularity(sim_granularity) {
+                 std::string sim_granularity = "herd", bool verbose = false,
+                 std::string launch_iterations = "simulate",
+                 std::string trace_format = "json",
+                 std::string trace_filter = "")
+      : trace(createTraceSink(trace_stream, trace_format)),
+        jsonModel(json_model), sim_granularity(sim_granularity),
+        launch_iterations(launch_iterations) {
+
+    // Callers are expected to reject unknown formats up front
+    if (!trace) {
+      llvm::errs() << "error: unknown trace format '" << trace_format
+                   << "' (expected one of " << getTraceFormats()
+                   << "), writing json instead\n";
+      trace = createTraceSink(trace_stream, "json");
+    }
+    trace->setFilter(trace_filter);
 
     auto model = jsonModel.getAsObject();
 
@@ -116,104 +135,26 @@ public:
     LLVM_DEBUG(llvm::dbgs() << "herd slots: " << herd_slots << "\n");
   }
 
-  void emitTraceStart(llvm::raw_ostream &s) { s << "[\n"; }
-
-  void emitTraceEnd(llvm::raw_ostream &s) { s << "{}]\n"; }
-
-  void emitTraceEvent(llvm::raw_ostream &s, std::string name, std::string cat,
-                      std::string ph, std::string ts, int64_t tid,
-                      int64_t pid) {
-    s << "{\n";
-    s << "  \"name\": \"" << name << "\","
-      << "\n";
-    s << "  \"cat\": \"" << cat << "\","
-      << "\n";
-    s << "  \"ph\": \"" << ph << "\","
-      << "\n";
-    s << "  \"ts\": " << ts << ","
-      << "\n";
-    s << "  \"pid\": " << pid << ","
-      << "\n";
-    s << "  \"tid\": " << tid << ","
-      << "\n";
-    s << "  \"args\": "
-      << "{}"
-      << ""
-      << "\n";
-    s << "},\n";
-  }
-
-  void emitTraceMetadataEvent(llvm::raw_ostream &s, std::string item_name,
-                              std::string arg_name, std::string arg_entry,
-                              std::string ph, int64_t pid, int64_t tid = -1) {
-    s << "{\n";
-    s << "  \"name\": \"" << item_name << "\","
-      << "\n";
-    s << "  \"ph\": \"" << ph << "\","
-      << "\n";
-    s << "  \"pid\": " << pid << ","
-      << "\n";
-    if (tid != -1) {
-      s << "  \"tid\": " << tid << ","
-        << "\n";
-    }
-    s << "  \"args\": {\n";
-    s << "    \"" << arg_name << "\": \"" << arg_entry << "\""
-      << "\n";
-    s << "  }\n";
-    s << "},\n";
-  }
+  // Trace is written to the runner's trace stream through the trace sink
+  void emitTraceStart(llvm::raw_ostream &s) { trace->emitStart(); }
+
+  void emitTraceEnd(llvm::raw_ostream &s) { trace->emitEnd(); }
 
   // Model each event's latency
   uint64_t modelOp(device &d, dependencyNodeEntry &c) {
     auto type = c.asyncEventType;
-    auto name = c.asyncEventName;
     uint64_t execution_time = 1;
 
-    if (type == "wait_all") {
+    if (type == asyncEventKind::wait_all) {
       execution_time = 1;
-    } else if (type == "dma") {
-      auto Op = mlir::dyn_cast<xilinx::air::DmaMemcpyNdOp>(c.op);
-      if (!Op)
-        c.op->emitOpError("has mismatching event type").attachNote()
-            << "Has 'dma' as event type, but op isn't of type "
-               "air::DmaMemcpyNdOp";
-      MemRefType srcTy = llvm::cast<MemRefType>(Op.getSrcMemref().getType());
-      MemRefType dstTy = llvm::cast<MemRefType>(Op.getDstMemref().getType());
-      auto srcSpace = srcTy.getMemorySpaceAsInt();
-      auto dstSpace = dstTy.getMemorySpaceAsInt();
-      // if there is a size mismatch, it's because we're moving a tile of the
-      // larger tensor
-      if (getTensorVolume(srcTy) <= getTensorVolume(dstTy))
-        execution_time = getTransferCost(d, c.op, srcSpace, dstSpace, srcTy);
-      else
-        execution_time = getTransferCost(d, c.op, srcSpace, dstSpace, dstTy);
-    } else if (type == "channel" &&
-               (name.find("ChannelGetOp") != std::string::npos)) {
-      auto getOp = mlir::dyn_cast<xilinx::air::ChannelGetOp>(c.op);
-      if (!getOp)
-        c.op->emitOpError("has mismatching event type").attachNote()
-            << "Has 'channel' as event type, but op isn't of type "
-               "air::ChannelGetOp";
-      MemRefType dstTy = llvm::cast<MemRefType>(getOp.getDst().getType());
-      std::vector<air::ChannelPutOp> putOps =
-          air::getTheOtherChannelOpThroughSymbol(getOp);
-      if (!putOps.size())
-        getOp->emitOpError("found no put op for air::ChannelGetOp");
-      MemRefType srcTy = llvm::cast<MemRefType>(putOps[0].getSrc().getType());
-      auto srcSpace = srcTy.getMemorySpaceAsInt();
-      auto dstSpace = dstTy.getMemorySpaceAsInt();
-      auto srcVolumn = getTransferVolumn(putOps[0]);
-      auto dstVolumn = getTransferVolumn(getOp);
-      // if there is a size mismatch, it's because we're moving a tile of the
-      // larger tensor
-      if (srcVolumn <= dstVolumn)
-        execution_time =
-            getTransferCost(d, c.op, srcSpace, dstSpace, srcVolumn, srcTy);
-      else
-        execution_time =
-            getTransferCost(d, c.op, srcSpace, dstSpace, dstVolumn, dstTy);
-    } else if (type == "execute" && name != "ExecuteTerminatorOp") {
+    } else if (auto xfer = getTransferFootprint(c)) {
+      auto [srcSpace, dstSpace, volume, ty] = *xfer;
+      execution_time = getTransferCost(d, c.op, srcSpace, dstSpace, volume, ty);
+      execution_time = getAccessPatternCost(d, getTransferAccessPatterns(c),
+                                            execution_time, volume, ty);
+    } else if (type == asyncEventKind::execute &&
+               c.asyncEventNameId !=
+                   dependencyStringTable::executeTerminatorOpId) {
       if (!isa<air::ExecuteOp>(c.op))
         c.op->emitOpError("has mismatching event type").attachNote()
             << "Has 'execute' as event type, but op isn't of type "
@@ -224,7 +165,10 @@ public:
         uint64_t compute_op_cost = getComputeCostFromCostModel(d, child_op);
         execution_time = std::max(compute_op_cost, compute_xfer_cost);
       } else if (auto custom_op = dyn_cast<air::CustomOp>(child_op)) {
-        execution_time = getComputeCostFromJSON(d, custom_op);
+        if (auto cost = getComputeCostFromAttrs(d, custom_op))
+          execution_time = *cost;
+        else
+          execution_time = getComputeCostFromJSON(d, custom_op);
       }
     } else {
       LLVM_DEBUG(llvm::dbgs()
@@ -235,17 +179,32 @@ public:
     return execution_time;
   }
 
-  bool processGraph(runnerNode &c, device &device_resource_node,
+  // Execute the runner node's wavefront only if one of its completion events
+  // has come due, and check its candidates only if that changed its own state
+  // or if shared state has changed since they were last found blocked
+  void processGraph(runnerNode &c, device &device_resource_node,
                     uint64_t time) {
 
+    c.getParentLaunchRunner()->popDueCompletionEvents(time);
+    bool due = c.takeDueCompletions();
+    if (!due && !c.hasStaleBlockedCandidates())
+      return;
+
     LLVM_DEBUG(llvm::dbgs() << "\nNEW TIME STAMP @" << time - 1 << " runner "
                             << air::to_string(c.ctrl_g->hierarchyOp) << " loc "
                             << air::to_string(c.ctrl_g->position) << "'\n");
 
-    executeOpsFromWavefrontAndFreeResource(c, device_resource_node, time);
+    if (due)
+      executeOpsFromWavefrontAndFreeResource(c, device_resource_node, time);
     pushOpsToWavefrontAndAllocateResource(c, device_resource_node, time);
+  }
 
-    return !c.wavefront.empty();
+  // Check the runner node's candidates again, if updates to shared state may
+  // have unblocked them
+  void recheckBlockedCandidates(runnerNode &c, device &device_resource_node,
+                                uint64_t time) {
+    if (c.hasStaleBlockedCandidates())
+      pushOpsToWavefrontAndAllocateResource(c, device_resource_node, time);
   }
 
   void executeOpsFromWavefrontAndFreeResource(runnerNode &c,
@@ -258,7 +217,8 @@ public:
     // Note: Reason for sorting the wavefront is because executing terminator
     // event may change the execution status of other ops on wavefront
     for (int i = c.wavefront.size() - 1; i >= 0; i--) {
-      if (G[std::get<0>(c.wavefront[i])].asyncEventType == "terminator") {
+      if (G[std::get<0>(c.wavefront[i])].asyncEventType ==
+          asyncEventKind::terminator) {
         moveItemToBack<
             std::tuple<Graph::VertexId, std::vector<resource *>, unsigned>>(
             c.wavefront, i);
@@ -269,18 +229,21 @@ public:
       if (G[std::get<0>(*it)].is_started() &&
           G[std::get<0>(*it)].is_done(time)) {
 
-        if (G[std::get<0>(*it)].asyncEventType != "start") {
+        if (G[std::get<0>(*it)].asyncEventType != asyncEventKind::start) {
 
-          auto runner_id = getIdAttr(c.ctrl_g->hierarchyOp);
-          auto tid = std::get<2>(*it);
-          emitTraceEvent(traceStream,
-                         G[std::get<0>(*it)].asyncEventName +
-                             G[std::get<0>(*it)].detailed_description,
-                         "layer", "E",
-                         convertToTimeStampInStr(time, device_resource_node),
-                         tid, runner_id);
+          auto &node = G[std::get<0>(*it)];
+          if (trace->accepts(c.runner_node_type, node.asyncEventType)) {
+            auto runner_id = getIdAttr(c.ctrl_g->hierarchyOp);
+            auto tid = std::get<2>(*it);
+            trace->emitEvent(
+                trace->internEventName(node, dep_ctx.strings), "layer", "E",
+                convertToTimeStampInNs(time, device_resource_node), tid,
+                runner_id);
+          }
         }
 
+        finishTransferOnSharedLink(c, std::get<0>(*it), time);
+
         // "ExecuteOp"
         c.executeOpImpls(std::get<0>(*it), time);
 
@@ -288,17 +251,19 @@ public:
         c.consumeLoopYieldedTokens(std::get<0>(*it));
 
         // Erase from wavefront
+        c.retireFromWavefront(std::get<0>(*it));
         c.wavefront.erase(it);
         it--;
       }
     }
   }
 
-  bool pushOpsToWavefrontAndAllocateResource(runnerNode &c,
+  void pushOpsToWavefrontAndAllocateResource(runnerNode &c,
                                              device &device_resource_node,
                                              uint64_t time) {
 
     Graph &G = c.ctrl_g->g;
+    c.beginReadinessCheck();
 
     // Get candidate vertices to be pushed to wavefront
     std::vector<Graph::VertexId> next_vertex_set_candidates =
@@ -331,12 +296,14 @@ public:
     }
 
     // Check resource fulfillment of each candidate
+    unsigned pushed = 0;
     for (auto next_vertex : next_vertex_set) {
 
       // Check whether adj_v's resource requirement has been fulfilled.
       bool res_fulfilled = c.checkResourceFulfillmentForOpImpls(G[next_vertex]);
 
       if (res_fulfilled) {
+        pushed++;
         // Delete vertex from latent wavefront candidates
         c.removeVertexFromVertices(c.latent_wavefront_candidates, next_vertex);
         // Push to wavefront; check for sim. granularity
@@ -347,18 +314,203 @@ public:
         G[next_vertex].start_time = time;
         G[next_vertex].end_time =
             time + modelOp(device_resource_node, G[next_vertex]);
+        startTransferOnSharedLink(c, next_vertex, device_resource_node, time);
+        c.pushCompletionEvent(next_vertex);
         // emit trace event begin
-        auto runner_id = getIdAttr(c.ctrl_g->hierarchyOp);
-        auto tid = std::get<2>(c.wavefront.back());
-        emitTraceEvent(
-            traceStream,
-            G[next_vertex].asyncEventName + G[next_vertex].detailed_description,
-            "layer", "B", convertToTimeStampInStr(time, device_resource_node),
-            tid, runner_id);
+        if (trace->accepts(c.runner_node_type,
+                           G[next_vertex].asyncEventType)) {
+          auto runner_id = getIdAttr(c.ctrl_g->hierarchyOp);
+          auto tid = std::get<2>(c.wavefront.back());
+          trace->emitEvent(
+              trace->internEventName(G[next_vertex], dep_ctx.strings), "layer",
+              "B", convertToTimeStampInNs(time, device_resource_node), tid,
+              runner_id);
+        }
       }
     }
 
-    return c.wavefront.size() > 0;
+    c.endReadinessCheck(pushed < next_vertex_set_candidates.size());
+  }
+
+  // Register a dma or channel get event, which has just been pushed to
+  // wavefront with its uncontended end time, as a transfer on the shared links
+  // it occupies. Transfers in flight on those links are re-timed to their fair
+  // share of each link's bandwidth, and end once their slowest link has
+  // served them.
+  void startTransferOnSharedLink(runnerNode &c, Graph::VertexId v,
+                                 device &device_resource_node, uint64_t time) {
+    auto xfer = getTransferFootprint(c.ctrl_g->g[v]);
+    if (!xfer)
+      return;
+    auto [srcSpace, dstSpace, volume, ty] = *xfer;
+    auto interface = device_resource_node.interfaces[{srcSpace, dstSpace}];
+    if (!interface)
+      return;
+    // Drop any stale transfer left by an earlier run of this vertex
+    finishTransferOnSharedLink(c, v, time);
+    std::vector<port *> links = {interface};
+    getSharedLinksOfTransfer(c, v, srcSpace, dstSpace, links);
+    auto &node = c.ctrl_g->g[v];
+    uint64_t start_time = node.start_time;
+    uint64_t cycles = node.end_time - start_time;
+    double bytes =
+        volume * device_resource_node.datatypes[getElementTypeAsString(ty)];
+    // End time of the transfer on each of its links
+    auto end_times =
+        std::make_shared<std::vector<uint64_t>>(links.size(), node.end_time);
+    auto g = c.ctrl_g;
+    auto &transfer = transfers_in_flight[{g, v}];
+    for (unsigned i = 0; i < links.size(); i++) {
+      auto retime = [g, v, start_time, end_times, i](uint64_t t) {
+        (*end_times)[i] = t;
+        uint64_t end_time =
+            *std::max_element(end_times->begin(), end_times->end());
+        auto &entry = g->g[v];
+        auto runner = g->runner_node;
+        if (entry.start_time != start_time || entry.end_time == end_time ||
+            !runner->isOnWavefront(v))
+          return;
+        entry.end_time = end_time;
+        runner->pushCompletionEvent(v);
+      };
+      unsigned id = links[i]->add_transfer(time, cycles, bytes,
+                                           interface->data_rate, retime);
+      transfer.push_back({links[i], id});
+    }
+  }
+
+  // Get the shared links which a transfer occupies besides the one between its
+  // memory spaces: those of the ports it holds, i.e. of the tile, du or device
+  // owning each port, and of the column of each tile. Each port held counts
+  // as one transfer. A channel get holds its inbound ports, each paired with
+  // an outbound port held by the channel's puts. A dma holds no port, and
+  // occupies the links of its runner node's resource hierarchies instead.
+  void getSharedLinksOfTransfer(runnerNode &c, Graph::VertexId v,
+                                unsigned srcSpace, unsigned dstSpace,
+                                std::vector<port *> &links) {
+    auto addLinks = [&](port *p) {
+      links.insert(links.end(), p->shared_links.begin(), p->shared_links.end());
+    };
+    auto &node = c.ctrl_g->g[v];
+    if (auto getOp = dyn_cast<air::ChannelGetOp>(node.op)) {
+      auto put_ports = c.getParentLaunchRunner()->getChannelPortsInUse(
+          getOp.getChanName().str(), "put");
+      for (auto &entry : c.wavefront) {
+        if (std::get<0>(entry) != v)
+          continue;
+        auto &get_ports = std::get<1>(entry);
+        for (unsigned i = 0; i < get_ports.size(); i++) {
+          addLinks(static_cast<port *>(get_ports[i]));
+          if (put_ports.size())
+            addLinks(put_ports[i % put_ports.size()]);
+        }
+      }
+      return;
+    }
+    unsigned space = 0;
+    if (c.runner_node_type == "herd")
+      space = lookUpMemorySpaceIntFromString("L1");
+    else if (c.runner_node_type == "segment")
+      space = lookUpMemorySpaceIntFromString("L2");
+    else
+      space = lookUpMemorySpaceIntFromString("L3");
+    for (auto hier : c.resource_hiers) {
+      if (space == srcSpace && hier->links.count("outbound"))
+        links.push_back(hier->links["outbound"]);
+      if (space == dstSpace && hier->links.count("inbound"))
+        links.push_back(hier->links["inbound"]);
+    }
+  }
+
+  // Remove a finished transfer from its links, re-timing the transfers which
+  // remain in flight on them
+  void finishTransferOnSharedLink(runnerNode &c, Graph::VertexId v,
+                                  uint64_t time) {
+    auto it = transfers_in_flight.find({c.ctrl_g, v});
+    if (it == transfers_in_flight.end())
+      return;
+    auto transfer = std::move(it->second);
+    transfers_in_flight.erase(it);
+    for (auto [link, id] : transfer)
+      link->remove_transfer(time, id);
+  }
+
+  // Remove the transfers left in flight once a launch stops, before its runner
+  // nodes go away
+  void abandonTransfersOnSharedLinks(uint64_t time) {
+    while (!transfers_in_flight.empty()) {
+      auto transfer = std::move(transfers_in_flight.begin()->second);
+      transfers_in_flight.erase(transfers_in_flight.begin());
+      for (auto [link, id] : transfer)
+        link->remove_transfer(time, id);
+    }
+  }
+
+  // Report bytes moved, busy time, peak concurrency and bandwidth utilization
+  // of each link which carried transfers
+  void reportLinkUtilization(device &d, uint64_t time) {
+    double seconds = d.clock ? (double)time / d.clock : 0;
+    bool header = true;
+    for (auto &[spaces, link] : d.interfaces) {
+      if (!link->bytes_served)
+        continue;
+      if (header)
+        std::cout << "Link utilization:\n";
+      header = false;
+      double capacity =
+          link->shared_data_rate ? link->shared_data_rate : link->data_rate;
+      double utilization =
+          capacity && seconds ? link->bytes_served / (capacity * seconds) : 0;
+      std::cout << "  " << lookUpMemorySpaceFromInt(spaces.first) << "-->"
+                << lookUpMemorySpaceFromInt(spaces.second) << ": "
+                << (uint64_t)link->bytes_served
+                << " bytes, busy " << link->busy_cycles << " cycles, peak "
+                << link->peak_transfers << " transfers, utilization "
+                << utilization * 100 << "%\n";
+    }
+  }
+
+  // Whether a value can change what is simulated: it has a use other than
+  // as a kernel operand of a nested hierarchy op whose argument is unused
+  static bool hasSimulatedUses(Value v) {
+    for (auto &use : v.getUses()) {
+      auto hier = dyn_cast<air::HierarchyInterface>(use.getOwner());
+      if (!hier)
+        return true;
+      bool isKernelOperand = false;
+      for (unsigned i = 0; i < hier.getNumKernelOperands(); i++) {
+        if (hier.getKernelOperand(i) != v)
+          continue;
+        isKernelOperand = true;
+        if (hasSimulatedUses(hier.getKernelArgument(i)))
+          return true;
+      }
+      if (!isKernelOperand)
+        return true;
+    }
+    return false;
+  }
+
+  // Bytes served and busy cycles of each link of a device
+  std::vector<std::pair<double, uint64_t>> getLinkCounters(device &d) {
+    std::vector<std::pair<double, uint64_t>> counters;
+    for (auto &[spaces, link] : d.interfaces)
+      counters.emplace_back(link->bytes_served, link->busy_cycles);
+    return counters;
+  }
+
+  // Add the traffic of the launch iteration simulated since the counters were
+  // taken to each link, once per replayed iteration
+  void
+  scaleLinkCounters(device &d,
+                    const std::vector<std::pair<double, uint64_t>> &counters,
+                    int64_t replayed) {
+    unsigned i = 0;
+    for (auto &[spaces, link] : d.interfaces) {
+      auto [bytes, cycles] = counters[i++];
+      link->bytes_served += replayed * (link->bytes_served - bytes);
+      link->busy_cycles += replayed * (link->busy_cycles - cycles);
+    }
   }
 
   void scheduleFunction(func::FuncOp &toplevel) {
@@ -370,6 +522,11 @@ public:
     canonicalizer.parseCommandGraphs(toplevel, hostGraph, dep_ctx,
                                      sim_granularity);
 
+    // Index channel puts and gets once; the IR is not mutated while simulating
+    Operation *scope = toplevel->getParentOfType<ModuleOp>();
+    channel_uses = std::make_unique<air::ChannelUseAnalysis>(
+        scope ? scope : toplevel.getOperation());
+
     // Walk the launch graph and write process name metadata in trace
     writeTraceMetadataProcNames(hostGraph);
 
@@ -390,8 +547,33 @@ public:
         iter_count *= s;
       }
 
+      // In replay mode, only the first iteration is simulated; the rest are
+      // assumed to be identical and serialized behind it. Iterations differ
+      // when the launch body depends on the launch induction variables, so
+      // those launches are simulated in full.
+      bool replay = launch_iterations == "replay" &&
+                    llvm::none_of(launch_op.getIds(), [](Value iv) {
+                      return hasSimulatedUses(iv);
+                    });
+      if (launch_iterations == "replay" && !replay)
+        LLVM_DEBUG(llvm::dbgs() << "launch depends on its induction "
+                                   "variables; simulating every iteration\n");
+
+      uint64_t launch_start_time = time;
+      auto link_counters = getLinkCounters(device_resource_node);
       for (unsigned i = 0; i < iter_count; i++) {
 
+        if (i == 1 && replay) {
+          uint64_t replayed_latency = time - launch_start_time;
+          LLVM_DEBUG(llvm::dbgs() << "replaying " << iter_count - 1
+                                  << " launch iterations of latency "
+                                  << replayed_latency << "\n");
+          time += (iter_count - 1) * replayed_latency;
+          scaleLinkCounters(device_resource_node, link_counters,
+                            iter_count - 1);
+          break;
+        }
+
         // Reset controllers
         launch_runner_node = runnerNode(nullptr, &launchGraph, "launch",
                                         &dep_ctx, sim_granularity);
@@ -409,6 +591,7 @@ public:
     // Simulation performance report
     std::string end_ts = convertToTimeStampInStr(time, device_resource_node);
     std::cout << "Latency: " << end_ts << "us\n";
+    reportLinkUtilization(device_resource_node, time);
   }
 
   void scheduleLaunch(runnerNode &launch, device &device_resource_node,
@@ -416,7 +599,7 @@ public:
 
     auto start_v = launch.ctrl_g->start_vertex;
     // Reset launch graph
-    launch.processed_vertices.clear();
+    launch.clearProcessedVertices();
     launch.resetGraphBetweenTwoVertices(
         start_v, launch.ctrl_g->terminator_vertex, launch.ctrl_g->g, time);
     // Start running launch
@@ -431,58 +614,52 @@ public:
     while (running) {
       LLVM_DEBUG(llvm::dbgs() << "time: " << time << "\n");
 
-      running = false;
-      std::vector<uint64_t> next_times;
-
-      running |= processGraph(launch, device_resource_node, time);
+      processGraph(launch, device_resource_node, time);
 
       for (auto &segment_runner_node : launch.sub_runner_nodes) {
-        running |=
-            processGraph(segment_runner_node, device_resource_node, time);
+        processGraph(segment_runner_node, device_resource_node, time);
         for (auto &herd_runner_node : segment_runner_node.sub_runner_nodes) {
-          running |= processGraph(herd_runner_node, device_resource_node, time);
+          processGraph(herd_runner_node, device_resource_node, time);
         }
       }
 
       // Check event readiness again after updates to resource allocation
-      running |= pushOpsToWavefrontAndAllocateResource(
-          launch, device_resource_node, time);
+      recheckBlockedCandidates(launch, device_resource_node, time);
 
       for (auto &segment_runner_node : launch.sub_runner_nodes) {
-        running |= pushOpsToWavefrontAndAllocateResource(
-            segment_runner_node, device_resource_node, time);
+        recheckBlockedCandidates(segment_runner_node, device_resource_node,
+                                 time);
         for (auto &herd_runner_node : segment_runner_node.sub_runner_nodes) {
-          running |= pushOpsToWavefrontAndAllocateResource(
-              herd_runner_node, device_resource_node, time);
+          recheckBlockedCandidates(herd_runner_node, device_resource_node,
+                                   time);
         }
       }
 
-      if (running) {
-        launch.getTimeStampsFromWavefront(next_times);
-        for (auto &segment_runner_node : launch.sub_runner_nodes) {
-          segment_runner_node.getTimeStampsFromWavefront(next_times);
-          for (auto &herd_runner_node : segment_runner_node.sub_runner_nodes) {
-            herd_runner_node.getTimeStampsFromWavefront(next_times);
-          }
-        }
-      }
-
-      uint64_t next_time = 0;
-      if (next_times.size())
-        next_time = *std::min_element(next_times.begin(), next_times.end());
+      // Step to the next cycle to execute the events which came due during
+      // this step, else jump straight to the next completion event. Nothing
+      // can change once no event is pending.
+      launch.popDueCompletionEvents(time);
+      uint64_t next_time = launch.hasDueCompletions()
+                               ? time + 1
+                               : launch.getNextCompletionTime();
+      running = next_time != 0;
       time = std::max(time + 1, next_time);
       if (time > 5000000000)
         running = false;
     }
+    abandonTransfersOnSharedLinks(time);
   }
 
 private:
   dependencyCanonicalizer canonicalizer;
   xilinx::air::dependencyContext dep_ctx;
 
-  llvm::raw_ostream &traceStream;
+  std::unique_ptr<traceSink> trace;
   llvm::json::Value &jsonModel;
   std::string sim_granularity;
+  // Simulate every launch iteration ("simulate"), or simulate the first one
+  // and extrapolate the rest from its latency ("replay")
+  std::string launch_iterations;
 
   unsigned dispatch_slots;
   unsigned dispatch_dma_slots;
@@ -495,6 +672,16 @@ private:
   // Host and segment runnerNodes
   runnerNode launch_runner_node;
 
+  // Channel put/get lookup by symbol
+  std::unique_ptr<air::ChannelUseAnalysis> channel_uses;
+
+  // Transfers in flight on shared links. Key: dependency graph and vertex of
+  // the dma or channel get event; mapped: link port and transfer id on each
+  // link the transfer occupies.
+  std::map<std::pair<dependencyGraph *, Graph::VertexId>,
+           std::vector<std::pair<port *, unsigned>>>
+      transfers_in_flight;
+
   //===----------------------------------------------------------------------===//
   // Trace helper functions
   //===----------------------------------------------------------------------===//
@@ -503,12 +690,13 @@ private:
   void writeTraceMetadataProcNames(dependencyGraph &hostGraph) {
     for (auto &launchGraph : hostGraph.subgraphs) {
       // Write launch process name to trace metadata
-      emitTraceMetadataEvent(traceStream, "process_name", "name",
-                             air::to_string(launchGraph.hierarchyOp), "M",
-                             getIdAttr(launchGraph.hierarchyOp));
-      emitTraceMetadataEvent(traceStream, "process_sort_index", "sort_index",
-                             std::to_string(getIdAttr(launchGraph.hierarchyOp)),
-                             "M", getIdAttr(launchGraph.hierarchyOp));
+      trace->emitMetadataEvent("process_name", "name",
+                               air::to_string(launchGraph.hierarchyOp),
+                               getIdAttr(launchGraph.hierarchyOp));
+      trace->emitMetadataEvent(
+          "process_sort_index", "sort_index",
+          std::to_string(getIdAttr(launchGraph.hierarchyOp)),
+          getIdAttr(launchGraph.hierarchyOp));
       for (auto &segmentGraph : launchGraph.subgraphs) {
         // Write segment process name to trace metadata
         std::string seg_process_info = "";
@@ -516,11 +704,11 @@ private:
         seg_process_info += air::to_string(seg);
         seg_process_info += "[" + std::to_string(*seg.getNumCols()) + ", " +
                             std::to_string(*seg.getNumRows()) + "]";
-        emitTraceMetadataEvent(traceStream, "process_name", "name",
-                               seg_process_info, "M", getIdAttr(seg));
-        emitTraceMetadataEvent(traceStream, "process_sort_index", "sort_index",
-                               std::to_string(getIdAttr(seg)), "M",
-                               getIdAttr(seg));
+        trace->emitMetadataEvent("process_name", "name", seg_process_info,
+                                 getIdAttr(seg));
+        trace->emitMetadataEvent("process_sort_index", "sort_index",
+                                 std::to_string(getIdAttr(seg)),
+                                 getIdAttr(seg));
         for (auto &herdGraph : segmentGraph.subgraphs) {
           // Only write herd process name metadata once per herd
           bool print_pid_metadata_for_herd = true;
@@ -541,11 +729,11 @@ private:
             herd_process_info += air::to_string(herd);
             herd_process_info += "[" + std::to_string(herd.getNumCols()) +
                                  ", " + std::to_string(herd.getNumRows()) + "]";
-            emitTraceMetadataEvent(traceStream, "process_name", "name",
-                                   herd_process_info, "M", getIdAttr(herd));
-            emitTraceMetadataEvent(
-                traceStream, "process_sort_index", "sort_index",
-                std::to_string(getIdAttr(herd)), "M", getIdAttr(herd));
+            trace->emitMetadataEvent("process_name", "name",
+                                     herd_process_info, getIdAttr(herd));
+            trace->emitMetadataEvent("process_sort_index", "sort_index",
+                                     std::to_string(getIdAttr(herd)),
+                                     getIdAttr(herd));
           }
           if (print_tid_metadata_for_core) {
             // Write herd process name to trace metadata
@@ -557,16 +745,16 @@ private:
                                    herdGraph.position, herdGraph.hierarchyOp) *
                                    max_num_threads_per_core +
                                1;
-            emitTraceMetadataEvent(traceStream, "thread_name", "name",
-                                   thread_name, "M",
-                                   getIdAttr(herdGraph.hierarchyOp), core_id);
+            trace->emitMetadataEvent("thread_name", "name", thread_name,
+                                     getIdAttr(herdGraph.hierarchyOp),
+                                     core_id);
             // Iteratively write thread sort index for every possible thread in
             // a core
             for (unsigned i = 0; i < max_num_threads_per_core; i++) {
-              emitTraceMetadataEvent(traceStream, "thread_sort_index",
-                                     "sort_index", std::to_string(core_id + i),
-                                     "M", getIdAttr(herdGraph.hierarchyOp),
-                                     core_id + i);
+              trace->emitMetadataEvent(
+                  "thread_sort_index", "sort_index",
+                  std::to_string(core_id + i),
+                  getIdAttr(herdGraph.hierarchyOp), core_id + i);
             }
           }
         }
@@ -574,10 +762,15 @@ private:
     }
   }
 
+  // Convert time from cycle count to ns
+  uint64_t convertToTimeStampInNs(uint64_t time, device &d) {
+    return (uint64_t)std::round(((double)time) /
+                                (1000000000.0 / (double)d.clock));
+  }
+
   // Convert time from cycle count to time stamp in ms (with 3 d.p.)
   std::string convertToTimeStampInStr(uint64_t time, device &d) {
-    uint64_t time_in_ns =
-        (uint64_t)std::round(((double)time) / (1000000000.0 / (double)d.clock));
+    uint64_t time_in_ns = convertToTimeStampInNs(time, d);
     uint64_t int_part = (uint64_t)(time_in_ns / 1000);
     uint64_t frac_part = (uint64_t)(time_in_ns % 1000);
     std::string zero_fill = "";
@@ -593,6 +786,130 @@ private:
   // Latency estimation helper functions
   //===----------------------------------------------------------------------===//
 
+  // Get the source and destination memory spaces, the volume and the element
+  // type of the data moved by a dma or channel get event. Returns std::nullopt
+  // for any other event.
+  std::optional<std::tuple<unsigned, unsigned, int64_t, mlir::Type>>
+  getTransferFootprint(dependencyNodeEntry &c) {
+    auto type = c.asyncEventType;
+    if (type == asyncEventKind::dma) {
+      auto Op = mlir::dyn_cast<xilinx::air::DmaMemcpyNdOp>(c.op);
+      if (!Op)
+        c.op->emitOpError("has mismatching event type").attachNote()
+            << "Has 'dma' as event type, but op isn't of type "
+               "air::DmaMemcpyNdOp";
+      MemRefType srcTy = llvm::cast<MemRefType>(Op.getSrcMemref().getType());
+      MemRefType dstTy = llvm::cast<MemRefType>(Op.getDstMemref().getType());
+      auto srcSpace = srcTy.getMemorySpaceAsInt();
+      auto dstSpace = dstTy.getMemorySpaceAsInt();
+      // if there is a size mismatch, it's because we're moving a tile of the
+      // larger tensor
+      if (getTensorVolume(srcTy) <= getTensorVolume(dstTy))
+        return std::make_tuple(srcSpace, dstSpace,
+                               (int64_t)getTensorVolume(srcTy), (Type)srcTy);
+      return std::make_tuple(srcSpace, dstSpace,
+                             (int64_t)getTensorVolume(dstTy), (Type)dstTy);
+    } else if (type == asyncEventKind::channel &&
+               isa<xilinx::air::ChannelGetOp>(c.op)) {
+      auto getOp = mlir::dyn_cast<xilinx::air::ChannelGetOp>(c.op);
+      if (!getOp)
+        c.op->emitOpError("has mismatching event type").attachNote()
+            << "Has 'channel' as event type, but op isn't of type "
+               "air::ChannelGetOp";
+      MemRefType dstTy = llvm::cast<MemRefType>(getOp.getDst().getType());
+      std::vector<air::ChannelPutOp> putOps =
+          channel_uses->getTheOtherChannelOps(getOp);
+      if (!putOps.size())
+        getOp->emitOpError("found no put op for air::ChannelGetOp");
+      MemRefType srcTy = llvm::cast<MemRefType>(putOps[0].getSrc().getType());
+      auto srcSpace = srcTy.getMemorySpaceAsInt();
+      auto dstSpace = dstTy.getMemorySpaceAsInt();
+      auto srcVolumn = getTransferVolumn(putOps[0]);
+      auto dstVolumn = getTransferVolumn(getOp);
+      // if there is a size mismatch, it's because we're moving a tile of the
+      // larger tensor
+      if (srcVolumn <= dstVolumn)
+        return std::make_tuple(srcSpace, dstSpace, (int64_t)srcVolumn,
+                               (Type)srcTy);
+      return std::make_tuple(srcSpace, dstSpace, (int64_t)dstVolumn,
+                             (Type)dstTy);
+    }
+    return std::nullopt;
+  }
+
+  // Get the wrap-and-stride access patterns on both sides of a dma or channel
+  // get event. An empty pattern stands for the default, contiguous access.
+  SmallVector<std::pair<SmallVector<Value>, SmallVector<Value>>>
+  getTransferAccessPatterns(dependencyNodeEntry &c) {
+    SmallVector<std::pair<SmallVector<Value>, SmallVector<Value>>> patterns;
+    auto push_pattern = [&](OperandRange sizes, OperandRange strides) {
+      patterns.push_back(
+          std::make_pair(SmallVector<Value>(sizes.begin(), sizes.end()),
+                         SmallVector<Value>(strides.begin(), strides.end())));
+    };
+    if (auto dmaOp = dyn_cast<air::DmaMemcpyNdOp>(c.op)) {
+      push_pattern(dmaOp.getSrcSizes(), dmaOp.getSrcStrides());
+      push_pattern(dmaOp.getDstSizes(), dmaOp.getDstStrides());
+    } else if (auto getOp = dyn_cast<air::ChannelGetOp>(c.op)) {
+      push_pattern(getOp.getSizes(), getOp.getStrides());
+      auto putOps = channel_uses->getTheOtherChannelOps(getOp);
+      if (!putOps.empty())
+        push_pattern(putOps[0].getSizes(), putOps[0].getStrides());
+    }
+    return patterns;
+  }
+
+  // Get the number of contiguous runs an access pattern breaks a transfer of
+  // "volume" elements into, and the length of each run in elements.
+  // Dimensions are folded into the run from the innermost one outwards, for
+  // as long as they continue the contiguous run.
+  std::pair<uint64_t, uint64_t>
+  getContiguousRuns(SmallVector<Value> sizes, SmallVector<Value> strides,
+                    uint64_t volume) {
+    if (sizes.empty() || sizes.size() != strides.size())
+      return {1, volume};
+    uint64_t run = 1;
+    for (int i = sizes.size() - 1; i >= 0; i--) {
+      auto size = getConstantIntValue(sizes[i]);
+      auto stride = getConstantIntValue(strides[i]);
+      if (!size || !stride)
+        return {1, volume};
+      if (*size != 1 && *stride != (int64_t)run)
+        break;
+      run *= *size;
+    }
+    run = std::max(run, (uint64_t)1);
+    return {std::max(volume / run, (uint64_t)1), run};
+  }
+
+  // Add the DMA overheads of an access pattern to the latency of streaming the
+  // transferred data: a buffer descriptor setup, an iteration overhead per
+  // dimension wrap, and the bandwidth lost to partially used bursts, which
+  // follows from the length in bytes of the contiguous runs. The worse of the
+  // source and destination patterns is charged.
+  uint64_t getAccessPatternCost(
+      device &d,
+      SmallVector<std::pair<SmallVector<Value>, SmallVector<Value>>> patterns,
+      uint64_t stream_cycles, int64_t volume, mlir::Type ty) {
+    double datawidth = d.datatypes[getElementTypeAsString(ty)];
+    uint64_t runs = 1;
+    double efficiency = 1;
+    for (auto &[sizes, strides] : patterns) {
+      auto [pattern_runs, run_length] =
+          getContiguousRuns(sizes, strides, volume);
+      runs = std::max(runs, pattern_runs);
+      if (datawidth > 0)
+        efficiency = std::min(efficiency,
+                              CostModel::getBurstEfficiency(
+                                  run_length * datawidth, d.dma_burst_bytes));
+    }
+    CostModel::TransferParams params;
+    params.bd_setup_cycles = d.dma_bd_setup_cycles;
+    params.wrap_cycles = d.dma_wrap_cycles;
+    params.burst_bytes = d.dma_burst_bytes;
+    return CostModel::getDMACycles(stream_cycles, runs, efficiency, params);
+  }
+
   uint64_t getTransferCost(device &d, Operation *op, unsigned srcSpace,
                            unsigned dstSpace, mlir::Type ty) {
     return getTransferCost(d, op, srcSpace, dstSpace, getTensorVolume(ty), ty);
@@ -641,54 +958,83 @@ private:
   }
 
   uint64_t getComputeCostFromCostModel(device &d, Operation *op) {
-    uint64_t compute_op_cost = 0;
-    auto opCounts = xilinx::air::CostModel().getOpCounts(op);
-    std::string skip = "footprint";
-    std::string memops = "reads;writes;";
-    std::string cpuops = "math.rsqrt;";
-    cpuops += "arith.mulf;arith.divf;arith.addf;arith.subf;arith.truncf;"
-              "arith.cmpf;arith.maxf;";
-    cpuops += "arith.muli;arith.divsi;arith.divsi;arith.addi;arith.subi;"
-              "arith.trunci;arith.cmpi;arith.maxi";
-    cpuops += "std.select";
-    uint64_t compute_op_count = 0;
-    for (auto &p : opCounts.map) {
-      auto name = std::get<0>(p);
-      auto count = std::get<1>(p);
-      if (memops.find(name) != std::string::npos) {
-      } else if (cpuops.find(name) != std::string::npos)
-        compute_op_count += count;
-      else if (skip.find(name) == std::string::npos)
-        LLVM_DEBUG(llvm::dbgs() << name << " not counted\n");
-    }
+    auto linalgOp = dyn_cast<linalg::LinalgOp>(op);
+    if (!linalgOp)
+      return 0;
+    auto params = getComputeParams(d, air::to_string(op),
+                                   getElementTypeAsString(
+                                       op->getOperandTypes()[0]));
+    if (params.ops_per_cycle * params.efficiency <= 0)
+      op->emitOpError("ops per cycle in model must be greater than zero");
+    return xilinx::air::CostModel().getLinalgOpCycles(linalgOp, params);
+  }
 
-    if (compute_op_count) {
-      // defaults
-      double num_cores = 1;              // one because the post-tiling code in
-                                         // air.herd's body is for each core
-      double ops_per_core_per_cycle = 8; // vector width for this type
-      double efficiency = 1.0f;
-
-      // if kernels exists, assume everthing else exists
-      // Get operation datatype as the first operand's datatype
-      auto op_datatype = getElementTypeAsString(op->getOperandTypes()[0]);
-      if (d.kernels.count(air::to_string(op))) {
-        if (d.kernels[air::to_string(op)]->datatypes.count(op_datatype)) {
-          ops_per_core_per_cycle =
-              d.kernels[air::to_string(op)]->datatypes[op_datatype].second;
-          efficiency =
-              d.kernels[air::to_string(op)]->datatypes[op_datatype].first;
-        }
+  // Get the roofline parameters of a kernel on one compute tile from the
+  // device model
+  CostModel::ComputeParams getComputeParams(device &d, std::string kernel_name,
+                                            std::string op_datatype) {
+    // defaults: post-tiling code in air.herd's body is for each core, and the
+    // vector width is 8 ops per cycle
+    CostModel::ComputeParams params;
+    // if kernels exists, assume everthing else exists
+    if (d.kernels.count(kernel_name)) {
+      auto k = d.kernels[kernel_name];
+      if (k->datatypes.count(op_datatype)) {
+        params.ops_per_cycle = k->datatypes[op_datatype].second;
+        params.efficiency = k->datatypes[op_datatype].first;
       }
+      auto &extra = k->datatype_params[op_datatype];
+      if (extra.count("vector_lanes"))
+        params.vector_lanes = extra["vector_lanes"];
+      if (extra.count("accumulator_latency"))
+        params.accumulator_latency = extra["accumulator_latency"];
+      if (extra.count("loop_overhead_cycles"))
+        params.loop_overhead_cycles = extra["loop_overhead_cycles"];
+    }
+    // L1 bandwidth of the tile
+    if (d.dus.size() && d.dus[0]->tiles.size() &&
+        d.dus[0]->tiles[0]->tile_mem) {
+      auto mem = d.dus[0]->tiles[0]->tile_mem;
+      params.read_bytes_per_cycle = mem->read_bytes_per_cycle;
+      params.write_bytes_per_cycle = mem->write_bytes_per_cycle;
+    }
+    return params;
+  }
 
-      double ops_per_cycle = num_cores * ops_per_core_per_cycle * efficiency;
-      if (ops_per_cycle <= 0)
-        op->emitOpError("ops per cycle in model must be greater than zero");
-
-      double cycles = ceil(compute_op_count / ops_per_cycle);
-      compute_op_cost = cycles;
+  // Get the latency of an air.custom op from its own cost attributes: either
+  // "latency" in cycles, or "ops" (with optional "ops_per_cycle") and
+  // "read_bytes"/"write_bytes" for a roofline estimate against the tile.
+  std::optional<uint64_t> getComputeCostFromAttrs(device &d,
+                                                  air::CustomOp op) {
+    auto getAttrValue = [&](StringRef name) -> std::optional<double> {
+      auto attr = op->getAttr(name);
+      if (auto intAttr = dyn_cast_if_present<IntegerAttr>(attr))
+        return (double)intAttr.getInt();
+      if (auto floatAttr = dyn_cast_if_present<FloatAttr>(attr))
+        return floatAttr.getValueAsDouble();
+      return std::nullopt;
+    };
+    if (auto latency = getAttrValue("latency"))
+      return (uint64_t)ceil(*latency);
+    auto ops = getAttrValue("ops");
+    auto read_bytes = getAttrValue("read_bytes");
+    auto write_bytes = getAttrValue("write_bytes");
+    if (!ops && !read_bytes && !write_bytes)
+      return std::nullopt;
+    std::string op_datatype = "";
+    if (op->getNumOperands())
+      op_datatype = getElementTypeAsString(op->getOperandTypes()[0]);
+    auto params = getComputeParams(d, "", op_datatype);
+    if (auto ops_per_cycle = getAttrValue("ops_per_cycle"))
+      params.ops_per_cycle = *ops_per_cycle;
+    if (params.ops_per_cycle <= 0) {
+      op->emitOpError("ops per cycle must be greater than zero");
+      return std::nullopt;
     }
-    return compute_op_cost;
+    double compute_cycles = ops.value_or(0) / params.ops_per_cycle;
+    return xilinx::air::CostModel().getRooflineCycles(
+        compute_cycles, read_bytes.value_or(0), write_bytes.value_or(0),
+        params);
   }
 
   uint64_t getComputeCostFromJSON(device &d, air::CustomOp op) {
@@ -754,9 +1100,12 @@ private:
 
 AIRRunner::AIRRunner(llvm::raw_ostream &trace_stream,
                      llvm::json::Value &json_model, std::string sim_granularity,
-                     bool verbose) {
+                     bool verbose, std::string launch_iterations,
+                     std::string trace_format, std::string trace_filter) {
   impl = std::make_unique<AIRRunner_impl>(trace_stream, json_model,
-                                          sim_granularity, verbose);
+                                          sim_granularity, verbose,
+                                          launch_iterations, trace_format,
+                                          trace_filter);
   if (verbose) {
     llvm::DebugFlag = true;
     llvm::setCurrentDebugType(DEBUG_TYPE);
@@ -9,6 +9,7 @@
 #define AIR_UTIL_RUNNER_RESOURCE
 
 #include "air/Util/Runner.h"
+#include <functional>
 #include <iostream> // To print std::cerr error message
 
 namespace xilinx {
@@ -100,7 +101,95 @@ public:
     this->data_rate = bytes_per_cycle;
   }
 
+  // Fair-share bandwidth server. A port used as a shared link serves all
+  // transfers in flight on it concurrently. Each transfer is served at most at
+  // its uncontended rate, and the aggregate rate over all transfers is capped
+  // at shared_data_rate (zero means no aggregate cap). Transfer work is
+  // tracked in cycles at the uncontended rate, so that an uncontended transfer
+  // keeps its statically modelled latency.
+  double shared_data_rate = 0;
+  // Shared links which every transfer through this port occupies
+  std::vector<port *> shared_links;
+
+  // Transfer utilization statistics
+  double bytes_served = 0;
+  uint64_t busy_cycles = 0;
+  unsigned peak_transfers = 0;
+
+  void set_shared_data_rate(double bytes_per_second) {
+    this->shared_data_rate = bytes_per_second;
+  }
+
+  // Register a transfer which needs "cycles" cycles to move "bytes" bytes at
+  // its uncontended rate of "rate" bytes per second. The retime callback is
+  // invoked with the updated end time of every transfer in flight, including
+  // the new one. Returns a transfer id.
+  unsigned add_transfer(uint64_t now, uint64_t cycles, double bytes,
+                        double rate, std::function<void(uint64_t)> retime) {
+    this->advance(now);
+    unsigned id = this->next_transfer_id++;
+    this->transfers.push_back({id, (double)cycles, bytes, rate, retime});
+    this->peak_transfers =
+        std::max(this->peak_transfers, (unsigned)this->transfers.size());
+    this->retime(now);
+    return id;
+  }
+
+  // Remove a finished (or abandoned) transfer and re-time the remaining ones.
+  void remove_transfer(uint64_t now, unsigned id) {
+    this->advance(now);
+    for (auto it = this->transfers.begin(); it != this->transfers.end();
+         ++it) {
+      if (it->id != id)
+        continue;
+      this->bytes_served += it->bytes;
+      this->transfers.erase(it);
+      this->retime(now);
+      return;
+    }
+  }
+
+  // Fraction of the uncontended rate which each transfer in flight gets
+  double get_share() {
+    double demand = 0;
+    for (auto &t : this->transfers)
+      demand += t.rate;
+    if (demand <= 0 || this->shared_data_rate <= 0)
+      return 1;
+    return std::min(1.0, this->shared_data_rate / demand);
+  }
+
 private:
+  struct transfer {
+    unsigned id;
+    // Remaining work, in cycles at the uncontended rate
+    double remaining;
+    double bytes;
+    // Uncontended rate, in bytes per second
+    double rate;
+    std::function<void(uint64_t)> retime;
+  };
+  std::vector<transfer> transfers;
+  uint64_t last_update = 0;
+  unsigned next_transfer_id = 0;
+
+  // Serve the transfers in flight up to time stamp "now"
+  void advance(uint64_t now) {
+    if (now > this->last_update && !this->transfers.empty()) {
+      double served = (now - this->last_update) * this->get_share();
+      for (auto &t : this->transfers)
+        t.remaining = std::max(0.0, t.remaining - served);
+      this->busy_cycles += now - this->last_update;
+    }
+    this->last_update = std::max(this->last_update, now);
+  }
+
+  // Notify every transfer in flight of its end time at the current share
+  void retime(uint64_t now) {
+    double share = this->get_share();
+    for (auto &t : this->transfers)
+      t.retime(now + (uint64_t)ceil(t.remaining / share - 1e-9));
+  }
 }; // port
 
 class streamPort : port {
@@ -120,6 +209,9 @@ public:
   int ops_per_core_per_cycle;
   // Key: datatype name; mapped: pair <efficiency, ops_per_core_per_cycle>
   std::map<std::string, std::pair<double, int>> datatypes;
+  // Key: datatype name; mapped: optional roofline parameters of the datatype
+  // (vector_lanes, accumulator_latency, loop_overhead_cycles), keyed by name
+  std::map<std::string, std::map<std::string, double>> datatype_params;
 
   void push_to_datatypes(std::string datatype_name, std::optional<double> eff,
                          std::optional<int> vectorSize) {
@@ -162,6 +254,10 @@ public:
                                        datatype_name +
                                        ", supported: ops_per_core_per_cycle, "
                                        "macs_per_core_per_cycle");
+        for (auto param :
+             {"vector_lanes", "accumulator_latency", "loop_overhead_cycles"})
+          if (auto value = datatypeObject->getNumber(param))
+            this->datatype_params[datatype_name][param] = *value;
       }
       this->reset_reservation();
     }
@@ -178,6 +274,9 @@ public:
   unsigned memory_space;
   double bytes;
   double bytes_used;
+  // Bandwidth between the memory and the core; zero if not modelled
+  double read_bytes_per_cycle = 0;
+  double write_bytes_per_cycle = 0;
 
   void set_memory_space(unsigned ms) { this->memory_space = ms; }
 
@@ -185,6 +284,13 @@ public:
 
   void reset_usage() { this->bytes_used = 0; }
 
+  void set_bandwidth(llvm::json::Object *memObject) {
+    if (auto rd = memObject->getNumber("read_bytes_per_cycle"))
+      this->read_bytes_per_cycle = *rd;
+    if (auto wr = memObject->getNumber("write_bytes_per_cycle"))
+      this->write_bytes_per_cycle = *wr;
+  }
+
   memory(unsigned ms, double b) {
     this->set_memory_space(ms);
     this->set_bytes(b);
@@ -19,6 +19,44 @@ class resourceHierarchy : public resource {
 public:
   std::vector<resourceHierarchy *> sub_resource_hiers;
   std::vector<resource *> resources;
+  // Keys: port direction (inbound/outbound); mapped: aggregate bytes per
+  // second shared by all ports in that direction, if capped in JSON model.
+  std::map<std::string, double> shared_data_rates;
+  // Keys: port direction (inbound/outbound); mapped: shared link which all
+  // transfers through the ports in that direction occupy.
+  std::map<std::string, port *> links;
+
+  // Get the aggregate data rate of a group of ports, which all transfers
+  // through them share. Defaults to the sum of their data rates.
+  double getSharedDataRate(std::string port_direction,
+                           std::vector<port *> &port_group) {
+    if (this->shared_data_rates.count(port_direction))
+      return this->shared_data_rates[port_direction];
+    double rate = 0;
+    for (auto p : port_group)
+      rate += p->data_rate;
+    return rate;
+  }
+
+  void set_shared_data_rate(std::string port_direction,
+                            llvm::json::Object *portsObject) {
+    if (auto rate = portsObject->getNumber("shared_bytes_per_second"))
+      this->shared_data_rates[port_direction] = *rate;
+  }
+
+  // Create the shared link of a group of ports, and make it occupied by all
+  // transfers through them
+  void set_link(std::string port_direction, std::vector<port *> &port_group) {
+    if (port_group.empty())
+      return;
+    port *link = new port(port_group[0]);
+    link->set_parent(this);
+    link->set_shared_data_rate(
+        this->getSharedDataRate(port_direction, port_group));
+    for (auto p : port_group)
+      p->shared_links.push_back(link);
+    this->links[port_direction] = link;
+  }
 
   resourceHierarchy(std::string name = "", resource *parent = nullptr) {
     this->set_name(name);
@@ -52,6 +90,7 @@ public:
       this->resource_assertion(bytes != 0.0f,
                                "memory size is zero bytes for memory object");
       memory *mem = new memory(ms.value().str(), *bytes);
+      mem->set_bandwidth(memObject);
       this->set_memory(mem);
     } else {
       this->tile_mem = nullptr;
@@ -72,6 +111,8 @@ public:
             inbound_port_vec.push_back(new_port);
           }
           this->ports.insert(std::make_pair("inbound", inbound_port_vec));
+          this->set_shared_data_rate("inbound", inboundPortsObject);
+          this->set_link("inbound", inbound_port_vec);
         }
       }
 
@@ -87,6 +128,8 @@ public:
             outbound_port_vec.push_back(new_port);
           }
           this->ports.insert(std::make_pair("outbound", outbound_port_vec));
+          this->set_shared_data_rate("outbound", outboundPortsObject);
+          this->set_link("outbound", outbound_port_vec);
         }
       }
     } else {
@@ -95,6 +138,7 @@ public:
   }
 
   tile(resource *parent, llvm::json::Object *tileObject, unsigned idx) {
+    this->set_parent(parent);
     this->set_tile_id(idx);
     this->set_memory(tileObject->getObject("memory"));
     this->set_ports(tileObject->getObject("ports"));
@@ -114,15 +158,20 @@ public:
   std::vector<unsigned> shape;
   // Keys: port direction (inbound/outbound); mapped: vector of ports.
   std::map<std::string, std::vector<port *>> ports;
+  // Keys: port direction (inbound/outbound); mapped: shared link which all
+  // transfers through the tiles' ports in that direction occupy.
+  std::map<std::string, port *> column_links;
   unsigned idx;
 
   du() {}
 
   du(resource *parent, llvm::json::Object *duObject, unsigned idx) {
+    this->set_parent(parent);
     this->set_du_id(idx);
     this->set_memory(duObject->getObject("memory"));
     this->set_tiles(duObject->getObject("tiles"));
     this->set_ports(duObject->getObject("ports"));
+    this->set_column_links();
     this->set_shape(duObject->getObject("tiles")->getArray("count"));
     this->reset_reservation();
   }
@@ -182,6 +231,8 @@ public:
             inbound_port_vec.push_back(new_port);
           }
           this->ports.insert(std::make_pair("inbound", inbound_port_vec));
+          this->set_shared_data_rate("inbound", inboundPortsObject);
+          this->set_link("inbound", inbound_port_vec);
         }
       }
 
@@ -197,6 +248,8 @@ public:
             outbound_port_vec.push_back(new_port);
           }
           this->ports.insert(std::make_pair("outbound", outbound_port_vec));
+          this->set_shared_data_rate("outbound", outboundPortsObject);
+          this->set_link("outbound", outbound_port_vec);
         }
       }
     } else {
@@ -204,6 +257,30 @@ public:
     }
   }
 
+  // Create the shared links of the column of tiles in this DU. Transfers
+  // through the tiles' ports stream through the DU's interconnect, which
+  // carries as much as the DU's own ports in the same direction do.
+  void set_column_links() {
+    for (std::string port_direction : {"inbound", "outbound"}) {
+      if (!this->ports.count(port_direction))
+        continue;
+      double rate =
+          this->getSharedDataRate(port_direction, this->ports[port_direction]);
+      port *link = nullptr;
+      for (auto t : this->tiles) {
+        for (auto p : t->ports[port_direction]) {
+          if (!link) {
+            link = new port(p);
+            link->set_parent(this);
+            link->set_shared_data_rate(rate);
+            this->column_links[port_direction] = link;
+          }
+          p->shared_links.push_back(link);
+        }
+      }
+    }
+  }
+
   // Get the shape of each DU (in tiles)
   void set_shape(llvm::json::Array *sizesObject) {
     for (auto it = sizesObject->begin(), ie = sizesObject->end(); it != ie;
@@ -241,6 +318,12 @@ public:
   std::vector<du *> dus;
   // Keys: port direction (inbound/outbound); mapped: vector of ports.
   std::map<std::string, std::vector<port *>> ports;
+  // DMA access pattern overheads: cycles to set up a buffer descriptor, cycles
+  // per wrap of an access pattern dimension, and burst size in bytes. Zero
+  // disables the corresponding overhead.
+  double dma_bd_setup_cycles = 0;
+  double dma_wrap_cycles = 0;
+  double dma_burst_bytes = 0;
 
   void set_clock(std::optional<double> clk) {
     if (clk) {
@@ -280,6 +363,21 @@ public:
     }
   }
 
+  void set_dma_parameters(llvm::json::Object *dmaObject) {
+    if (!dmaObject)
+      return;
+    if (auto bd_setup = dmaObject->getNumber("bd_setup_cycles"))
+      this->dma_bd_setup_cycles = *bd_setup;
+    if (auto wrap = dmaObject->getNumber("wrap_cycles"))
+      this->dma_wrap_cycles = *wrap;
+    if (auto burst = dmaObject->getNumber("burst_bytes"))
+      this->dma_burst_bytes = *burst;
+    this->resource_assertion(this->dma_bd_setup_cycles >= 0 &&
+                                 this->dma_wrap_cycles >= 0 &&
+                                 this->dma_burst_bytes >= 0,
+                             "negative dma parameter in JSON model");
+  }
+
   void set_kernels(llvm::json::Object *kernelObjects) {
     for (auto it = kernelObjects->begin(), ie = kernelObjects->end(); it != ie;
          ++it) {
@@ -326,6 +424,8 @@ public:
             inbound_port_vec.push_back(new_port);
           }
           this->ports.insert(std::make_pair("inbound", inbound_port_vec));
+          this->set_shared_data_rate("inbound", inboundPortsObject);
+          this->set_link("inbound", inbound_port_vec);
         }
       }
 
@@ -341,6 +441,8 @@ public:
             outbound_port_vec.push_back(new_port);
           }
           this->ports.insert(std::make_pair("outbound", outbound_port_vec));
+          this->set_shared_data_rate("outbound", outboundPortsObject);
+          this->set_link("outbound", outbound_port_vec);
         }
       }
     } else {
@@ -352,12 +454,14 @@ public:
                                std::optional<double> clk = 0,
                                llvm::json::Array *datatypeObjects = nullptr,
                                llvm::json::Object *kernelsObject = nullptr,
-                               llvm::json::Object *parentObject = nullptr) {
+                               llvm::json::Object *parentObject = nullptr,
+                               llvm::json::Object *dmaObject = nullptr) {
     this->set_name(nameObject);
     this->set_clock(clk);
     this->set_datatypes(datatypeObjects);
     this->set_interfaces();
     this->set_kernels(kernelsObject);
+    this->set_dma_parameters(dmaObject);
     // TODO: get parent from parentObject, for multi-device modelling.
   }
 
@@ -410,7 +514,8 @@ public:
                                  model->getObject("noc"));
     this->setup_device_parameters(
         model->getObject("devicename"), model->getNumber("clock"),
-        model->getArray("datatypes"), model->getObject("kernels"), nullptr);
+        model->getArray("datatypes"), model->getObject("kernels"), nullptr,
+        model->getObject("dma"));
     this->reset_reservation();
   }
 
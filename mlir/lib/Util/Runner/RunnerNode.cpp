@@ -27,8 +27,6 @@ public:
   // TODO: Replace thread id with id which better reflects resource slots.
   std::vector<std::tuple<Graph::VertexId, std::vector<resource *>, unsigned>>
       wavefront;
-  // A vector of vertices processed by the current runner node
-  std::vector<Graph::VertexId> processed_vertices;
   // An incomplete vector of vertices as candidates to wavefront
   std::vector<Graph::VertexId> latent_wavefront_candidates;
   // Sub runner nodes to the current runner node
@@ -45,12 +43,12 @@ public:
     // Get all adj. vertices to the procssed vertices as candidates
     this->findAdjacentVerticesToProcessed(next_vertex_set_candidates);
     for (auto v : this->latent_wavefront_candidates) {
-      push_back_if_unique<Graph::VertexId>(next_vertex_set_candidates, v);
+      if (!this->ready_vertices.contains(v))
+        next_vertex_set_candidates.push_back(v);
     }
     // Remove candidate vertices already on wavefront
-    this->removeRepeatedVertices(
-        next_vertex_set_candidates,
-        this->getVectorOfFirstFromVectorOfTuples(this->wavefront));
+    llvm::erase_if(next_vertex_set_candidates,
+                   [&](Graph::VertexId v) { return this->isOnWavefront(v); });
     // Remove candidate vertices which are filtered out by an affine.if, if
     // showing cores
     if (this->sim_granularity == "core") {
@@ -71,6 +69,162 @@ public:
                              "queried thread is busy");
     }
     this->wavefront.push_back(entry);
+    this->wavefront_generations[v] = ++this->last_wavefront_generation;
+    this->noteSharedStateChange();
+    this->pushCompletionEvent(v);
+  }
+
+  // Register the completion of a vertex on wavefront with the launch runner's
+  // event queue. Must be called after the vertex's end_time is set.
+  void pushCompletionEvent(Graph::VertexId v) {
+    auto launch_runner = this->getParentLaunchRunner();
+    this->runner_assertion(launch_runner, "launch runner node not found");
+    this->runner_assertion(this->isOnWavefront(v),
+                           "completion event for vertex off wavefront");
+    launch_runner->completion_events.push(
+        std::make_tuple(this->ctrl_g->g[v].end_time, this, v,
+                        this->wavefront_generations[v]));
+  }
+
+  // Pop the completion events which have come due by time, marking their
+  // runner nodes for execution. A terminator coming due may fulfill its
+  // parent's dependence on the hierarchy op, which counts as a change to
+  // shared state.
+  void popDueCompletionEvents(uint64_t time) {
+    this->runner_assertion(this->runner_node_type == "launch",
+                           "completion events are held by launch runner");
+    while (!this->completion_events.empty() &&
+           std::get<0>(this->completion_events.top()) <= time) {
+      auto event = this->completion_events.top();
+      this->completion_events.pop();
+      if (!isCompletionEventValid(event))
+        continue;
+      auto [end_time, node, v, generation] = event;
+      if (!node->has_due_completions) {
+        node->has_due_completions = true;
+        this->due_runner_node_count++;
+      }
+      if (v == node->ctrl_g->terminator_vertex && node->parent)
+        this->noteSharedStateChange();
+    }
+  }
+
+  // Get the time stamp of the earliest pending completion event. Events which
+  // no longer correspond to a started vertex on their runner node's wavefront
+  // are lazily discarded. Returns 0 if no event is pending.
+  uint64_t getNextCompletionTime() {
+    this->runner_assertion(this->runner_node_type == "launch",
+                           "completion events are held by launch runner");
+    while (!this->completion_events.empty()) {
+      auto &event = this->completion_events.top();
+      if (isCompletionEventValid(event))
+        return std::get<0>(event);
+      this->completion_events.pop();
+    }
+    return 0;
+  }
+
+  // Whether a runner node has a due completion event yet to be executed
+  bool hasDueCompletions() { return this->due_runner_node_count; }
+
+  // Clear this runner node's mark for execution, returning whether it was set
+  bool takeDueCompletions() {
+    if (!this->has_due_completions)
+      return false;
+    this->has_due_completions = false;
+    this->getParentLaunchRunner()->due_runner_node_count--;
+    return true;
+  }
+
+  // Record a change to state shared between runner nodes: channel tokens and
+  // ports, memories, or resource hierarchies
+  void noteSharedStateChange() {
+    this->getParentLaunchRunner()->shared_state_epoch++;
+  }
+
+  // Whether pushing or executing a vertex changes state shared between runner
+  // nodes
+  bool changesSharedState(Graph::VertexId v) {
+    auto &node = this->ctrl_g->g[v];
+    switch (node.asyncEventType) {
+    case asyncEventKind::start:
+    case asyncEventKind::dma:
+    case asyncEventKind::channel:
+    case asyncEventKind::hierarchy:
+    case asyncEventKind::hierarchy_terminator:
+    case asyncEventKind::terminator:
+      return true;
+    default:
+      return isa_and_nonnull<air::ChannelInterface>(node.op) ||
+             node.asyncEventNameId == dependencyStringTable::allocOpId ||
+             node.asyncEventNameId == dependencyStringTable::deallocOpId;
+    }
+  }
+
+  // Record the start of a check of this runner node's candidates
+  void beginReadinessCheck() {
+    this->checked_epoch = this->getParentLaunchRunner()->shared_state_epoch;
+  }
+
+  // Record whether the check left candidates blocked on their dependencies or
+  // resources
+  void endReadinessCheck(bool blocked) {
+    this->has_blocked_candidates = blocked;
+  }
+
+  // Whether a candidate was left blocked, and shared state has changed since,
+  // so that it may have been unblocked. Blocked candidates of a runner node
+  // are otherwise only unblocked by its own completion events.
+  bool hasStaleBlockedCandidates() {
+    return this->has_blocked_candidates &&
+           this->checked_epoch !=
+               this->getParentLaunchRunner()->shared_state_epoch;
+  }
+
+  // Check if a vertex is currently on wavefront
+  bool isOnWavefront(Graph::VertexId v) {
+    return this->wavefront_generations.count(v);
+  }
+
+  // Get the ports held by a channel's puts or gets which are in flight
+  std::vector<port *> getChannelPortsInUse(std::string chan_name,
+                                           std::string put_or_get) {
+    std::vector<port *> ports;
+    auto key = std::make_pair(chan_name, put_or_get);
+    if (!this->channel_ops_in_progress.count(key))
+      return ports;
+    for (auto res : this->channel_ops_in_progress[key].second)
+      if (res->isReserved)
+        ports.push_back(static_cast<port *>(res));
+    return ports;
+  }
+
+  // Forget a vertex's wavefront generation once it leaves wavefront, which
+  // invalidates any completion event still queued for it
+  void retireFromWavefront(Graph::VertexId v) {
+    this->wavefront_generations.erase(v);
+  }
+
+  // Mark a vertex as processed. Its successors become candidates to
+  // wavefront.
+  void markVertexAsProcessed(Graph::VertexId v) {
+    if (!this->processed_vertex_order
+             .try_emplace(v, this->processed_vertex_count++)
+             .second)
+      return;
+    Graph &G = this->ctrl_g->g;
+    this->ready_vertices.erase(v);
+    for (auto adj_v : G.adjacentVertices(v))
+      if (++this->processed_predecessor_counts[adj_v] == 1 &&
+          !this->processed_vertex_order.count(adj_v))
+        this->ready_vertices.insert(adj_v);
+  }
+
+  // Clear all processed vertices
+  void clearProcessedVertices() {
+    this->processed_vertex_order.clear();
+    this->processed_predecessor_counts.clear();
+    this->ready_vertices.clear();
   }
 
   // Push an entry to wavefront
@@ -97,6 +251,9 @@ public:
       }
     }
     this->wavefront.push_back(std::make_tuple(v, reserved_resources, tid));
+    this->wavefront_generations[v] = ++this->last_wavefront_generation;
+    if (this->changesSharedState(v))
+      this->noteSharedStateChange();
   }
 
   // Initialize sub runner nodes from launch graph tree
@@ -124,21 +281,13 @@ public:
     }
   }
 
-  // Get time stamps from wavefront
-  void getTimeStampsFromWavefront(std::vector<uint64_t> &next_times) {
-    for (auto it = this->wavefront.begin(); it != this->wavefront.end(); it++) {
-      auto command_node = this->ctrl_g->g[std::get<0>(*it)];
-      if (command_node.is_started() && (command_node.end_time)) {
-        next_times.push_back(command_node.end_time);
-      }
-    }
-  }
-
   // Execute an mlir op in runner node
   void executeOpImpls(Graph::VertexId it, uint64_t time) {
-    Graph G = this->ctrl_g->g;
+    Graph &G = this->ctrl_g->g;
     auto node = G[it];
-    if (node.asyncEventType == "start") {
+    if (this->changesSharedState(it))
+      this->noteSharedStateChange();
+    if (node.asyncEventType == asyncEventKind::start) {
       this->executeOp(it);
     } else if (auto Op = dyn_cast<xilinx::air::HierarchyInterface>(node.op)) {
       for (auto sub_dependency_graph : node.nextDependencyGraphs) {
@@ -180,7 +329,7 @@ public:
       for (auto v : vertices) {
         this->resetVertex(v, G, time, push_to_latent_wavefront_candidates);
         // If v is a hierarchy op, then recursively clear the entire subgraph
-        if (G[v].asyncEventType == "hierarchy") {
+        if (G[v].asyncEventType == asyncEventKind::hierarchy) {
           for (auto sub_c : G[v].nextDependencyGraphs) {
             auto sub_g = sub_c->g;
             auto sub_runner = sub_c->runner_node;
@@ -189,7 +338,7 @@ public:
         }
         // Else if v is an scf.for op, then clear the cached trip count from
         // runner node
-        else if (G[v].asyncEventType == "for_loop") {
+        else if (G[v].asyncEventType == asyncEventKind::for_loop) {
           // Clear for loop trip count from runner node's cache
           for (auto it = this->loop_trip_count.begin();
                it != this->loop_trip_count.end(); it++) {
@@ -208,6 +357,9 @@ public:
     auto sub_start_v = this->ctrl_g->start_vertex;
     auto sub_terminator_v = this->ctrl_g->terminator_vertex;
     this->resetGraphBetweenTwoVertices(sub_start_v, sub_terminator_v, G, time);
+    // The reset changes the candidates to wavefront, so check them again
+    this->has_blocked_candidates = true;
+    this->noteSharedStateChange();
   }
 
   // Consume tokens upon op execution
@@ -217,7 +369,7 @@ public:
 
     auto inv_adj_set = G.inverseAdjacentVertices(it);
     for (auto &inv_adj_v : inv_adj_set) {
-      if (G[inv_adj_v].asyncEventType == "for_loop") {
+      if (G[inv_adj_v].asyncEventType == asyncEventKind::for_loop) {
         int th = this->tokenCountThresholdForExecution(
             G[it].op); // Consume all iter_arg tokens
         this->runner_assertion(
@@ -270,7 +422,7 @@ public:
   void buildVertexDependencyList(
       Graph::VertexId v,
       std::vector<std::pair<dependencyNodeEntry, std::string>> &dep_list) {
-    Graph G = this->ctrl_g->g;
+    Graph &G = this->ctrl_g->g;
     // If current vertex is ChannelGet, then add implicit ChannelPut vertex to
     // dep list
     if (air::ChannelGetOp channel_get = dyn_cast<air::ChannelGetOp>(G[v].op)) {
@@ -282,13 +434,13 @@ public:
       // auto &node = G[inv_adj_v];
       // If dependent on a hierarchy op, then push its terminator into dep_list
       // instead
-      if (G[inv_adj_v].asyncEventType == "hierarchy") {
+      if (G[inv_adj_v].asyncEventType == asyncEventKind::hierarchy) {
         for (auto sub_g : G[inv_adj_v].nextDependencyGraphs) {
           auto terminator_v = sub_g->terminator_vertex;
           auto &terminator_node = sub_g->g[terminator_v];
           dep_list.push_back(std::make_pair(terminator_node, "ssa"));
         }
-      } else if (G[inv_adj_v].asyncEventType == "for_loop") {
+      } else if (G[inv_adj_v].asyncEventType == asyncEventKind::for_loop) {
         pushToDepListIfAffineIfHit(dep_list, G[inv_adj_v],
                                    this->ctrl_g->position, "ssa_loop_yield");
       } else {
@@ -300,10 +452,9 @@ public:
 
   // Try to reserve resources for an event
   bool checkResourceFulfillmentForOpImpls(dependencyNodeEntry node) {
-    return checkResourceFulfillmentForOpImpls(node.op, node.asyncEventName);
+    return checkResourceFulfillmentForOpImpls(node.op, node.asyncEventNameId);
   }
-  bool checkResourceFulfillmentForOpImpls(Operation *op,
-                                          std::string name = "") {
+  bool checkResourceFulfillmentForOpImpls(Operation *op, unsigned name_id = 0) {
     // At any point in time, if segment or herd op fails to allocate enough
     // resources, then the entire launch is invalid due to failing to allocate
     // enough resources upon launch.
@@ -328,10 +479,10 @@ public:
       return (bool)this->checkResourceFulfillmentForOp(Op);
     } else if (auto Op = dyn_cast<air::ExecuteOp>(op)) {
       auto child_op = Op.getChildOp();
-      if (name == "AllocOp") {
+      if (name_id == dependencyStringTable::allocOpId) {
         auto Op = dyn_cast<memref::AllocOp>(child_op);
         return this->checkResourceFulfillmentForOp(Op);
-      } else if (name == "DeallocOp") {
+      } else if (name_id == dependencyStringTable::deallocOpId) {
         auto Op = dyn_cast<memref::DeallocOp>(child_op);
         return this->checkResourceFulfillmentForOp(Op);
       }
@@ -351,7 +502,7 @@ public:
 
   ~runnerNode() {
     wavefront.clear();
-    processed_vertices.clear();
+    clearProcessedVertices();
     loop_trip_count.clear();
     sub_runner_nodes.clear();
     channel_token_counts.clear();
@@ -359,6 +510,40 @@ public:
   }
 
 private:
+  // Processed vertices, each mapped to the order in which it was processed
+  llvm::DenseMap<Graph::VertexId, uint64_t> processed_vertex_order;
+  uint64_t processed_vertex_count = 0;
+  // Number of processed predecessors of each vertex
+  llvm::DenseMap<Graph::VertexId, unsigned> processed_predecessor_counts;
+  // Unprocessed vertices with a processed predecessor, kept up to date as
+  // vertices are processed and reset
+  llvm::DenseSet<Graph::VertexId> ready_vertices;
+  // Generation of each vertex on wavefront, bumped every time it is pushed
+  llvm::DenseMap<Graph::VertexId, unsigned> wavefront_generations;
+  unsigned last_wavefront_generation = 0;
+  // Whether a completion event of this runner node has come due
+  bool has_due_completions = false;
+  // Whether the last check of this runner node's candidates left any blocked,
+  // and the shared state epoch at which that check started
+  bool has_blocked_candidates = false;
+  uint64_t checked_epoch = 0;
+  // Launch runner node only: count of runner nodes with due completion
+  // events, and epoch of state shared between runner nodes
+  unsigned due_runner_node_count = 0;
+  uint64_t shared_state_epoch = 1;
+  // Min-heap of pending completion events, keyed on end_time. Only the launch
+  // runner node holds events; entries are (end_time, runner node, vertex,
+  // wavefront generation).
+  using completionEvent =
+      std::tuple<uint64_t, runnerNode *, Graph::VertexId, unsigned>;
+  struct laterCompletionEvent {
+    bool operator()(const completionEvent &a, const completionEvent &b) const {
+      return std::get<0>(a) > std::get<0>(b);
+    }
+  };
+  std::priority_queue<completionEvent, std::vector<completionEvent>,
+                      laterCompletionEvent>
+      completion_events;
   // Dependency graph helper functions.
   dependencyCanonicalizer canonicalizer;
   // Dependency graph context.
@@ -619,7 +804,7 @@ private:
                                  Graph::VertexId v) {
     Graph &G = this->ctrl_g->g;
     this->allocateEventToResourcesImpls(reserved_resources, G[v].op,
-                                        G[v].asyncEventName);
+                                        G[v].asyncEventNameId);
   }
 
   // Try to reserve resources for an event
@@ -711,16 +896,15 @@ private:
   // Allocate event to resources
   void
   allocateEventToResourcesImpls(std::vector<resource *> &reserved_resources,
-                                Operation *op = nullptr,
-                                std::string name = "") {
+                                Operation *op = nullptr, unsigned name_id = 0) {
     if (op) {
       if (auto exec_op = dyn_cast<air::ExecuteOp>(op)) {
         auto child_op = exec_op.getChildOp();
         // Memory allocation/deallocation
-        if (name == "AllocOp") {
+        if (name_id == dependencyStringTable::allocOpId) {
           auto Op = dyn_cast<memref::AllocOp>(child_op);
           this->allocateEventToResources(Op, reserved_resources);
-        } else if (name == "DeallocOp") {
+        } else if (name_id == dependencyStringTable::deallocOpId) {
           auto Op = dyn_cast<memref::DeallocOp>(child_op);
           this->allocateEventToResources(Op, reserved_resources);
         }
@@ -1009,9 +1193,9 @@ private:
                                " is busy");
     sub_runner_node->pushStartToWavefront(sub_start_v);
 
-    sub_runner_node->processed_vertices.clear();
+    sub_runner_node->clearProcessedVertices();
 
-    this->processed_vertices.push_back(it);
+    this->markVertexAsProcessed(it);
   }
 
   void executeOp(scf::YieldOp op, uint64_t time, scf::ForOp for_op,
@@ -1057,11 +1241,11 @@ private:
     }
 
     if (allAsyncTokensFulfilled) {
-      this->processed_vertices.push_back(it);
+      this->markVertexAsProcessed(it);
     } else {
       // If trip count unfulfilled, then iterate.
       // Clear start_time and end_time of all ops in loop body.
-      // From processed_vertices, remove all ops which are in loop body.
+      // From processed vertices, remove all ops which are in loop body.
       for (unsigned i = 0; i < token_ids.size(); i++) {
         // Get the yielded token in the next loop iteration (at the beginning of
         // the loop)
@@ -1126,7 +1310,7 @@ private:
               G[adj_v].op); // Lock number = number of dependent iter_args
     }
 
-    this->processed_vertices.push_back(it);
+    this->markVertexAsProcessed(it);
   }
 
   void executeOp(air::ChannelPutOp op, Graph::VertexId it) {
@@ -1145,7 +1329,7 @@ private:
     if (launch_runner->channel_ops_in_progress.count(key)) {
       unsigned processed = launch_runner->channel_ops_in_progress[key].first;
       if (processed == total_count) {
-        this->processed_vertices.push_back(it);
+        this->markVertexAsProcessed(it);
       }
     } else
       this->runner_assertion(false, "unknown channel.put op");
@@ -1222,7 +1406,7 @@ private:
     // If data movement is complete, clear put and get progresses
     if ((put_processed * bcast_factor == total_count) &&
         (get_processed == total_count)) {
-      this->processed_vertices.push_back(it);
+      this->markVertexAsProcessed(it);
       launch_runner->channel_ops_in_progress[get_key].first = 0;
       launch_runner->channel_ops_in_progress[get_key].second.clear();
       launch_runner->channel_ops_in_progress[put_key].first = 0;
@@ -1231,20 +1415,20 @@ private:
     // Else if a previous executeOp has already cleared the progresses
     else if (!launch_runner->channel_ops_in_progress[get_key].first &&
              !launch_runner->channel_ops_in_progress[put_key].first) {
-      this->processed_vertices.push_back(it);
+      this->markVertexAsProcessed(it);
     }
     // Else if under per-core simulation mode, then complete the work for this
     // core
     else if (this->sim_granularity == "core" &&
              op->getParentOfType<air::HerdOp>()) {
-      this->processed_vertices.push_back(it);
+      this->markVertexAsProcessed(it);
     }
     // Else, continue dispatching get events
     else {
     }
   }
 
-  void executeOp(Graph::VertexId it) { this->processed_vertices.push_back(it); }
+  void executeOp(Graph::VertexId it) { this->markVertexAsProcessed(it); }
 
   // Adds pointer between runner node and command graph
   void addPointerBetweenSubRunnerNodeAndSubCommandGraph() {
@@ -1259,8 +1443,8 @@ private:
   void resetVertex(Graph::VertexId v, Graph &G, uint64_t time,
                    bool push_to_latent_wavefront_candidates = false) {
 
-    // Remove start_v from processed_vertices
-    this->removeVertexFromVertices(this->processed_vertices, v);
+    // Remove start_v from processed vertices
+    this->unmarkVertexAsProcessed(v);
 
     // Reset node's start_time and end_time, if the async event represented by
     // the vertex is complete
@@ -1822,51 +2006,46 @@ private:
     }
   }
 
-  // Get a vector of first elements from a vector of tuples
-  std::vector<Graph::VertexId> getVectorOfFirstFromVectorOfTuples(
-      std::vector<
-          std::tuple<Graph::VertexId, std::vector<resource *>, unsigned>>
-          tuples) {
-    std::vector<Graph::VertexId> items;
-    std::transform(
-        tuples.begin(), tuples.end(), std::back_inserter(items),
-        [](const std::tuple<Graph::VertexId, std::vector<resource *>, unsigned>
-               &p) { return std::get<0>(p); });
-    return items;
-  }
-
-  // Find all vertices adjacent to given vertices in graph
+  // Find all unprocessed vertices adjacent to processed vertices in graph,
+  // ordered by when their earliest processed predecessor was processed
   void findAdjacentVerticesToProcessed(
       std::vector<Graph::VertexId> &adjacentVertices) {
-    Graph G = this->ctrl_g->g;
-    for (auto v : this->processed_vertices) {
-      auto adj_set = G.adjacentVertices(v);
-      for (auto v1 : adj_set) {
-        bool found_duplicate = false;
-        for (auto v2 : adjacentVertices) {
-          if (v1 == v2) {
-            found_duplicate = true;
-          }
-        }
-        bool is_in_getVertices = false;
-        for (auto v3 : this->processed_vertices) {
-          if (v1 == v3) {
-            is_in_getVertices = true;
-          }
-        }
-        if (!found_duplicate && !is_in_getVertices) {
-          adjacentVertices.push_back(v1);
-        }
+    Graph &G = this->ctrl_g->g;
+    std::vector<std::pair<uint64_t, Graph::VertexId>> ordered;
+    for (auto v : this->ready_vertices) {
+      uint64_t order = std::numeric_limits<uint64_t>::max();
+      for (auto inv_adj_v : G.inverseAdjacentVertices(v)) {
+        auto it = this->processed_vertex_order.find(inv_adj_v);
+        if (it != this->processed_vertex_order.end())
+          order = std::min(order, it->second);
       }
+      ordered.push_back(std::make_pair(order, v));
     }
+    llvm::sort(ordered);
+    for (auto &entry : ordered)
+      adjacentVertices.push_back(entry.second);
   }
 
-  // Remove vertices in vector a which already exist in vector b
-  void removeRepeatedVertices(std::vector<Graph::VertexId> &a,
-                              std::vector<Graph::VertexId> b) {
-    for (auto v : b) {
-      this->removeVertexFromVertices(a, v);
-    }
+  // Unmark a processed vertex. Its successors which have no other processed
+  // predecessor are no longer candidates to wavefront.
+  void unmarkVertexAsProcessed(Graph::VertexId v) {
+    if (!this->processed_vertex_order.erase(v))
+      return;
+    Graph &G = this->ctrl_g->g;
+    for (auto adj_v : G.adjacentVertices(v))
+      if (--this->processed_predecessor_counts[adj_v] == 0)
+        this->ready_vertices.erase(adj_v);
+    if (this->processed_predecessor_counts.lookup(v))
+      this->ready_vertices.insert(v);
+  }
+
+  // Whether a completion event still refers to the same wavefront entry and
+  // end time it was pushed for
+  static bool isCompletionEventValid(const completionEvent &event) {
+    auto [end_time, node, v, generation] = event;
+    auto &entry = node->ctrl_g->g[v];
+    return node->wavefront_generations.lookup(v) == generation &&
+           entry.is_started() && entry.end_time == end_time;
   }
 
   // Remove ops in affine.if which aren't running on this core
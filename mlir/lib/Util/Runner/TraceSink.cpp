@@ -0,0 +1,373 @@
+//===- TraceSink.cpp --------------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef AIR_UTIL_RUNNER_TRACE_SINK
+#define AIR_UTIL_RUNNER_TRACE_SINK
+
+#include "air/Util/Dependency.h"
+#include "air/Util/Runner.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <iostream> // To print std::cerr error message
+#include <memory>
+#include <optional>
+
+namespace xilinx {
+namespace air {
+
+// Destination of air-runner trace events. Sinks intern event names, drop
+// events rejected by the trace filter, and buffer their output before
+// writing it to the trace stream.
+class traceSink {
+
+public:
+  traceSink(llvm::raw_ostream &s) : os(s) {}
+  virtual ~traceSink() = default;
+
+  virtual void emitStart() {}
+  virtual void emitEnd() { flush(); }
+
+  // Duration event; ph is "B" (begin) or "E" (end). Timestamp is in ns.
+  virtual void emitEvent(unsigned name_id, llvm::StringRef cat,
+                         llvm::StringRef ph, uint64_t ts, int64_t tid,
+                         int64_t pid) = 0;
+
+  // Metadata event, e.g. process_name or thread_sort_index
+  virtual void emitMetadataEvent(llvm::StringRef item_name,
+                                 llvm::StringRef arg_name,
+                                 llvm::StringRef arg_entry, int64_t pid,
+                                 int64_t tid = -1) = 0;
+
+  // Intern the trace name of a dependency graph vertex, i.e. its event name
+  // followed by its detailed description, given the string table of its
+  // dependency context
+  unsigned internEventName(const dependencyNodeEntry &node,
+                           const dependencyStringTable &strings) {
+    auto key = std::make_pair(node.asyncEventNameId,
+                              node.detailedDescriptionId);
+    auto it = event_name_ids.find(key);
+    if (it != event_name_ids.end())
+      return it->second;
+    unsigned id = event_names.size();
+    event_names.push_back(
+        (node.getAsyncEventName(strings) + node.getDetailedDescription(strings))
+            .str());
+    event_name_ids[key] = id;
+    return id;
+  }
+
+  llvm::StringRef getEventName(unsigned name_id) const {
+    return event_names[name_id];
+  }
+
+  // Parse a comma-separated list of hierarchy levels (launch, segment, herd)
+  // and event kinds (e.g. dma, channel, execute) to keep. An empty list keeps
+  // everything.
+  void setFilter(llvm::StringRef filter) {
+    level_filter.clear();
+    kind_filter.clear();
+    llvm::SmallVector<llvm::StringRef> entries;
+    filter.split(entries, ',', -1, false);
+    for (auto entry : entries) {
+      entry = entry.trim();
+      if (entry == "launch" || entry == "segment" || entry == "herd")
+        level_filter.insert(entry);
+      else if (auto kind = getAsyncEventKindFromName(entry))
+        kind_filter.insert((unsigned)*kind);
+      else
+        runner_assertion(false, "unknown trace filter entry '" + entry.str() +
+                                    "'");
+    }
+  }
+
+  bool accepts(llvm::StringRef hierarchy_level, asyncEventKind kind) const {
+    if (!level_filter.empty() && !level_filter.contains(hierarchy_level))
+      return false;
+    if (!kind_filter.empty() && !kind_filter.contains((unsigned)kind))
+      return false;
+    return true;
+  }
+
+protected:
+  llvm::raw_ostream &os;
+  llvm::SmallString<0> buffer;
+
+  // Write buffered output to the trace stream once it exceeds the threshold
+  void flushIfFull() {
+    if (buffer.size() >= flush_threshold)
+      flush();
+  }
+  void flush() {
+    os << buffer;
+    buffer.clear();
+  }
+
+private:
+  static constexpr size_t flush_threshold = 1 << 20;
+
+  std::vector<std::string> event_names;
+  llvm::DenseMap<std::pair<unsigned, unsigned>, unsigned> event_name_ids;
+  llvm::StringSet<> level_filter;
+  llvm::DenseSet<unsigned> kind_filter;
+
+  static std::optional<asyncEventKind>
+  getAsyncEventKindFromName(llvm::StringRef name) {
+    return llvm::StringSwitch<std::optional<asyncEventKind>>(name)
+        .Case("start", asyncEventKind::start)
+        .Case("execute", asyncEventKind::execute)
+        .Case("dma", asyncEventKind::dma)
+        .Case("channel", asyncEventKind::channel)
+        .Case("hierarchy", asyncEventKind::hierarchy)
+        .Case("hierarchy_terminator", asyncEventKind::hierarchy_terminator)
+        .Case("terminator", asyncEventKind::terminator)
+        .Case("for_loop", asyncEventKind::for_loop)
+        .Case("parallel_loop", asyncEventKind::parallel_loop)
+        .Case("wait_all", asyncEventKind::wait_all)
+        .Default(std::nullopt);
+  }
+
+  void runner_assertion(bool cond, std::string msg = "") const {
+    if (!cond) {
+      std::cerr << "ERROR: " << msg << "\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+};
+
+// Chrome trace event format (JSON). The pretty layout writes one field per
+// line, matching the original air-runner output; the compact layout writes
+// one event per line.
+class jsonTraceSink : public traceSink {
+
+public:
+  jsonTraceSink(llvm::raw_ostream &s, bool compact)
+      : traceSink(s), compact(compact) {}
+  ~jsonTraceSink() override { flush(); }
+
+  void emitStart() override { buffer += "[\n"; }
+
+  void emitEnd() override {
+    buffer += "{}]\n";
+    flush();
+  }
+
+  void emitEvent(unsigned name_id, llvm::StringRef cat, llvm::StringRef ph,
+                 uint64_t ts, int64_t tid, int64_t pid) override {
+    llvm::raw_svector_ostream s(buffer);
+    if (compact) {
+      s << "{\"name\":\"" << getEventName(name_id) << "\",\"cat\":\"" << cat
+        << "\",\"ph\":\"" << ph << "\",\"ts\":";
+      writeTimeStamp(s, ts);
+      s << ",\"pid\":" << pid << ",\"tid\":" << tid << ",\"args\":{}},\n";
+    } else {
+      s << "{\n  \"name\": \"" << getEventName(name_id) << "\",\n  \"cat\": \""
+        << cat << "\",\n  \"ph\": \"" << ph << "\",\n  \"ts\": ";
+      writeTimeStamp(s, ts);
+      s << ",\n  \"pid\": " << pid << ",\n  \"tid\": " << tid
+        << ",\n  \"args\": {}\n},\n";
+    }
+    flushIfFull();
+  }
+
+  void emitMetadataEvent(llvm::StringRef item_name, llvm::StringRef arg_name,
+                         llvm::StringRef arg_entry, int64_t pid,
+                         int64_t tid = -1) override {
+    llvm::raw_svector_ostream s(buffer);
+    if (compact) {
+      s << "{\"name\":\"" << item_name << "\",\"ph\":\"M\",\"pid\":" << pid;
+      if (tid != -1)
+        s << ",\"tid\":" << tid;
+      s << ",\"args\":{\"" << arg_name << "\":\"" << arg_entry << "\"}},\n";
+    } else {
+      s << "{\n  \"name\": \"" << item_name << "\",\n  \"ph\": \"M\",\n"
+        << "  \"pid\": " << pid << ",\n";
+      if (tid != -1)
+        s << "  \"tid\": " << tid << ",\n";
+      s << "  \"args\": {\n    \"" << arg_name << "\": \"" << arg_entry
+        << "\"\n  }\n},\n";
+    }
+    flushIfFull();
+  }
+
+private:
+  bool compact;
+
+  // Chrome trace timestamps are in us; write ns as us with 3 d.p.
+  void writeTimeStamp(llvm::raw_ostream &s, uint64_t ts) {
+    uint64_t frac_part = ts % 1000;
+    s << ts / 1000 << ".";
+    if (frac_part < 10)
+      s << "00";
+    else if (frac_part < 100)
+      s << "0";
+    s << frac_part;
+  }
+};
+
+// Perfetto trace format (protobuf), written without depending on the
+// Perfetto SDK. Each hierarchy op becomes a process track and each thread id
+// a thread track; event names are interned per trace.
+class perfettoTraceSink : public traceSink {
+
+public:
+  perfettoTraceSink(llvm::raw_ostream &s) : traceSink(s) {}
+  ~perfettoTraceSink() override { flush(); }
+
+  void emitEvent(unsigned name_id, llvm::StringRef cat, llvm::StringRef ph,
+                 uint64_t ts, int64_t tid, int64_t pid) override {
+    auto track_uuid = getThreadTrack(pid, tid);
+
+    std::string event;
+    writeVarIntField(event, 9, ph == "B" ? 1 : 2); // type: slice begin/end
+    writeVarIntField(event, 11, track_uuid);       // track_uuid
+    if (ph == "B") {
+      writeVarIntField(event, 10, name_id + 1); // name_iid
+      writeBytesField(event, 22, cat);          // categories
+    }
+
+    std::string packet;
+    writeVarIntField(packet, 8, ts); // timestamp
+    if (ph == "B" && interned_event_names.insert(name_id).second) {
+      std::string event_name;
+      writeVarIntField(event_name, 1, name_id + 1); // iid
+      writeBytesField(event_name, 2, getEventName(name_id));
+      std::string interned_data;
+      writeBytesField(interned_data, 2, event_name); // event_names
+      writeBytesField(packet, 12, interned_data);
+    }
+    writeBytesField(packet, 11, event); // track_event
+    writePacket(packet, /*needs_incremental_state=*/true);
+  }
+
+  void emitMetadataEvent(llvm::StringRef item_name, llvm::StringRef arg_name,
+                         llvm::StringRef arg_entry, int64_t pid,
+                         int64_t tid = -1) override {
+    // Sort indices have no track descriptor equivalent
+    if (item_name == "process_name")
+      emitProcessTrack(pid, arg_entry);
+    else if (item_name == "thread_name")
+      emitThreadTrack(pid, tid, arg_entry);
+  }
+
+private:
+  static constexpr uint64_t sequence_id = 1;
+  bool first_packet = true;
+  llvm::DenseSet<uint64_t> described_tracks;
+  llvm::DenseSet<unsigned> interned_event_names;
+
+  static uint64_t getProcessTrackUuid(int64_t pid) {
+    return ((uint64_t)(uint32_t)pid + 1) << 32;
+  }
+  static uint64_t getThreadTrackUuid(int64_t pid, int64_t tid) {
+    return getProcessTrackUuid(pid) | ((uint64_t)(uint32_t)tid + 1);
+  }
+
+  uint64_t getThreadTrack(int64_t pid, int64_t tid) {
+    if (!described_tracks.contains(getProcessTrackUuid(pid)))
+      emitProcessTrack(pid, "");
+    auto uuid = getThreadTrackUuid(pid, tid);
+    if (!described_tracks.contains(uuid))
+      emitThreadTrack(pid, tid, "");
+    return uuid;
+  }
+
+  void emitProcessTrack(int64_t pid, llvm::StringRef name) {
+    auto uuid = getProcessTrackUuid(pid);
+    described_tracks.insert(uuid);
+    std::string process;
+    writeVarIntField(process, 1, pid); // pid
+    if (!name.empty())
+      writeBytesField(process, 6, name); // process_name
+    std::string track;
+    writeVarIntField(track, 1, uuid);   // uuid
+    writeBytesField(track, 3, process); // process
+    std::string packet;
+    writeBytesField(packet, 60, track); // track_descriptor
+    writePacket(packet, /*needs_incremental_state=*/false);
+  }
+
+  void emitThreadTrack(int64_t pid, int64_t tid, llvm::StringRef name) {
+    if (!described_tracks.contains(getProcessTrackUuid(pid)))
+      emitProcessTrack(pid, "");
+    auto uuid = getThreadTrackUuid(pid, tid);
+    described_tracks.insert(uuid);
+    std::string thread;
+    writeVarIntField(thread, 1, pid); // pid
+    writeVarIntField(thread, 2, tid); // tid
+    if (!name.empty())
+      writeBytesField(thread, 5, name); // thread_name
+    std::string track;
+    writeVarIntField(track, 1, uuid);                     // uuid
+    writeVarIntField(track, 5, getProcessTrackUuid(pid)); // parent_uuid
+    writeBytesField(track, 4, thread);                    // thread
+    std::string packet;
+    writeBytesField(packet, 60, track); // track_descriptor
+    writePacket(packet, /*needs_incremental_state=*/false);
+  }
+
+  // Wrap a TracePacket body as a Trace.packet field and append to buffer
+  void writePacket(std::string &packet, bool needs_incremental_state) {
+    writeVarIntField(packet, 10, sequence_id); // trusted_packet_sequence_id
+    unsigned flags = needs_incremental_state ? 2 : 0;
+    if (first_packet)
+      flags |= 1; // SEQ_INCREMENTAL_STATE_CLEARED
+    first_packet = false;
+    if (flags)
+      writeVarIntField(packet, 13, flags); // sequence_flags
+    std::string out;
+    writeBytesField(out, 1, packet);
+    buffer += out;
+    flushIfFull();
+  }
+
+  static void writeVarInt(std::string &s, uint64_t v) {
+    while (v >= 0x80) {
+      s.push_back((char)((v & 0x7f) | 0x80));
+      v >>= 7;
+    }
+    s.push_back((char)v);
+  }
+  static void writeVarIntField(std::string &s, unsigned field, uint64_t v) {
+    writeVarInt(s, (uint64_t)field << 3);
+    writeVarInt(s, v);
+  }
+  static void writeBytesField(std::string &s, unsigned field,
+                              llvm::StringRef bytes) {
+    writeVarInt(s, ((uint64_t)field << 3) | 2);
+    writeVarInt(s, bytes.size());
+    s.append(bytes.data(), bytes.size());
+  }
+};
+
+// Create the trace sink for a --trace-format option value
+static std::unique_ptr<traceSink> createTraceSink(llvm::raw_ostream &s,
+                                                  llvm::StringRef format) {
+  if (format == "json")
+    return std::make_unique<jsonTraceSink>(s, /*compact=*/false);
+  if (format == "json-compact")
+    return std::make_unique<jsonTraceSink>(s, /*compact=*/true);
+  if (format == "perfetto")
+    return std::make_unique<perfettoTraceSink>(s);
+  return nullptr;
+}
+
+llvm::StringRef getTraceFormats() { return "json, json-compact, perfetto"; }
+
+bool isTraceFormat(llvm::StringRef format) {
+  return format == "json" || format == "json-compact" || format == "perfetto";
+}
+
+} // namespace air
+} // namespace xilinx
+
+#endif // AIR_UTIL_RUNNER_TRACE_SINK
@@ -275,6 +275,27 @@ air::getStaticAffineForTripCountAsInt(affine::AffineForOp for_op) {
   return output;
 }
 
+// Estimate the bytes moved by a channel put or get. Loops with dynamic trip
+// counts are assumed to run once.
+uint64_t air::getChannelBytes(air::ChannelInterface op, Operation *scope) {
+  auto memref = llvm::cast<MemRefType>(op.getMemref().getType());
+  uint64_t bytes = getElementSizeInBytes(memref);
+  if (op.getSizes().empty()) {
+    bytes *= getTensorVolume(memref);
+  } else {
+    for (auto size : op.getSizes())
+      bytes *= mlir::getConstantIntValue(size).value_or(1);
+  }
+  for (Operation *parent = op->getParentOp(); parent && parent != scope;
+       parent = parent->getParentOp()) {
+    if (auto for_op = dyn_cast<scf::ForOp>(parent))
+      bytes *= getStaticScfForTripCountAsInt(for_op).value_or(1);
+    else if (auto for_op = dyn_cast<affine::AffineForOp>(parent))
+      bytes *= getStaticAffineForTripCountAsInt(for_op).value_or(1);
+  }
+  return bytes;
+}
+
 // Get operation's "id" attribute
 int air::getIdAttr(Operation *op) {
   auto idAttr = op->getAttrOfType<IntegerAttr>("id");
@@ -531,6 +552,118 @@ air::getTheOtherChannelOpThroughSymbol(air::ChannelInterface op) {
     return std::vector<air::ChannelInterface>();
 }
 
+void air::ChannelUseAnalysis::rebuild() {
+  uses.clear();
+  scope->walk([&](Operation *op) {
+    if (auto put = dyn_cast<air::ChannelPutOp>(op))
+      uses[put.getChanNameAttr().getAttr()].puts.push_back(op);
+    else if (auto get = dyn_cast<air::ChannelGetOp>(op))
+      uses[get.getChanNameAttr().getAttr()].gets.push_back(op);
+  });
+  stale = false;
+}
+
+void air::ChannelUseAnalysis::insert(air::ChannelInterface op) {
+  if (stale)
+    return;
+  if (auto put = dyn_cast<air::ChannelPutOp>(op.getOperation()))
+    uses[put.getChanNameAttr().getAttr()].puts.push_back(put);
+  else if (auto get = dyn_cast<air::ChannelGetOp>(op.getOperation()))
+    uses[get.getChanNameAttr().getAttr()].gets.push_back(get);
+}
+
+void air::ChannelUseAnalysis::erase(air::ChannelOp channel) {
+  if (!stale)
+    uses.erase(SymbolTable::getSymbolName(channel));
+}
+
+const air::ChannelUseAnalysis::ChannelUses *
+air::ChannelUseAnalysis::lookup(StringAttr symbol) {
+  if (stale)
+    rebuild();
+#ifdef EXPENSIVE_CHECKS
+  // Compare against a fresh walk, to catch a channel-mutating caller which
+  // did not update the index. Ops inserted incrementally need not be in walk
+  // order.
+  auto cached = std::move(uses);
+  rebuild();
+  assert(cached.size() == uses.size() &&
+         llvm::all_of(cached,
+                      [&](auto &entry) {
+                        auto it = uses.find(entry.first);
+                        auto same = [](auto &a, auto &b) {
+                          return a.size() == b.size() &&
+                                 std::is_permutation(a.begin(), a.end(),
+                                                     b.begin());
+                        };
+                        return it != uses.end() &&
+                               same(it->second.puts, entry.second.puts) &&
+                               same(it->second.gets, entry.second.gets);
+                      }) &&
+         "stale ChannelUseAnalysis; update the index after mutating channels");
+#endif
+  auto it = uses.find(symbol);
+  if (it == uses.end())
+    return nullptr;
+  return &it->second;
+}
+
+std::vector<air::ChannelPutOp>
+air::ChannelUseAnalysis::getChannelPuts(air::ChannelOp channel) {
+  std::vector<air::ChannelPutOp> channelPuts;
+  if (!channel)
+    return channelPuts;
+  if (auto entry = lookup(SymbolTable::getSymbolName(channel)))
+    for (auto op : entry->puts)
+      channelPuts.push_back(cast<air::ChannelPutOp>(op));
+  return channelPuts;
+}
+
+std::vector<air::ChannelGetOp>
+air::ChannelUseAnalysis::getChannelGets(air::ChannelOp channel) {
+  std::vector<air::ChannelGetOp> channelGets;
+  if (!channel)
+    return channelGets;
+  if (auto entry = lookup(SymbolTable::getSymbolName(channel)))
+    for (auto op : entry->gets)
+      channelGets.push_back(cast<air::ChannelGetOp>(op));
+  return channelGets;
+}
+
+// The other ends are found by the symbol of the put/get itself, rather than
+// by resolving its channel declaration, which scans the enclosing symbol
+// tables on every call.
+std::vector<air::ChannelGetOp>
+air::ChannelUseAnalysis::getTheOtherChannelOps(air::ChannelPutOp put) {
+  std::vector<air::ChannelGetOp> channelGets;
+  if (auto entry = lookup(put.getChanNameAttr().getAttr()))
+    for (auto op : entry->gets)
+      channelGets.push_back(cast<air::ChannelGetOp>(op));
+  return channelGets;
+}
+
+std::vector<air::ChannelPutOp>
+air::ChannelUseAnalysis::getTheOtherChannelOps(air::ChannelGetOp get) {
+  std::vector<air::ChannelPutOp> channelPuts;
+  if (auto entry = lookup(get.getChanNameAttr().getAttr()))
+    for (auto op : entry->puts)
+      channelPuts.push_back(cast<air::ChannelPutOp>(op));
+  return channelPuts;
+}
+
+std::vector<air::ChannelInterface>
+air::ChannelUseAnalysis::getTheOtherChannelOps(air::ChannelInterface op) {
+  std::vector<air::ChannelInterface> output;
+  if (auto put = dyn_cast<air::ChannelPutOp>(op.getOperation())) {
+    for (auto v : getTheOtherChannelOps(put))
+      output.push_back(dyn_cast<air::ChannelInterface>(v.getOperation()));
+  } else if (auto get = dyn_cast<air::ChannelGetOp>(op.getOperation())) {
+    for (auto v : getTheOtherChannelOps(get))
+      output.push_back(dyn_cast<air::ChannelInterface>(v.getOperation()));
+  }
+  return output;
+}
+
 // Get sizes from integerset
 void air::getSizesFromIntegerSet(MLIRContext *ctx, IntegerSet int_set,
                                  SmallVector<int, 2> &lbs_int,
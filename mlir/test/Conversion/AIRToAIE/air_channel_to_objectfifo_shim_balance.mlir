@@ -0,0 +1,40 @@
+//===- air_channel_to_objectfifo_shim_balance.mlir -------------*- MLIR -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+// RUN: air-opt %s --air-to-aie='test-patterns=lower-air-channels' | FileCheck %s
+// RUN: air-opt %s --air-to-aie='test-patterns=lower-air-channels' 2>&1 >/dev/null | FileCheck %s --check-prefix=REMARK
+
+// The L3 channel moving the most bytes gets the shim column closest to its
+// core. The other one goes to the next least loaded column rather than
+// sharing the first one.
+// CHECK-LABEL:   aie.device(xcvc1902) {
+// CHECK-DAG:   %[[CORE:.*]] = aie.tile(2, 1)
+// CHECK-DAG:   %[[SHIM0:.*]] = aie.tile(2, 0)
+// CHECK-DAG:   %[[SHIM1:.*]] = aie.tile(3, 0)
+// CHECK-DAG:   aie.objectfifo @{{.*}}(%[[SHIM0]], {%[[CORE]]}, 1 : i32) : !aie.objectfifo<memref<32xi32>>
+// CHECK-DAG:   aie.objectfifo @{{.*}}(%[[SHIM1]], {%[[CORE]]}, 1 : i32) : !aie.objectfifo<memref<32xi32>>
+
+// REMARK: remark: shim dma load in bytes per column: col 2: mm2s 16384, s2mm 0; col 3: mm2s 128, s2mm 0;
+
+aie.device(xcvc1902) {
+  %0 = aie.tile(2, 1)
+  air.channel @channel_0 [1, 1]
+  air.channel @channel_1 [1, 1]
+  %1 = aie.core(%0) {
+    %c32 = arith.constant 32 : index
+    %c0 = arith.constant 0 : index
+    %alloc = memref.alloc() {sym_name = "weights"} : memref<32xi32, 2>
+    %alloc_0 = memref.alloc() {sym_name = "scratch"} : memref<32xi32, 2>
+    air.channel.get @channel_1[] (%alloc[%c0] [%c32] [%c0]) : (memref<32xi32, 2>)
+    affine.for %arg0 = 0 to 4096 step 32 {
+      air.channel.get @channel_0[] (%alloc_0[%c0] [%c32] [%c0]) : (memref<32xi32, 2>)
+    }
+    memref.dealloc %alloc_0 : memref<32xi32, 2>
+    memref.dealloc %alloc : memref<32xi32, 2>
+    aie.end
+  } {elf_file = "segment_0_core_2_1.elf"}
+}
@@ -123,12 +123,17 @@ func.func @herd_1(%arg0: i32, %arg1: i32) -> () {
 
 // CHECK: memref.global "private" @channel_0 : memref<1x1xi64> = dense<0>
 // CHECK-LABEL: channel_get_put_0
+// CHECK: %[[CHAN:.*]] = memref.get_global @channel_0 : memref<1x1xi64>
+// CHECK: %[[CAST:.*]] = memref.cast %[[CHAN]] : memref<1x1xi64> to memref<?x?xi64>
+// CHECK: call @air_channel_create_M0D2I64_I64_I64_I64_I64_I64(%[[CAST]],
 // CHECK: memref.get_global @channel_0 : memref<1x1xi64>
 // CHECK: %[[T0:.*]] = async.execute {
 // CHECK-NEXT: call @air_channel_get_M0D2I64_M0D2F32
 // CHECK-NEXT: async.yield
 // CHECK: async.await %[[T0]] : !async.token
-// CHECK: call @air_channel_put_M0D2I64_I64_I64_I64_I64_M0D2F32_I64_I64_I64_I64_I64_I64(
+// CHECK: call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_M0D2F32_I64_I64_I64_I64_I64_I64(
+// CHECK: call @air_channel_destroy_M0D2I64(
+// CHECK-NEXT: return
 air.channel @channel_0 [1]
 func.func @channel_get_put_0(%arg0 : memref<16x16xf32>, %arg1 : memref<16x16xf32>) -> () {
   %alloc = memref.alloc() : memref<8x8xf32>
@@ -145,7 +150,7 @@ func.func @channel_get_put_0(%arg0 : memref<16x16xf32>, %arg1 : memref<16x16xf32
 // CHECK-LABEL: channel_get_put_3_3
 // CHECK: memref.get_global @channel_1 : memref<3x3xi64>
 // CHECK: call @air_channel_get_M0D2I64_I64_I64_M0D2F32
-// CHECK: call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_M0D2F32_I64_I64_I64_I64_I64_I64
+// CHECK: call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D2F32_I64_I64_I64_I64_I64_I64
 air.channel @channel_1 [3,3]
 func.func @channel_get_put_3_3(%arg0 : memref<9x9xf32>) -> () {
   %c3 = arith.constant 1 : index
@@ -160,6 +165,41 @@ func.func @channel_get_put_3_3(%arg0 : memref<9x9xf32>) -> () {
   return
 }
 
+// CHECK: memref.global "private" @channel_2 : memref<1x1xi64> = dense<0> {buffer_resources = 2 : i64}
+// CHECK-LABEL: channel_get_put_depth_2
+// CHECK: %[[CREATE_DEPTH:.*]] = arith.constant 2 : index
+// CHECK: call @air_channel_create_M0D2I64_I64_I64_I64_I64_I64(%{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %[[CREATE_DEPTH]])
+// CHECK: %[[DEPTH:.*]] = arith.constant 2 : index
+// CHECK: call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D2F32_I64_I64_I64_I64_I64_I64(%{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %[[DEPTH]],
+air.channel @channel_2 [1, 1] {buffer_resources = 2}
+func.func @channel_get_put_depth_2(%arg0 : memref<8x8xf32>, %arg1 : memref<8x8xf32>) -> () {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+  air.channel.put @channel_2[%c0, %c0] (%arg0[%c0, %c0] [%c8, %c8] [%c8, %c1]) : (memref<8x8xf32>)
+  air.channel.get @channel_2[%c0, %c0] (%arg1[%c0, %c0] [%c8, %c8] [%c8, %c1]) : (memref<8x8xf32>)
+  return
+}
+
+// The asynchronous put is awaited before the channel is destroyed.
+// CHECK-LABEL: channel_put_async_destroy
+// CHECK: %[[T0:.*]] = async.execute {
+// CHECK-NEXT: call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D2F32_I64_I64_I64_I64_I64_I64(
+// CHECK-NEXT: async.yield
+// CHECK: %[[CHAN:.*]] = memref.get_global @channel_3 : memref<1x1xi64>
+// CHECK-NEXT: %[[CAST:.*]] = memref.cast %[[CHAN]]
+// CHECK-NEXT: async.await %[[T0]] : !async.token
+// CHECK-NEXT: call @air_channel_destroy_M0D2I64(%[[CAST]])
+// CHECK-NEXT: return
+air.channel @channel_3 [1, 1]
+func.func @channel_put_async_destroy(%arg0 : memref<8x8xf32>) -> () {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+  %e = air.channel.put async @channel_3[%c0, %c0] (%arg0[%c0, %c0] [%c8, %c8] [%c8, %c1]) : (memref<8x8xf32>)
+  return
+}
+
 // CHECK-LABEL: @scf_par
 // CHECK: %[[C0:.*]] = arith.constant 0 : index
 // CHECK: %[[C32:.*]] = arith.constant 32 : index
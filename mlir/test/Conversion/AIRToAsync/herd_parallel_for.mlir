@@ -0,0 +1,82 @@
+//===- herd_parallel_for.mlir ----------------------------------*- MLIR -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+// RUN: air-opt %s -air-to-async="herd-executor=parallel-for executor-workers=4" | FileCheck %s
+
+// CHECK-LABEL: func.func @herd_1
+// CHECK: %[[EXE:.*]] = async.execute [%{{.*}}, %{{.*}}] {
+// CHECK:   %[[TOTAL:.*]] = arith.constant 6 : index
+// CHECK:   %[[WORKERS:.*]] = arith.constant 4 : index
+// CHECK:   %[[CHUNK:.*]] = arith.constant 1 : index
+// CHECK:   %[[HANDLE:.*]] = call @air_executor_begin_rI64_I64_I64_I64(%[[TOTAL]], %[[WORKERS]], %[[CHUNK]]) : (index, index, index) -> index
+// CHECK:   %[[NUM:.*]] = call @air_executor_workers_rI64_I64(%[[HANDLE]]) : (index) -> index
+// CHECK:   %[[GROUP:.*]] = async.create_group %[[NUM]] : !async.group
+// CHECK:   scf.for %[[WORKER:.*]] = %{{.*}} to %[[NUM]] step %{{.*}} {
+// CHECK:     %[[TASK:.*]] = async.execute {
+// CHECK:       scf.while : () -> index {
+// CHECK:         %[[NEXT:.*]] = call @air_executor_next_rI64_I64_I64(%[[HANDLE]], %[[WORKER]]) : (index, index) -> index
+// CHECK:         %[[MORE:.*]] = arith.cmpi ult, %[[NEXT]], %[[TOTAL]] : index
+// CHECK:         scf.condition(%[[MORE]]) %[[NEXT]] : index
+// CHECK:       } do {
+// CHECK:       ^bb0(%[[TILE:.*]]: index):
+// CHECK:         %[[C3:.*]] = arith.constant 3 : index
+// CHECK:         %[[Y:.*]] = arith.remui %[[TILE]], %[[C3]] : index
+// CHECK:         %[[ROW:.*]] = arith.divui %[[TILE]], %[[C3]] : index
+// CHECK:         %[[C2:.*]] = arith.constant 2 : index
+// CHECK:         %[[X:.*]] = arith.remui %[[ROW]], %[[C2]] : index
+// CHECK:         arith.addi %[[X]], %[[Y]] : index
+// CHECK:         arith.muli
+// CHECK:         arith.addi %{{.*}}, %{{.*}} : i32
+// CHECK:         scf.yield
+// CHECK:       }
+// CHECK:       async.yield
+// CHECK:     }
+// CHECK:     async.add_to_group %[[TASK]], %[[GROUP]] : !async.token
+// CHECK:   }
+// CHECK:   async.await_all %[[GROUP]]
+// CHECK:   call @air_executor_end_I64(%[[HANDLE]]) : (index) -> ()
+// CHECK:   async.yield
+// CHECK: }
+// CHECK: async.await %[[EXE]] : !async.token
+// CHECK: return
+func.func @herd_1(%arg0: i32, %arg1: i32) -> () {
+  %c2 = arith.constant 2 : index
+  %c3 = arith.constant 3 : index
+  %e0 = air.wait_all async
+  %e1, %alloc = air.execute -> (memref<32xi32>) {
+    %3 = memref.alloc() : memref<32xi32>
+    air.execute_terminator %3 : memref<32xi32>
+  }
+  %e2 = air.herd async [%e0, %e1] tile (%x, %y) in (%sx=%c2, %sy=%c3) args (%op0=%arg0, %op1=%arg1) : i32, i32 attributes { } {
+    %0 = arith.addi %x, %y : index
+    %1 = arith.muli %sx, %sy : index
+    %2 = arith.addi %op0, %op1 : i32
+  }
+  air.wait_all [%e2]
+  return
+}
+
+// A launch and its herd both use the executor.
+// CHECK-LABEL: func.func @launch_herd
+// CHECK: call @air_executor_begin_rI64_I64_I64_I64
+// CHECK: scf.while
+// CHECK: call @air_executor_begin_rI64_I64_I64_I64
+// CHECK: scf.while
+// CHECK: call @air_executor_end_I64
+// CHECK: call @air_executor_end_I64
+// CHECK-NOT: air.launch
+// CHECK-NOT: air.herd
+func.func @launch_herd(%arg0: i32) -> () {
+  %c2 = arith.constant 2 : index
+  air.launch (%lx, %ly) in (%lsx=%c2, %lsy=%c2) args (%a0=%arg0) : i32 {
+    %c4 = arith.constant 4 : index
+    air.herd tile (%x, %y) in (%sx=%c4, %sy=%c4) args (%op0=%a0) : i32 {
+      %0 = arith.addi %op0, %op0 : i32
+    }
+  }
+  return
+}
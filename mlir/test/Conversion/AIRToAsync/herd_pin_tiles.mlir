@@ -0,0 +1,32 @@
+//===- herd_pin_tiles.mlir -------------------------------------*- MLIR -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+// RUN: air-opt %s -air-to-async="pin-herd-tiles=true" | FileCheck %s
+// RUN: air-opt %s -air-to-async | FileCheck %s --check-prefix=NOPIN
+
+// CHECK-LABEL: func.func @herd_1
+// CHECK: affine.for %[[X:.*]] = 0 to 2 {
+// CHECK:   affine.for %[[Y:.*]] = 0 to 3 {
+// CHECK:     async.execute {
+// CHECK:       %[[SX:.*]] = arith.constant 2 : index
+// CHECK:       %[[SY:.*]] = arith.constant 3 : index
+// CHECK:       call @air_herd_pin_tile_I64_I64_I64_I64(%[[X]], %[[Y]], %[[SX]], %[[SY]]) : (index, index, index, index) -> ()
+// CHECK:       arith.addi %[[X]], %[[Y]] : index
+// CHECK:       call @air_herd_unpin_tile() : () -> ()
+// CHECK-NEXT:  async.yield
+// CHECK-DAG: func.func private @air_herd_pin_tile_I64_I64_I64_I64(index, index, index, index)
+// CHECK-DAG: func.func private @air_herd_unpin_tile()
+// NOPIN-NOT: air_herd_{{(un)?}}pin_tile
+func.func @herd_1(%arg0: i32, %arg1: i32) -> () {
+  %c2 = arith.constant 2 : index
+  %c3 = arith.constant 3 : index
+  air.herd tile (%x, %y) in (%sx=%c2, %sy=%c3) args (%op0=%arg0, %op1=%arg1) : i32, i32 {
+    %0 = arith.addi %x, %y : index
+    %1 = arith.addi %op0, %op1 : i32
+  }
+  return
+}
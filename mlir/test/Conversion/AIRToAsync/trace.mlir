@@ -0,0 +1,60 @@
+//===- trace.mlir ----------------------------------------------*- MLIR -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+// RUN: air-opt %s -air-to-async="trace=true" | FileCheck %s
+// RUN: air-opt %s -air-to-async | FileCheck %s --check-prefix=NOTRACE
+
+// CHECK: memref.global "private" @channel_0 : memref<1x2xi64> = dense<0>
+// CHECK: memref.global "private" constant @__air_trace_name_channel_0 : memref<9xi8> = dense<[99, 104, 97, 110, 110, 101, 108, 95, 48]>
+// CHECK-LABEL: func.func @herd_trace
+// CHECK: %[[CHAN:.*]] = memref.cast %{{.*}} : memref<1x2xi64> to memref<?x?xi64>
+// CHECK: call @air_channel_create_M0D2I64_I64_I64_I64_I64_I64(%[[CHAN]],
+// CHECK: %[[NAME:.*]] = memref.get_global @__air_trace_name_channel_0 : memref<9xi8>
+// CHECK: %[[NAME_CAST:.*]] = memref.cast %[[NAME]] : memref<9xi8> to memref<?xi8>
+// CHECK: call @air_trace_channel_name_M0D2I64_M0D1I8(%[[CHAN]], %[[NAME_CAST]]) : (memref<?x?xi64>, memref<?xi8>) -> ()
+
+// The first herd keeps its id.
+// CHECK: async.execute {
+// CHECK:   %[[ID:.*]] = arith.constant 3 : index
+// CHECK:   %[[SX:.*]] = arith.constant 1 : index
+// CHECK:   %[[SY:.*]] = arith.constant 2 : index
+// CHECK:   %[[BEGIN:.*]] = call @air_trace_herd_begin_rI64_I64_I64_I64(%[[ID]], %[[SX]], %[[SY]]) : (index, index, index) -> index
+// CHECK:   affine.for %[[X:.*]] = 0 to 1 {
+// CHECK:     affine.for %[[Y:.*]] = 0 to 2 {
+// CHECK:       async.execute {
+// CHECK:         %[[TILE:.*]] = call @air_trace_tile_begin_rI64_I64_I64_I64_I64_I64_I64(%[[ID]], %[[BEGIN]], %[[X]], %[[Y]], %{{.*}}, %{{.*}}) : (index, index, index, index, index, index) -> index
+// CHECK:         call @air_channel_get_M0D2I64_I64_I64_M0D2F32
+// CHECK:         call @air_trace_tile_end_I64(%[[TILE]]) : (index) -> ()
+// CHECK-NEXT:    async.yield
+// CHECK:   async.await_all
+// CHECK:   call @air_trace_herd_end_I64_I64(%[[ID]], %[[BEGIN]]) : (index, index) -> ()
+// CHECK:   async.yield
+
+// The second herd is numbered after it.
+// CHECK: %[[ID2:.*]] = arith.constant 4 : index
+// CHECK: call @air_trace_herd_begin_rI64_I64_I64_I64(%[[ID2]],
+
+// NOTRACE-NOT: __air_trace_name
+// NOTRACE-NOT: air_trace_
+air.channel @channel_0 [1, 2]
+func.func @herd_trace(%arg0 : memref<8x8xf32>) -> () {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c2 = arith.constant 2 : index
+  %c8 = arith.constant 8 : index
+  air.channel.put @channel_0[%c0, %c0] (%arg0[] [] []) : (memref<8x8xf32>)
+  air.channel.put @channel_0[%c0, %c1] (%arg0[] [] []) : (memref<8x8xf32>)
+  air.herd tile (%x, %y) in (%sx=%c1, %sy=%c2) attributes {id = 3 : i32} {
+    %alloc = memref.alloc() : memref<8x8xf32>
+    air.channel.get @channel_0[%x, %y] (%alloc[] [] []) : (memref<8x8xf32>)
+    memref.dealloc %alloc : memref<8x8xf32>
+  }
+  air.herd tile (%x, %y) in (%sx=%c1, %sy=%c1) {
+    %0 = arith.addi %x, %y : index
+  }
+  return
+}
@@ -623,3 +623,63 @@ module {
     return
   }
 }
+
+// Multi-buffering with three buffers: each buffer has its own loop-carried
+// free token, and producers and consumers rotate through the buffers in order.
+// CHECK-LABEL: triple_buffer
+// CHECK: %[[EVENT0:.*]]:5 = scf.for {{.*}} iter_args(%[[EVENT1:.*]] = {{.*}} %[[EVENT2:.*]] = {{.*}} %[[EVENT3:.*]] = {{.*}} %[[EVENT4:.*]] = {{.*}} %[[EVENT5:.*]] = {{.*}})
+// CHECK: %[[GET0:.*]] = air.channel.get async [%[[EVENT5]], %[[EVENT1]]] @channel_13[]
+// CHECK: %[[PUT0:.*]] = air.channel.put async [%[[EVENT4]], %[[GET0]]] @channel_14[]
+// CHECK: %[[GET1:.*]] = air.channel.get async [%[[GET0]], %[[EVENT2]]] @channel_13[]
+// CHECK: %[[PUT1:.*]] = air.channel.put async [%[[PUT0]], %[[GET1]]] @channel_14[]
+// CHECK: %[[GET2:.*]] = air.channel.get async [%[[GET1]], %[[EVENT3]]] @channel_13[]
+// CHECK: %[[PUT2:.*]] = air.channel.put async [%[[PUT1]], %[[GET2]]] @channel_14[]
+// CHECK: scf.yield %[[PUT0]], %[[PUT1]], %[[PUT2]], %[[PUT2]], %[[GET2]] : !air.async.token, !air.async.token, !air.async.token, !air.async.token, !air.async.token
+
+air.channel @channel_14 [1, 1]
+air.channel @channel_13 [1, 1]
+func.func @triple_buffer() {
+  %c1 = arith.constant 1 : index
+  %0 = air.launch async (%arg0, %arg1) in (%arg2=%c1, %arg3=%c1) attributes {id = 1 : i32} {
+    %1 = air.segment async attributes {id = 2 : i32} {
+      %c1_0 = arith.constant 1 : index
+      %2 = air.herd @herd_0 async tile (%arg4, %arg5) in (%arg6=%c1_0, %arg7=%c1_0) attributes {id = 3 : i32} {
+        %c0 = arith.constant 0 : index
+        %c96 = arith.constant 96 : index
+        %c32 = arith.constant 32 : index
+        %3 = air.wait_all async
+        %async_token, %results = air.execute [%3] -> (memref<32x32xbf16, 2>) {
+          %alloc = memref.alloc() : memref<32x32xbf16, 2>
+          air.execute_terminator %alloc : memref<32x32xbf16, 2>
+        } {unrolled_iteration = 2 : i32}
+        %async_token_0, %results_1 = air.execute [%async_token] -> (memref<32x32xbf16, 2>) {
+          %alloc = memref.alloc() : memref<32x32xbf16, 2>
+          air.execute_terminator %alloc : memref<32x32xbf16, 2>
+        } {unrolled_iteration = 1 : i32}
+        %async_token_2, %results_3 = air.execute [%async_token_0] -> (memref<32x32xbf16, 2>) {
+          %alloc = memref.alloc() : memref<32x32xbf16, 2>
+          air.execute_terminator %alloc : memref<32x32xbf16, 2>
+        } {unrolled_iteration = 0 : i32}
+        %4 = scf.for %arg8 = %c0 to %c96 step %c32 iter_args(%arg9 = %async_token_2) -> (!air.async.token) {
+          %5 = air.channel.get async [%arg9]  @channel_13[] (%results_3[] [] []) {async_front = true, unrolled_iteration = 0 : i32} : (memref<32x32xbf16, 2>)
+          %6 = air.channel.put async [%5]  @channel_14[] (%results_3[] [] []) {async_back = true, unrolled_iteration = 0 : i32} : (memref<32x32xbf16, 2>)
+          %7 = air.channel.get async [%6]  @channel_13[] (%results_1[] [] []) {async_front = true, unrolled_iteration = 1 : i32} : (memref<32x32xbf16, 2>)
+          %8 = air.channel.put async [%7]  @channel_14[] (%results_1[] [] []) {async_back = true, unrolled_iteration = 1 : i32} : (memref<32x32xbf16, 2>)
+          %9 = air.channel.get async [%8]  @channel_13[] (%results[] [] []) {async_front = true, unrolled_iteration = 2 : i32} : (memref<32x32xbf16, 2>)
+          %10 = air.channel.put async [%9]  @channel_14[] (%results[] [] []) {async_back = true, unrolled_iteration = 2 : i32} : (memref<32x32xbf16, 2>)
+          scf.yield %10 : !air.async.token
+        } {unroll = 3 : i32}
+        %async_token_4 = air.execute [%4] {
+          memref.dealloc %results_3 : memref<32x32xbf16, 2>
+        } {unrolled_iteration = 0 : i32}
+        %async_token_5 = air.execute [%4] {
+          memref.dealloc %results_1 : memref<32x32xbf16, 2>
+        } {unrolled_iteration = 1 : i32}
+        %async_token_6 = air.execute [%4] {
+          memref.dealloc %results : memref<32x32xbf16, 2>
+        } {unrolled_iteration = 2 : i32}
+      }
+    }
+  }
+  return
+}
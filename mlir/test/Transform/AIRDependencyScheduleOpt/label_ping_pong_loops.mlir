@@ -6,12 +6,24 @@
 //===----------------------------------------------------------------------===//
 
 // RUN: air-opt %s -air-label-scf-for-to-ping-pong | FileCheck %s
+// RUN: air-opt %s -air-label-scf-for-to-ping-pong="max-buffers=4" | FileCheck %s --check-prefix=MULTI
+// RUN: air-opt %s -air-label-scf-for-to-ping-pong="max-buffers=4 l1-size=6144" | FileCheck %s --check-prefix=SMALL
 
 // Label scf.for and memref.alloc as target for ping-pong transformation.
 // CHECK: memref.alloc() {hoist_alloc = true}
 // CHECK: scf.yield
 // CHECK-NEXT: } {unroll = 2 : i32}
 
+// Four 2 KB buffers fit in L1 and divide the trip count of 8.
+// MULTI: memref.alloc() {hoist_alloc = true}
+// MULTI: scf.yield
+// MULTI-NEXT: } {unroll = 4 : i32}
+
+// Three buffers fit in 6 KB of L1, but do not divide the trip count.
+// SMALL: memref.alloc() {hoist_alloc = true}
+// SMALL: scf.yield
+// SMALL-NEXT: } {unroll = 2 : i32}
+
 module {
   func.func @test(%arg0: memref<256x1024xbf16>, %arg1: memref<1024x1024xbf16>, %arg2: memref<1024x1024xbf16>, %arg3: memref<1024x1024xbf16>) {
     %c1 = arith.constant 1 : index
@@ -0,0 +1,57 @@
+//===- label_ping_pong_sibling_loops.mlir ----------------------*- MLIR -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+// RUN: air-opt %s -air-label-scf-for-to-ping-pong="max-buffers=4 l1-size=65536" | FileCheck %s
+// RUN: air-opt %s -air-label-scf-for-to-ping-pong="max-buffers=4 l1-size=98304" | FileCheck %s --check-prefix=LARGE
+
+// Two loops in a herd, each with a 16 KB buffer, share the L1 budget: three
+// buffers each would take 96 KB of the 64 KB, so each gets two.
+// CHECK: memref.alloc() {hoist_alloc = true} : memref<64x64xi32, 2>
+// CHECK: scf.yield
+// CHECK-NEXT: } {unroll = 2 : i32}
+// CHECK: memref.alloc() {hoist_alloc = true} : memref<64x64xi32, 2>
+// CHECK: scf.yield
+// CHECK-NEXT: } {unroll = 2 : i32}
+
+// With 96 KB, three buffers each fit.
+// LARGE: scf.yield
+// LARGE-NEXT: } {unroll = 3 : i32}
+// LARGE: scf.yield
+// LARGE-NEXT: } {unroll = 3 : i32}
+
+module {
+  func.func @sibling_loops() {
+    %c1 = arith.constant 1 : index
+    %0 = air.herd @herd_0 async tile (%arg0, %arg1) in (%arg2=%c1, %arg3=%c1) {
+      %c0 = arith.constant 0 : index
+      %c64 = arith.constant 64 : index
+      %c384 = arith.constant 384 : index
+      %async_token_0 = air.wait_all async
+      %1 = scf.for %arg4 = %c0 to %c384 step %c64 iter_args(%arg5 = %async_token_0) -> (!air.async.token) {
+        %async_token_1, %results_1 = air.execute [%arg5] -> (memref<64x64xi32, 2>) {
+          %alloc = memref.alloc() : memref<64x64xi32, 2>
+          air.execute_terminator %alloc : memref<64x64xi32, 2>
+        }
+        %async_token_2 = air.execute [%async_token_1] {
+          memref.dealloc %results_1 : memref<64x64xi32, 2>
+        }
+        scf.yield %async_token_2 : !air.async.token
+      }
+      %2 = scf.for %arg4 = %c0 to %c384 step %c64 iter_args(%arg5 = %1) -> (!air.async.token) {
+        %async_token_1, %results_1 = air.execute [%arg5] -> (memref<64x64xi32, 2>) {
+          %alloc = memref.alloc() : memref<64x64xi32, 2>
+          air.execute_terminator %alloc : memref<64x64xi32, 2>
+        }
+        %async_token_2 = air.execute [%async_token_1] {
+          memref.dealloc %results_1 : memref<64x64xi32, 2>
+        }
+        scf.yield %async_token_2 : !air.async.token
+      }
+    }
+    return
+  }
+}
@@ -0,0 +1,47 @@
+//===- communication_aware.mlir --------------------------------*- MLIR -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+// RUN: air-opt %s -air-place-herds="num-rows=3 num-cols=4" | FileCheck %s --check-prefix=NAIVE
+// RUN: air-opt %s -air-place-herds="num-rows=3 num-cols=4 placement=communication" | FileCheck %s
+
+// The naive placement puts the largest herd on the bottom row, next to the
+// memtiles, although it does not communicate.
+// NAIVE: air.herd @filler {{.*}} attributes {x_loc = 0 {{.*}} y_loc = 0
+
+// The consumer herd, which writes to L2, moves to the bottom row with its
+// producer next to it.
+// CHECK: air.herd @filler {{.*}} attributes {x_loc = 0 {{.*}} y_loc = 1
+// CHECK: air.herd @producer {{.*}} attributes {x_loc = 1 {{.*}} y_loc = 0
+// CHECK: air.herd @consumer {{.*}} attributes {x_loc = 0 {{.*}} y_loc = 0
+
+air.channel @chan_a [1, 1]
+air.channel @chan_b [1, 1]
+func.func @producer_consumer() {
+  %c1 = arith.constant 1 : index
+  air.segment @segment_0 {
+    %c1_0 = arith.constant 1 : index
+    %c4 = arith.constant 4 : index
+    air.herd @filler tile (%x, %y) in (%sx=%c4, %sy=%c1_0) {
+      %0 = arith.addi %x, %y : index
+    }
+    air.herd @producer tile (%x, %y) in (%sx=%c1_0, %sy=%c1_0) {
+      %buf = memref.alloc() : memref<32x32xi32, 2>
+      air.channel.put @chan_a[] (%buf[] [] []) : (memref<32x32xi32, 2>)
+      memref.dealloc %buf : memref<32x32xi32, 2>
+    }
+    air.herd @consumer tile (%x, %y) in (%sx=%c1_0, %sy=%c1_0) {
+      %buf = memref.alloc() : memref<32x32xi32, 2>
+      air.channel.get @chan_a[] (%buf[] [] []) : (memref<32x32xi32, 2>)
+      air.channel.put @chan_b[] (%buf[] [] []) : (memref<32x32xi32, 2>)
+      memref.dealloc %buf : memref<32x32xi32, 2>
+    }
+    %out = memref.alloc() : memref<32x32xi32, 1>
+    air.channel.get @chan_b[] (%out[] [] []) : (memref<32x32xi32, 1>)
+    memref.dealloc %out : memref<32x32xi32, 1>
+  }
+  return
+}
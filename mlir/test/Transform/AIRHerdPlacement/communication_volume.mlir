@@ -0,0 +1,48 @@
+//===- communication_volume.mlir -------------------------------*- MLIR -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+// RUN: air-opt %s -air-place-herds="num-rows=2 num-cols=1 placement=communication" | FileCheck %s
+
+// Traffic is weighted by the bytes each channel op moves, i.e. its sizes times
+// the trip counts of the loops around it, rather than by the size of its
+// memref. @looped sends 64 x 128 bytes to L2, and @strided a single row of 256
+// bytes out of a 16 KiB buffer, so @looped is placed next to the memtiles.
+// CHECK: air.herd @strided {{.*}} attributes {x_loc = 0 {{.*}} y_loc = 1
+// CHECK: air.herd @looped {{.*}} attributes {x_loc = 0 {{.*}} y_loc = 0
+
+air.channel @chan_a [1, 1]
+air.channel @chan_b [1, 1]
+func.func @volume() {
+  air.segment @segment_0 {
+    %c1 = arith.constant 1 : index
+    air.herd @strided tile (%x, %y) in (%sx=%c1, %sy=%c1) {
+      %c0 = arith.constant 0 : index
+      %c1_0 = arith.constant 1 : index
+      %c64 = arith.constant 64 : index
+      %buf = memref.alloc() : memref<64x64xi32, 2>
+      air.channel.put @chan_a[] (%buf[%c0, %c0] [%c1_0, %c64] [%c64, %c1_0]) : (memref<64x64xi32, 2>)
+      memref.dealloc %buf : memref<64x64xi32, 2>
+    }
+    air.herd @looped tile (%x, %y) in (%sx=%c1, %sy=%c1) {
+      %c0 = arith.constant 0 : index
+      %c1_0 = arith.constant 1 : index
+      %c64 = arith.constant 64 : index
+      %buf = memref.alloc() : memref<32xi32, 2>
+      scf.for %i = %c0 to %c64 step %c1_0 {
+        air.channel.put @chan_b[] (%buf[] [] []) : (memref<32xi32, 2>)
+      }
+      memref.dealloc %buf : memref<32xi32, 2>
+    }
+    %out_a = memref.alloc() : memref<64xi32, 1>
+    air.channel.get @chan_a[] (%out_a[] [] []) : (memref<64xi32, 1>)
+    memref.dealloc %out_a : memref<64xi32, 1>
+    %out_b = memref.alloc() : memref<32xi32, 1>
+    air.channel.get @chan_b[] (%out_b[] [] []) : (memref<32xi32, 1>)
+    memref.dealloc %out_b : memref<32xi32, 1>
+  }
+  return
+}
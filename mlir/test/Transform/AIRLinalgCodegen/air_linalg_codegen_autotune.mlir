@@ -0,0 +1,75 @@
+//===- air_linalg_codegen_autotune.mlir ------------------------*- MLIR -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+// RUN: rm -f %t.json
+// RUN: air-opt %s -air-linalg-codegen='autotune=true herd-size=4,4 l1-size=8192 autotune-cache=%t.json' | FileCheck %s
+// RUN: FileCheck %s --input-file=%t.json --check-prefix=CACHE
+// RUN: air-opt %s -air-linalg-codegen='autotune=true herd-size=4,4 l1-size=8192 autotune-cache=%t.json' | FileCheck %s
+
+// The matmul forms a 4x4 herd of 16x16 output tiles, stepping through K in
+// tiles of one vector.
+// CHECK-LABEL: func.func @matmul
+// CHECK: scf.parallel ({{.*}}) = ({{.*}}) to (%[[C64:.*]], %[[C64]]) step (%[[C16:.*]], %[[C16]]) {
+// CHECK: scf.for {{.*}} = {{.*}} to %[[C64]] step %[[C8:.*]] {
+// CHECK-DAG: memref.alloc() : memref<16x8xi32, 2>
+// CHECK-DAG: memref.alloc() : memref<8x16xi32, 2>
+// CHECK-DAG: memref.alloc() : memref<16x16xi32, 2>
+// CHECK: linalg.matmul ins({{.*}} : memref<16x8xi32, 2>, memref<8x16xi32, 2>) outs({{.*}} : memref<16x16xi32, 2>)
+
+// The elementwise op is split over a 4x4 herd, and each core walks its 16x16
+// block in 4x16 tiles.
+// CHECK-LABEL: func.func @add
+// CHECK: scf.parallel ({{.*}}) = ({{.*}}) to ({{.*}}) step (%[[S16:.*]], %[[S16]]) {
+// CHECK: scf.for {{.*}} step %[[S4:.*]] {
+// CHECK: linalg.generic {{.*}} ins({{.*}} : memref<4x16xf32, 2>, memref<4x16xf32, 2>) outs({{.*}} : memref<4x16xf32, 2>)
+
+// CACHE: "linalg.generic
+// CACHE: "herd-size": [
+// CACHE-NEXT: 4,
+// CACHE-NEXT: 4
+// CACHE-NEXT: ],
+// CACHE-NEXT: "l1-tile-permute": [
+// CACHE-NEXT: 0,
+// CACHE-NEXT: 1
+// CACHE-NEXT: ],
+// CACHE-NEXT: "l1-tile-size": [
+// CACHE-NEXT: 4,
+// CACHE-NEXT: 16
+// CACHE-NEXT: ],
+// CACHE-NEXT: "l2-tile-size": []
+// CACHE: "linalg.matmul
+// CACHE: "herd-size": [
+// CACHE-NEXT: 4,
+// CACHE-NEXT: 4
+// CACHE-NEXT: ],
+// CACHE-NEXT: "l1-tile-permute": [
+// CACHE-NEXT: 0,
+// CACHE-NEXT: 1,
+// CACHE-NEXT: 2
+// CACHE-NEXT: ],
+// CACHE-NEXT: "l1-tile-size": [
+// CACHE-NEXT: 16,
+// CACHE-NEXT: 16,
+// CACHE-NEXT: 8
+// CACHE-NEXT: ],
+// CACHE-NEXT: "l2-tile-size": []
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+module {
+  func.func @matmul(%arg0: memref<64x64xi32>, %arg1: memref<64x64xi32>, %arg2: memref<64x64xi32>) {
+    linalg.matmul ins(%arg0, %arg1 : memref<64x64xi32>, memref<64x64xi32>) outs(%arg2 : memref<64x64xi32>)
+    return
+  }
+  func.func @add(%arg0: memref<64x64xf32>, %arg1: memref<64x64xf32>, %arg2: memref<64x64xf32>) {
+    linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel", "parallel"]} ins(%arg0, %arg1 : memref<64x64xf32>, memref<64x64xf32>) outs(%arg2 : memref<64x64xf32>) {
+    ^bb0(%in: f32, %in_0: f32, %out: f32):
+      %0 = arith.addf %in, %in_0 : f32
+      linalg.yield %0 : f32
+    }
+    return
+  }
+}
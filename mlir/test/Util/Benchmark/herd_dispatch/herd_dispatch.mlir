@@ -0,0 +1,40 @@
+//===- herd_dispatch.mlir --------------------------------------*- MLIR -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+// Measures the overhead of dispatching the tiles of a herd through each
+// air-to-async herd executor. Each executable checks its result and prints a
+// JSON line with the time per herd.
+
+// RUN: air-opt -o %T/herd_async.llvm.mlir %s -air-to-async -async-to-async-runtime -async-runtime-ref-counting -async-runtime-ref-counting-opt -convert-linalg-to-affine-loops -expand-strided-metadata -lower-affine -convert-scf-to-cf -convert-async-to-llvm -finalize-memref-to-llvm -convert-cf-to-llvm -convert-func-to-llvm -canonicalize -cse
+// RUN: air-translate --mlir-to-llvmir %T/herd_async.llvm.mlir -o %T/herd_async.ll
+// RUN: %OPT -O3 -o %T/herd_async.opt.bc < %T/herd_async.ll
+// RUN: %LLC %T/herd_async.opt.bc --relocation-model=pic -filetype=obj -o %T/herd_async.o
+// RUN: air-opt -o %T/herd_parallel_for.llvm.mlir %s -air-to-async="herd-executor=parallel-for" -async-to-async-runtime -async-runtime-ref-counting -async-runtime-ref-counting-opt -convert-linalg-to-affine-loops -expand-strided-metadata -lower-affine -convert-scf-to-cf -convert-async-to-llvm -finalize-memref-to-llvm -convert-cf-to-llvm -convert-func-to-llvm -canonicalize -cse
+// RUN: air-translate --mlir-to-llvmir %T/herd_parallel_for.llvm.mlir -o %T/herd_parallel_for.ll
+// RUN: %OPT -O3 -o %T/herd_parallel_for.opt.bc < %T/herd_parallel_for.ll
+// RUN: %LLC %T/herd_parallel_for.opt.bc --relocation-model=pic -filetype=obj -o %T/herd_parallel_for.o
+// RUN: %CLANG %S/main.cpp -O2 -std=c++17 %airhost_inc -c -o %T/main.o
+// RUN: %CLANG %aircpu_lib %mlir_async_lib -o %T/herd_async.exe %T/main.o %T/herd_async.o
+// RUN: %CLANG %aircpu_lib %mlir_async_lib -o %T/herd_parallel_for.exe %T/main.o %T/herd_parallel_for.o
+// RUN: %ld_lib_path %T/herd_async.exe async | FileCheck %s --check-prefix=ASYNC
+// RUN: %ld_lib_path %T/herd_parallel_for.exe parallel-for | FileCheck %s --check-prefix=PFOR
+
+// ASYNC: {"name": "herd_dispatch/async", "tiles": 256
+// ASYNC: PASS!
+// PFOR: {"name": "herd_dispatch/parallel-for", "tiles": 256
+// PFOR: PASS!
+
+func.func @forward(%arg0 : memref<16x16xi32>) -> () {
+  %c16 = arith.constant 16 : index
+  air.herd tile (%x, %y) in (%sx=%c16, %sy=%c16) args (%out=%arg0) : memref<16x16xi32> {
+    %0 = arith.muli %x, %sy : index
+    %1 = arith.addi %0, %y : index
+    %2 = arith.index_cast %1 : index to i32
+    memref.store %2, %out[%x, %y] : memref<16x16xi32>
+  }
+  return
+}
@@ -0,0 +1,66 @@
+//===- main.cpp -------------------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "air_tensor.h"
+
+extern "C" {
+void _mlir_ciface_forward(void *);
+}
+
+#define M_SIZE 16
+
+int main(int argc, char *argv[]) {
+  const char *executor = argc > 1 ? argv[1] : "async";
+
+  tensor_t<int32_t, 2> output;
+  output.shape[0] = output.shape[1] = M_SIZE;
+  output.alloc = output.data =
+      (int32_t *)malloc(sizeof(int32_t) * output.shape[0] * output.shape[1]);
+  auto output_size = output.shape[0] * output.shape[1];
+
+  // run the herd until it took at least 200ms in total
+  _mlir_ciface_forward((void *)&output);
+  uint64_t iterations = 1;
+  double ns = 0;
+  for (;; iterations *= 2) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++)
+      _mlir_ciface_forward((void *)&output);
+    ns = std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - t0)
+             .count();
+    if (ns >= 2e8)
+      break;
+  }
+  printf("{\"name\": \"herd_dispatch/%s\", \"tiles\": %ld, \"iterations\": "
+         "%lu, \"ns_per_iter\": %.3f, \"ns_per_tile\": %.3f}\n",
+         executor, output_size, iterations, ns / iterations,
+         ns / iterations / output_size);
+
+  int errors = 0;
+  for (unsigned int i = 0; i < output_size; i++) {
+    if (output.data[i] != (int32_t)i) {
+      errors++;
+      if (errors < 10)
+        printf("%04X: mismatch %d != %d\n", i, output.data[i], i);
+    }
+  }
+  if (!errors) {
+    printf("PASS!\n");
+  } else {
+    printf("fail %ld/%ld.\n", (output_size - errors), output_size);
+  }
+
+  free(output.alloc);
+
+  return 0;
+}
@@ -35,17 +35,17 @@ module attributes {torch.debug_module_name = "model"} {
     %1 = builtin.unrealized_conversion_cast %0 : memref<1x1xi64> to memref<1x1xi64>
     %2 = builtin.unrealized_conversion_cast %arg0 : memref<32x32xi32> to memref<?x?xi32>
     // put %arg0 into channel_0
-    call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%1, %c1, %c1, %c1, %c1, %c0, %c0, %2, %c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
+    call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%1, %c1, %c1, %c1, %c1, %c1, %c0, %c0, %2, %c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
     %3 = memref.get_global @channel_1 : memref<1x1xi64>
     %4 = builtin.unrealized_conversion_cast %3 : memref<1x1xi64> to memref<1x1xi64>
     %5 = builtin.unrealized_conversion_cast %arg1 : memref<32x32xi32> to memref<?x?xi32>
     // put %arg1 into channel_1
-    call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%4, %c1, %c1, %c1, %c1, %c0, %c0, %5, %c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
+    call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%4, %c1, %c1, %c1, %c1, %c1, %c0, %c0, %5, %c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
     %6 = memref.get_global @channel_2 : memref<1x1xi64>
     %7 = builtin.unrealized_conversion_cast %6 : memref<1x1xi64> to memref<1x1xi64>
     %8 = builtin.unrealized_conversion_cast %alloc_0 : memref<32x32xi32> to memref<?x?xi32>
     // put %alloc_0 into channel_2 
-    call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%7, %c1, %c1, %c1, %c1, %c0, %c0,%8,%c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
+    call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%7, %c1, %c1, %c1, %c1, %c1, %c0, %c0,%8,%c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
     %token = async.execute {
       %alloc_2 = memref.alloc() : memref<32x32xi32>
       %alloc_3 = memref.alloc() : memref<32x32xi32>
@@ -66,7 +66,7 @@ module attributes {torch.debug_module_name = "model"} {
       %33 = memref.get_global @channel_3 : memref<1x1xi64>
       %34 = builtin.unrealized_conversion_cast %33 : memref<1x1xi64> to memref<1x1xi64>
       %35 = builtin.unrealized_conversion_cast %alloc_4 : memref<32x32xi32> to memref<?x?xi32>
-      func.call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%34, %c1, %c1, %c1, %c1, %c0,%c0, %35, %c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
+      func.call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%34, %c1, %c1, %c1, %c1, %c1, %c0,%c0, %35, %c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
       memref.dealloc %alloc_2 : memref<32x32xi32>
       memref.dealloc %alloc_3 : memref<32x32xi32>
       memref.dealloc %alloc_4 : memref<32x32xi32>
@@ -86,17 +86,17 @@ module attributes {torch.debug_module_name = "model"} {
     %13 = builtin.unrealized_conversion_cast %12 : memref<1x1xi64> to memref<1x1xi64>
     %14 = builtin.unrealized_conversion_cast %alloc_0 : memref<32x32xi32> to memref<?x?xi32>
     // put %alloc_0 into channel_4
-    call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%13, %c1, %c1, %c1, %c1, %c0,%c0,%14, %c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
+    call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%13, %c1, %c1, %c1, %c1, %c1, %c0,%c0,%14, %c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
     %15 = memref.get_global @channel_5 : memref<1x1xi64>
     %16 = builtin.unrealized_conversion_cast %15 : memref<1x1xi64> to memref<1x1xi64>
     %17 = builtin.unrealized_conversion_cast %arg2 : memref<32x32xi32> to memref<?x?xi32>
     // put %arg2 into channel_5
-    call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%16, %c1, %c1, %c1, %c1, %c0,%c0, %17,  %c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
+    call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%16, %c1, %c1, %c1, %c1, %c1, %c0,%c0, %17,  %c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
     %18 = memref.get_global @channel_6 : memref<1x1xi64>
     %19 = builtin.unrealized_conversion_cast %18 : memref<1x1xi64> to memref<1x1xi64>
     %20 = builtin.unrealized_conversion_cast %alloc_1 : memref<32x32xi32> to memref<?x?xi32>
     // put %alloc_1 into channel_6
-    call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%19, %c1, %c1, %c1, %c1, %c0,%c0, %20,  %c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
+    call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%19, %c1, %c1, %c1, %c1, %c1, %c0,%c0, %20,  %c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
     %token_0 = async.execute {
       %alloc_2 = memref.alloc() : memref<32x32xi32>
       %alloc_3 = memref.alloc() : memref<32x32xi32>
@@ -117,7 +117,7 @@ module attributes {torch.debug_module_name = "model"} {
       %33 = memref.get_global @channel_7 : memref<1x1xi64>
       %34 = builtin.unrealized_conversion_cast %33 : memref<1x1xi64> to memref<1x1xi64>
       %35 = builtin.unrealized_conversion_cast %alloc_4 : memref<32x32xi32> to memref<?x?xi32>
-      func.call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%34, %c1, %c1, %c1, %c1, %c0,%c0, %35,  %c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
+      func.call @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(%34, %c1, %c1, %c1, %c1, %c1, %c0,%c0, %35,  %c0, %c0, %c32, %c32, %c32, %c1) : (memref<1x1xi64>, index, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) -> ()
       memref.dealloc %alloc_2 : memref<32x32xi32>
       memref.dealloc %alloc_3 : memref<32x32xi32>
       memref.dealloc %alloc_4 : memref<32x32xi32>
@@ -132,7 +132,7 @@ module attributes {torch.debug_module_name = "model"} {
     memref.copy %alloc_1, %arg3 : memref<32x32xi32> to memref<32x32xi32>
     return
   }
-  func.func private @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(memref<1x1xi64>, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) attributes {llvm.emit_c_interface}
+  func.func private @air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(memref<1x1xi64>, index, index, index, index, index, index, index, memref<?x?xi32>, index, index, index, index, index, index) attributes {llvm.emit_c_interface}
   func.func private @air_channel_get_M0D2I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(memref<1x1xi64>, index, index, memref<?x?xi32>, index, index, index, index, index, index) attributes {llvm.emit_c_interface}
 }
 
@@ -6,9 +6,15 @@
 //===----------------------------------------------------------------------===//
 
 // RUN: air-runner %s -f test -m %S/arch.json | FileCheck %s
+// RUN: air-runner %s -f test -m %S/arch.json | FileCheck %s --check-prefix=LINK
 
 // Check for correct event serialization with bandwidth contention
 
+// LINK: Latency:
+// LINK: Link utilization:
+// LINK-NEXT: L3-->L2: {{[0-9]+}} bytes
+// LINK-NEXT: L2-->L1: {{[0-9]+}} bytes, busy {{[0-9]+}} cycles, peak {{[1-9][0-9]*}} transfers, utilization {{.*}}%
+
 
 // CHECK: "name": "ChannelGetOp@channel_1(L1<--L2)",
 // CHECK-NEXT: "cat": "layer",
@@ -0,0 +1,68 @@
+//===- column.mlir ---------------------------------------------*- MLIR -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+// RUN: air-runner %s -f test -m %S/arch_column.json | FileCheck %s
+// RUN: air-runner %s -f test -m %S/arch_column.json | grep Latency | sed 's/[^0-9.]//g' > %t.contended
+// RUN: air-runner %s -f test -m %S/arch_column_uncapped.json | grep Latency | sed 's/[^0-9.]//g' > %t.uncontended
+// RUN: not diff %t.uncontended %t.contended
+// RUN: cat %t.uncontended %t.contended | sort -c -g
+
+// Check that concurrent transfers into the tiles of a column share the
+// bandwidth of the column, which carries as much as the DU's inbound ports do
+// unless capped otherwise. Four gets into the four tiles of one DU, which has
+// a single inbound port, take longer than when the column's bandwidth is
+// raised to four ports' worth.
+
+// CHECK: Latency:
+// CHECK: Link utilization:
+// CHECK: L2-->L1: {{[0-9]+}} bytes
+
+module {
+  air.channel @channel_1 [1, 4]
+  func.func @test(%arg0: memref<128x128xbf16>) {
+    %c1 = arith.constant 1 : index
+    %0 = air.launch async (%arg4, %arg5) in (%arg6=%c1, %arg7=%c1) {
+      %3 = air.segment async attributes {x_loc = 0 : i64, x_size = 1 : i64, y_loc = 0 : i64, y_size = 4 : i64} {
+        %c32 = arith.constant 32 : index
+        %c1_5 = arith.constant 1 : index
+        %c4 = arith.constant 4 : index
+        %c0_6 = arith.constant 0 : index
+        %c128_8 = arith.constant 128 : index
+        %async_token_10, %results_11 = air.execute -> (memref<32x128xbf16, 1>) {
+          %alloc = memref.alloc() : memref<32x128xbf16, 1>
+          air.execute_terminator %alloc : memref<32x128xbf16, 1>
+        }
+        %5 = scf.parallel (%arg15, %arg16) = (%c0_6, %c0_6) to (%c1_5, %c4) step (%c1_5, %c1_5) init (%async_token_10) -> !air.async.token {
+          %async_token_20, %results_21 = air.execute [%async_token_10] -> (index) {
+            %13 = arith.muli %arg16, %c32 : index
+            air.execute_terminator %13 : index
+          }
+          %12 = air.channel.put async [%async_token_20]  @channel_1[%arg15, %arg16] (%results_11[%c0_6, %results_21] [%c32, %c32] [%c128_8, %c1_5]) : (memref<32x128xbf16, 1>)
+          scf.reduce(%12 : !air.async.token) {
+          ^bb0(%arg17: !air.async.token, %arg18: !air.async.token):
+            %13 = air.wait_all async [%arg17, %arg18]
+            scf.reduce.return %13 : !air.async.token
+          }
+        }
+        %10 = air.herd @herd_0 async tile (%arg15, %arg16) in (%arg17=%c1_5, %arg18=%c4) {
+          %async_token_18, %results_19 = air.execute -> (memref<32x32xbf16, 2>) {
+            %alloc = memref.alloc() : memref<32x32xbf16, 2>
+            air.execute_terminator %alloc : memref<32x32xbf16, 2>
+          }
+          %13 = air.channel.get async [%async_token_18]  @channel_1[%arg15, %arg16] (%results_19[] [] []) : (memref<32x32xbf16, 2>)
+          %async_token_22 = air.execute [%13] {
+            memref.dealloc %results_19 : memref<32x32xbf16, 2>
+          }
+        }
+        %async_token_23 = air.execute [%5, %10] {
+          memref.dealloc %results_11 : memref<32x128xbf16, 1>
+        }
+      }
+    }
+    return
+  }
+}
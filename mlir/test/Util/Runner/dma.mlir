@@ -6,6 +6,9 @@
 //===----------------------------------------------------------------------===//
 
 // RUN: air-runner %s -f test -m %S/arch.json | FileCheck %s
+// RUN: air-runner %s -f test -m %S/arch.json --trace-format=json-compact | FileCheck %s --check-prefix=COMPACT
+// RUN: air-runner %s -f test -m %S/arch.json --trace-format=json-compact --trace-filter=dma | FileCheck %s --check-prefix=FILTER
+// RUN: not air-runner %s -f test -m %S/arch.json --trace-format=jsonl 2>&1 | FileCheck %s --check-prefix=BADFORMAT
 
 // Air dma op
 
@@ -17,6 +20,14 @@
 // CHECK: "name": "LaunchTerminator",
 // CHECK: "ph": "E",
 
+// COMPACT-COUNT-32: {"name":"DmaMemcpyNdOp{{.*}}","cat":"layer","ph":"{{B|E}}","ts":{{[0-9]+}}.{{[0-9]+}},"pid":{{[0-9]+}},"tid":{{[0-9]+}},"args":{}},
+// COMPACT: {"name":"LaunchTerminator","cat":"layer","ph":"B",
+
+// FILTER-COUNT-32: "name":"DmaMemcpyNdOp
+// FILTER-NOT: "name":"LaunchTerminator"
+
+// BADFORMAT: Unknown trace format jsonl (expected one of json, json-compact, perfetto)
+
 module {
   ml_program.global private mutable @global_seed(dense<0> : tensor<i64>) : tensor<i64>
   func.func @test(%arg0: memref<256x1024xbf16>, %arg1: memref<1024x1024xbf16>, %arg2: memref<1024x1024xbf16>, %arg3: memref<1024x1024xbf16>) -> memref<256x1024xbf16> {
@@ -0,0 +1,101 @@
+//===- access_pattern.mlir -------------------------------------*- MLIR -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+// Variants of the JSON model, each with one "dma" parameter changed.
+// RUN: sed '/"dma"/d' %S/arch.json > %t.nodma.json
+// RUN: sed 's/"wrap_cycles": 16/"wrap_cycles": 0/' %S/arch.json > %t.nowrap.json
+// RUN: sed 's/"burst_bytes": 128/"burst_bytes": 0/' %S/arch.json > %t.noburst.json
+// RUN: sed 's/"wrap_cycles": 16/"wrap_cycles": -16/' %S/arch.json > %t.negative.json
+
+// RUN: air-runner %s -f contiguous -m %S/arch.json | grep Latency | sed 's/[^0-9.]//g' > %t.contiguous
+// RUN: air-runner %s -f strided -m %S/arch.json | grep Latency | sed 's/[^0-9.]//g' > %t.strided
+// RUN: air-runner %s -f contiguous -m %t.nodma.json | grep Latency | sed 's/[^0-9.]//g' > %t.contiguous.nodma
+// RUN: air-runner %s -f strided -m %t.nowrap.json | grep Latency | sed 's/[^0-9.]//g' > %t.strided.nowrap
+// RUN: air-runner %s -f strided -m %t.noburst.json | grep Latency | sed 's/[^0-9.]//g' > %t.strided.noburst
+
+// A put of the same volume in 64 runs of 16 elements pays a wrap per run and
+// uses half of each 128-byte burst, so it takes longer than a contiguous put.
+// RUN: not diff %t.contiguous %t.strided
+// RUN: cat %t.contiguous %t.strided | sort -c -g
+
+// bd_setup_cycles is charged to every transfer, including contiguous ones.
+// RUN: not diff %t.contiguous.nodma %t.contiguous
+// RUN: cat %t.contiguous.nodma %t.contiguous | sort -c -g
+
+// wrap_cycles and burst_bytes are each charged to the strided put.
+// RUN: not diff %t.strided.nowrap %t.strided
+// RUN: cat %t.strided.nowrap %t.strided | sort -c -g
+// RUN: not diff %t.strided.noburst %t.strided
+// RUN: cat %t.strided.noburst %t.strided | sort -c -g
+
+// Negative parameters are rejected.
+// RUN: not air-runner %s -f strided -m %t.negative.json 2>&1 | FileCheck %s --check-prefix=NEGATIVE
+// NEGATIVE: Error: negative dma parameter in JSON model
+
+module {
+  air.channel @channel_contiguous [1, 1]
+  air.channel @channel_strided [1, 1]
+  func.func @contiguous() {
+    %c1 = arith.constant 1 : index
+    %0 = air.launch async (%arg0, %arg1) in (%arg2=%c1, %arg3=%c1) {
+      %1 = air.segment async attributes {x_loc = 0 : i64, x_size = 1 : i64, y_loc = 0 : i64, y_size = 1 : i64} {
+        %c1_0 = arith.constant 1 : index
+        %async_token, %results = air.execute -> (memref<32x32xf32, 1>) {
+          %alloc = memref.alloc() : memref<32x32xf32, 1>
+          air.execute_terminator %alloc : memref<32x32xf32, 1>
+        }
+        %2 = air.channel.put async [%async_token]  @channel_contiguous[] (%results[] [] []) : (memref<32x32xf32, 1>)
+        %3 = air.herd @herd_0 async tile (%arg4, %arg5) in (%arg6=%c1_0, %arg7=%c1_0) {
+          %async_token_1, %results_2 = air.execute -> (memref<32x32xf32, 2>) {
+            %alloc = memref.alloc() : memref<32x32xf32, 2>
+            air.execute_terminator %alloc : memref<32x32xf32, 2>
+          }
+          %5 = air.channel.get async [%async_token_1]  @channel_contiguous[] (%results_2[] [] []) : (memref<32x32xf32, 2>)
+          %async_token_3 = air.execute [%5] {
+            memref.dealloc %results_2 : memref<32x32xf32, 2>
+          }
+        }
+        %async_token_4 = air.execute [%2, %3] {
+          memref.dealloc %results : memref<32x32xf32, 1>
+        }
+      }
+    }
+    return
+  }
+  func.func @strided() {
+    %c1 = arith.constant 1 : index
+    %0 = air.launch async (%arg0, %arg1) in (%arg2=%c1, %arg3=%c1) {
+      %1 = air.segment async attributes {x_loc = 0 : i64, x_size = 1 : i64, y_loc = 0 : i64, y_size = 1 : i64} {
+        %c0 = arith.constant 0 : index
+        %c1_0 = arith.constant 1 : index
+        %c2 = arith.constant 2 : index
+        %c16 = arith.constant 16 : index
+        %c32 = arith.constant 32 : index
+        %c512 = arith.constant 512 : index
+        %async_token, %results = air.execute -> (memref<32x32xf32, 1>) {
+          %alloc = memref.alloc() : memref<32x32xf32, 1>
+          air.execute_terminator %alloc : memref<32x32xf32, 1>
+        }
+        %2 = air.channel.put async [%async_token]  @channel_strided[] (%results[%c0, %c0, %c0, %c0] [%c2, %c2, %c16, %c16] [%c512, %c16, %c32, %c1_0]) : (memref<32x32xf32, 1>)
+        %3 = air.herd @herd_0 async tile (%arg4, %arg5) in (%arg6=%c1_0, %arg7=%c1_0) {
+          %async_token_1, %results_2 = air.execute -> (memref<32x32xf32, 2>) {
+            %alloc = memref.alloc() : memref<32x32xf32, 2>
+            air.execute_terminator %alloc : memref<32x32xf32, 2>
+          }
+          %5 = air.channel.get async [%async_token_1]  @channel_strided[] (%results_2[] [] []) : (memref<32x32xf32, 2>)
+          %async_token_3 = air.execute [%5] {
+            memref.dealloc %results_2 : memref<32x32xf32, 2>
+          }
+        }
+        %async_token_4 = air.execute [%2, %3] {
+          memref.dealloc %results : memref<32x32xf32, 1>
+        }
+      }
+    }
+    return
+  }
+}
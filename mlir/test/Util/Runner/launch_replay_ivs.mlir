@@ -0,0 +1,39 @@
+//===- launch_replay_ivs.mlir ----------------------------------*- MLIR -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+// RUN: air-runner %s -f test -m %S/arch.json --launch-iterations=replay | FileCheck %s
+
+// The segment depends on the launch induction variables, so the launch
+// iterations may differ and every one of them is simulated, even in replay
+// mode.
+
+// CHECK-COUNT-4: "name": "LaunchTerminator",
+
+module {
+  func.func @test(%arg0: memref<256x1024xbf16>) {
+    %c2 = arith.constant 2 : index
+    %0 = air.launch async (%arg4, %arg5) in (%arg6=%c2, %arg7=%c2) args(%arg8=%arg0) : memref<256x1024xbf16> attributes {id = 1 : i32} {
+      %1 = air.segment async  args(%arg15=%arg4, %arg16=%arg5, %arg17=%arg8) : index, index, memref<256x1024xbf16> attributes {x_loc = 0 : i64, x_size = 4 : i64, y_loc = 0 : i64, y_size = 4 : i64} {
+        %c4 = arith.constant 4 : index
+        %async_token_1, %results_2 = air.execute -> (index) {
+          %2 = arith.muli %arg15, %c4 : index
+          air.execute_terminator %2 : index
+        }
+        %3 = air.herd @herd_0 async [%async_token_1] tile (%arg21, %arg22) in (%arg23=%c4, %arg24=%c4) {
+          %async_token_3, %results_4 = air.execute -> (memref<32x32xbf16, 2>) {
+            %alloc = memref.alloc() : memref<32x32xbf16, 2>
+            air.execute_terminator %alloc : memref<32x32xbf16, 2>
+          }
+          %async_token_5 = air.execute [%async_token_3] {
+            memref.dealloc %results_4 : memref<32x32xbf16, 2>
+          }
+        }
+      }
+    }
+    return
+  }
+}
@@ -6,11 +6,17 @@
 //===----------------------------------------------------------------------===//
 
 // RUN: air-runner %s -f test -m %S/arch.json | FileCheck %s
+// RUN: air-runner %s -f test -m %S/arch.json --launch-iterations=replay | FileCheck %s --check-prefix=REPLAY
 
 // Multiple air.launch operations; multiple iterations per air.launch operation.
 
 // CHECK-COUNT-16: "name": "LaunchTerminator",
 
+// Only the first iteration of each air.launch operation is simulated.
+
+// REPLAY-COUNT-4: "name": "LaunchTerminator",
+// REPLAY-NOT: "name": "LaunchTerminator",
+
 module {
   func.func @test(%arg0: memref<256x1024xbf16>, %arg1: memref<1024x1024xbf16>, %arg2: memref<1024x1024xbf16>, %arg3: memref<1024x1024xbf16>) -> memref<256x1024xbf16> {
     %c1 = arith.constant 1 : index
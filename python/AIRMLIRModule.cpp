@@ -51,11 +51,19 @@ PYBIND11_MODULE(_air, m) {
 
   // AIR Runner bindings
   auto air_runner = m.def_submodule("runner", "air-runner bindings");
-  air_runner.def("run", [](MlirModule module, const std::string &json,
-                           const std::string &outfile,
-                           const std::string &function,
-                           const std::string &sim_granularity, bool verbose) {
-    airRunnerRun(module, json.c_str(), outfile.c_str(), function.c_str(),
-                 sim_granularity.c_str(), verbose);
-  });
+  air_runner.def(
+      "run",
+      [](MlirModule module, const std::string &json, const std::string &outfile,
+         const std::string &function, const std::string &sim_granularity,
+         bool verbose, const std::string &trace_format) {
+        if (!airRunnerIsTraceFormat(trace_format.c_str()))
+          throw py::value_error("unknown trace format '" + trace_format +
+                                "', expected one of json, json-compact and "
+                                "perfetto");
+        airRunnerRun(module, json.c_str(), outfile.c_str(), function.c_str(),
+                     sim_granularity.c_str(), verbose, trace_format.c_str());
+      },
+      py::arg("module"), py::arg("json"), py::arg("outfile"),
+      py::arg("function"), py::arg("sim_granularity"), py::arg("verbose"),
+      py::arg("trace_format") = "json");
 }
@@ -0,0 +1,152 @@
+# ./python/air/compiler/aircc/cache.py -*- Python -*-
+#
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# SPDX-License-Identifier: MIT
+
+"""
+Content-addressed on-disk cache of aircc compilation artifacts
+"""
+
+import hashlib
+import json
+import os
+import shutil
+import tempfile
+
+# Bump to invalidate entries written by older versions of aircc
+CACHE_VERSION = 1
+
+
+def fingerprint_ir(ir):
+    """Hash of the text of an MLIR module, ignoring blank lines and trailing
+    whitespace. The module should be printed without debug info, so that
+    locations do not change the fingerprint."""
+    lines = [l.rstrip() for l in str(ir).splitlines()]
+    text = "\n".join(l for l in lines if l)
+    return hashlib.sha256(text.encode()).hexdigest()
+
+
+def fingerprint_files(paths):
+    """Hash of the names and contents of files, used to tell apart the tool
+    versions that produced an artifact. Contents are hashed rather than paths
+    or modification times, so that the same tools installed elsewhere (e.g.
+    in a fresh CI checkout) share cache entries. Directories and missing
+    files are skipped."""
+    digests = set()
+    for p in set(p for p in paths if p):
+        if not os.path.isfile(p):
+            continue
+        h = hashlib.sha256()
+        try:
+            with open(p, "rb") as f:
+                for chunk in iter(lambda: f.read(1 << 20), b""):
+                    h.update(chunk)
+        except OSError:
+            continue
+        digests.add(f"{os.path.basename(p)}:{h.hexdigest()}")
+    return hashlib.sha256(";".join(sorted(digests)).encode()).hexdigest()
+
+
+class CompilationCache:
+    """Stores the outputs of aircc stages under <cache_dir>/<key[:2]>/<key>.
+    The key of an entry hashes the stage name, the fingerprint of its input
+    IR, its options and the toolchain. An entry is a directory of output
+    files, written to a temporary directory and renamed into place once
+    complete, so concurrent compilations sharing a cache never see a partial
+    entry. A cache without a directory is disabled: lookups miss and stores
+    are dropped without counting."""
+
+    def __init__(self, cache_dir, toolchain=""):
+        self.cache_dir = cache_dir
+        self.toolchain = toolchain
+        # stage name -> [hits, misses]
+        self.stats = {}
+
+    def enabled(self):
+        return bool(self.cache_dir)
+
+    def key(self, stage, ir, options=()):
+        h = hashlib.sha256()
+        h.update(f"{CACHE_VERSION}\0{stage}\0{self.toolchain}\0".encode())
+        h.update(json.dumps(list(options)).encode())
+        h.update(b"\0" + fingerprint_ir(ir).encode())
+        return h.hexdigest()
+
+    def _path(self, key):
+        return os.path.join(self.cache_dir, key[:2], key)
+
+    def get(self, stage, key):
+        """Return the directory of the entry for key, or None on a miss"""
+        if not self.enabled():
+            return None
+        path = self._path(key)
+        hit = os.path.isfile(os.path.join(path, "manifest.json"))
+        counts = self.stats.setdefault(stage, [0, 0])
+        counts[0 if hit else 1] += 1
+        return path if hit else None
+
+    def put(self, stage, key, texts=None, files=None, dirs=None):
+        """Store an entry from strings, files and directories, each given as a
+        mapping from its name in the entry to its content or source path"""
+        if not self.enabled():
+            return
+        texts = texts or {}
+        files = files or {}
+        dirs = dirs or {}
+        path = self._path(key)
+        if os.path.isdir(path):
+            return
+        try:
+            os.makedirs(os.path.dirname(path), exist_ok=True)
+            staging = tempfile.mkdtemp(dir=os.path.dirname(path), prefix=".tmp.")
+        except OSError:
+            return
+        try:
+            for name, text in texts.items():
+                with open(os.path.join(staging, name), "w") as f:
+                    f.write(str(text))
+            for name, src in files.items():
+                shutil.copy2(src, os.path.join(staging, name))
+            for name, src in dirs.items():
+                shutil.copytree(src, os.path.join(staging, name), symlinks=True)
+            manifest = {
+                "stage": stage,
+                "entries": sorted(list(texts) + list(files) + list(dirs)),
+            }
+            with open(os.path.join(staging, "manifest.json"), "w") as f:
+                json.dump(manifest, f)
+            os.rename(staging, path)
+        except OSError:
+            # another compilation stored the same entry first, or the cache
+            # is not writable; either way this one is not needed
+            shutil.rmtree(staging, ignore_errors=True)
+
+    def report(self):
+        """Summary of the hits and misses of each stage"""
+        hits = sum(h for h, _ in self.stats.values())
+        misses = sum(m for _, m in self.stats.values())
+        stages = ", ".join(
+            f"{stage} {h}/{h + m} hits" for stage, (h, m) in self.stats.items()
+        )
+        return f"aircc cache: {hits} hits, {misses} misses ({stages})"
+
+
+def entry_names(entry):
+    """Names of the strings, files and directories stored in an entry"""
+    with open(os.path.join(entry, "manifest.json"), "r") as f:
+        return json.load(f)["entries"]
+
+
+def read_text(entry, name):
+    with open(os.path.join(entry, name), "r") as f:
+        return f.read()
+
+
+def copy_out(entry, name, dst):
+    """Copy a file or directory of an entry to dst, replacing dst"""
+    src = os.path.join(entry, name)
+    if os.path.isdir(src):
+        shutil.rmtree(dst, ignore_errors=True)
+        shutil.copytree(src, dst, symlinks=True)
+    else:
+        shutil.copy2(src, dst)
@@ -5,6 +5,7 @@
 # SPDX-License-Identifier: MIT
 
 import argparse
+import os
 import sys
 
 from air.compiler.aircc.configure import *
@@ -123,6 +124,12 @@ def parse_args(args=None):
         action="store_true",
         help="By default, aircc may output a while(true) loop around per-core logic. If this option is specified, a while(true) loop will not be added.",
     )
+    parser.add_argument(
+        "--cache-dir",
+        dest="cache_dir",
+        default=os.environ.get("AIRCC_CACHE_DIR", ""),
+        help="Directory of the compilation cache shared between runs, by default $AIRCC_CACHE_DIR. Caching is disabled if neither is set.",
+    )
 
     opts = parser.parse_args(args)
     return opts
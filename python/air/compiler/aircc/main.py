@@ -8,18 +8,21 @@
 aircc - AIR compiler driver for MLIR tools
 """
 
+import glob
 import os
 import platform
 import sys
 import subprocess
 from joblib import Parallel, delayed
 import shutil
+import tempfile
 
 from air.passmanager import PassManager
 from air.ir import Module, Context, Location
 from air.dialects import air as airdialect
 
 import air.compiler.aircc.cl_arguments as cl_arguments
+import air.compiler.aircc.cache as aircc_cache
 from air.compiler.aircc.configure import *
 
 import aie.compiler.aiecc.main as aiecc
@@ -112,14 +115,66 @@ def run_passes(pass_pipeline, mlir_module, opts, outputfile=None):
         print("Running:", pass_pipeline)
     PassManager.parse(pass_pipeline).run(mlir_module.operation)
     if outputfile:
-        with open(outputfile, "w") as g:
-            g.write(str(mlir_module))
+        write_module(mlir_module, outputfile)
 
 
-def lower_airrt_to_airhost(air_to_aie_module, air_placed_module, air_mlir_filename):
+def write_module(mlir_module, outputfile):
+    with open(outputfile, "w") as g:
+        g.write(str(mlir_module))
+
+
+def run_cached_passes(stage, pass_pipeline, mlir_module, opts, outputfile=None):
+    """Run a pass pipeline on a module, unless the compilation cache holds its
+    result. Returns the resulting module, which is a new one on a cache hit."""
+    key = cache.key(stage, mlir_module, [pass_pipeline])
+    entry = cache.get(stage, key)
+    if entry:
+        if opts.verbose:
+            print("Using cached", stage)
+        mlir_module = Module.parse(aircc_cache.read_text(entry, "module.mlir"))
+        if outputfile:
+            write_module(mlir_module, outputfile)
+        return mlir_module
+    run_passes(pass_pipeline, mlir_module, opts, outputfile)
+    cache.put(stage, key, texts={"module.mlir": mlir_module})
+    return mlir_module
+
+
+def split_devices(air_to_aie_module):
+    """Run air-split-devices, writing the AIE module of each device to the
+    temporary directory. Returns the remaining host module."""
+    key = cache.key("air-split-devices", air_to_aie_module)
+    entry = cache.get("air-split-devices", key)
+    if entry:
+        if opts.verbose:
+            print("Using cached air-split-devices")
+        for name in aircc_cache.entry_names(entry):
+            if name != "module.mlir":
+                aircc_cache.copy_out(entry, name, os.path.join(opts.tmpdir, name))
+        return Module.parse(aircc_cache.read_text(entry, "module.mlir"))
+
+    # write the device modules to a directory of their own to find them
+    staging = tempfile.mkdtemp(dir=opts.tmpdir)
     pass_pipeline = "air-split-devices{"
-    pass_pipeline = pass_pipeline + f"output-prefix={opts.tmpdir}/" + "}"
+    pass_pipeline = pass_pipeline + f"output-prefix={staging}/" + "}"
     run_passes("builtin.module(" + pass_pipeline + ")", air_to_aie_module, opts)
+    device_files = {}
+    for name in sorted(os.listdir(staging)):
+        device_file = os.path.join(opts.tmpdir, name)
+        shutil.move(os.path.join(staging, name), device_file)
+        device_files[name] = device_file
+    os.rmdir(staging)
+    cache.put(
+        "air-split-devices",
+        key,
+        texts={"module.mlir": air_to_aie_module},
+        files=device_files,
+    )
+    return air_to_aie_module
+
+
+def lower_airrt_to_airhost(air_to_aie_module, air_placed_module, air_mlir_filename):
+    air_to_aie_module = split_devices(air_to_aie_module)
 
     # lower the airrt control program to llvm dialect
 
@@ -231,18 +286,12 @@ def lower_airrt_to_airhost(air_to_aie_module, air_placed_module, air_mlir_filena
         aiecc_file = opts.tmpdir + "/aiecc." + segment + ".mlir"
         aiecc_dir = opts.tmpdir + "/" + segment
 
-        do_call(
-            [
-                "air-opt",
-                segment_file,
-                "-air-lower-linalg-tensors",
-                "-lower-affine",
-                "-canonicalize",
-                "-cse",
-                "-o",
-                aiecc_file,
-            ]
-        )
+        lower_segment_passes = [
+            "-air-lower-linalg-tensors",
+            "-lower-affine",
+            "-canonicalize",
+            "-cse",
+        ]
 
         # set host target for aiecc
         if "x86_64" in platform.uname()[5]:
@@ -251,20 +300,45 @@ def lower_airrt_to_airhost(air_to_aie_module, air_placed_module, air_mlir_filena
             aiecc_target = "aarch64-linux-gnu"
         aiecc_target = opts.host_target if opts.host_target else aiecc_target
 
-        # run aiecc to make the elf and configuration files
         sysroot = opts.sysroot if opts.sysroot else "/"
-        do_call(
-            ["aiecc.py"]
-            + (["-v"] if opts.verbose else [])
-            + ["--sysroot", sysroot]
+        aiecc_flags = (
+            ["--sysroot", sysroot]
             + ["--host-target", aiecc_target]
-            + ["--tmpdir", aiecc_dir]
             + ["--no-aiesim"]
             + ["--xbridge" if opts.xbridge else "--no-xbridge"]
             + ["--xchesscc" if opts.xchesscc else "--no-xchesscc"]
-            + [aiecc_file]
         )
 
+        with open(segment_file, "r") as f:
+            key = cache.key(
+                "aie-core-elfs", f.read(), lower_segment_passes + aiecc_flags
+            )
+        entry = cache.get("aie-core-elfs", key)
+        if entry:
+            if opts.verbose:
+                print("Using cached aiecc outputs for segment:", segment)
+            aircc_cache.copy_out(entry, "aiecc.mlir", aiecc_file)
+            aircc_cache.copy_out(entry, "prj", aiecc_dir)
+        else:
+            do_call(
+                ["air-opt", segment_file] + lower_segment_passes + ["-o", aiecc_file]
+            )
+
+            # run aiecc to make the elf and configuration files
+            do_call(
+                ["aiecc.py"]
+                + (["-v"] if opts.verbose else [])
+                + ["--tmpdir", aiecc_dir]
+                + aiecc_flags
+                + [aiecc_file]
+            )
+            cache.put(
+                "aie-core-elfs",
+                key,
+                files={"aiecc.mlir": aiecc_file},
+                dirs={"prj": aiecc_dir},
+            )
+
         inc_file = opts.tmpdir + "/" + air_mlir_filename + "." + segment + ".inc"
         cpp_file = opts.tmpdir + "/" + air_mlir_filename + "." + segment + ".cpp"
         obj_file = opts.tmpdir + "/" + air_mlir_filename + "." + segment + ".o"
@@ -321,9 +395,42 @@ def lower_airrt_to_airhost(air_to_aie_module, air_placed_module, air_mlir_filena
         do_call(["cp", lib_file, opts.output_file])
 
 
+def toolchain_files():
+    """The executables, modules and libraries whose versions determine the
+    outputs of aircc: the air and aie tools on the path, the air and aie
+    python packages' native libraries, the in-process aiecc module, and the
+    Peano and chess core compilers used by aiecc."""
+    files = [
+        shutil.which(t)
+        for t in [
+            "air-opt",
+            "aie-opt",
+            "aie-translate",
+            "aiecc.py",
+            "xchesscc",
+            "xchesscc_wrapper",
+        ]
+    ]
+    for module in [airdialect, aiecc]:
+        package = os.path.dirname(os.path.realpath(module.__file__))
+        while package and not os.path.isdir(os.path.join(package, "_mlir_libs")):
+            parent = os.path.dirname(package)
+            package = parent if parent != package else ""
+        if package:
+            files += glob.glob(os.path.join(package, "_mlir_libs", "*"))
+    files.append(os.path.realpath(aiecc.__file__))
+    peano_dir = os.environ.get("PEANO_INSTALL_DIR", "")
+    if peano_dir:
+        files += [
+            os.path.join(peano_dir, "bin", t) for t in ["clang", "opt", "llc", "ld.lld"]
+        ]
+    return files
+
+
 def run(mlir_module, args=None):
     global opts
     global aiecc_path
+    global cache
     if args is not None:
         opts = cl_arguments.parse_args(args)
 
@@ -360,6 +467,12 @@ def run(mlir_module, args=None):
     if opts.verbose:
         print("Using aiecc.py from: ", aiecc_path)
 
+    # cache entries are only valid for the tools and libraries which made them
+    cache = aircc_cache.CompilationCache(
+        opts.cache_dir,
+        aircc_cache.fingerprint_files(toolchain_files()) if opts.cache_dir else "",
+    )
+
     with mlir_module.context as ctx:
         _, air_mlir_filename = os.path.split(opts.air_mlir_file)
         air_place_pass = (
@@ -392,9 +505,12 @@ def run(mlir_module, args=None):
                 air_place_pass,
             ]
         )
-        air_placed_module = Module.parse(str(mlir_module))
-        run_passes(
-            "builtin.module(" + pass_pipeline + ")", air_placed_module, opts, air_placed
+        air_placed_module = run_cached_passes(
+            "air-place",
+            "builtin.module(" + pass_pipeline + ")",
+            Module.parse(str(mlir_module)),
+            opts,
+            air_placed,
         )
 
         air_to_aie_pass = "air-to-aie{"
@@ -411,10 +527,10 @@ def run(mlir_module, args=None):
         pass_pipeline = ",".join([air_to_aie_pass])
 
         air_to_aie_file = opts.tmpdir + "/aie." + air_mlir_filename
-        air_to_aie_module = Module.parse(str(air_placed_module))
-        run_passes(
+        air_to_aie_module = run_cached_passes(
+            "air-to-aie",
             "builtin.module(" + pass_pipeline + ")",
-            air_to_aie_module,
+            Module.parse(str(air_placed_module)),
             opts,
             air_to_aie_file,
         )
@@ -427,7 +543,6 @@ def run(mlir_module, args=None):
             )
 
             air_to_npu_file = opts.tmpdir + "/npu." + air_mlir_filename
-            air_to_npu_module = Module.parse(str(air_to_aie_module))
             air_to_npu_passes = (
                 "builtin.module("
                 + ",".join(
@@ -446,7 +561,13 @@ def run(mlir_module, args=None):
                 )
                 + ")"
             )
-            run_passes(air_to_npu_passes, air_to_npu_module, opts, air_to_npu_file)
+            air_to_npu_module = run_cached_passes(
+                "airrt-to-npu",
+                air_to_npu_passes,
+                Module.parse(str(air_to_aie_module)),
+                opts,
+                air_to_npu_file,
+            )
             xclbin_file = "aie.xclbin"
             if opts.output_file:
                 xclbin_file = opts.output_file
@@ -455,23 +576,45 @@ def run(mlir_module, args=None):
             else:
                 assert xclbin_file.endswith(".xclbin")
                 insts_file = opts.output_file.removesuffix(".xclbin") + ".insts.txt"
-            aiecc_options = (["-v"] if opts.verbose else []) + [
+            aiecc_flags = [
                 "--no-aiesim",
                 "--xchesscc" if opts.xchesscc else "--no-xchesscc",
                 "--xbridge" if opts.xbridge else "--no-xbridge",
                 "--aie-generate-cdo",
                 "--aie-generate-npu",
                 "--no-compile-host",
-                "--xclbin-name=" + xclbin_file,
-                "--npu-insts-name=" + insts_file,
-                air_to_npu_file,
             ]
-            aiecc.run(air_to_npu_module, aiecc_options)
+            key = cache.key("aiecc-npu", air_to_npu_module, aiecc_flags)
+            entry = cache.get("aiecc-npu", key)
+            if entry:
+                if opts.verbose:
+                    print("Using cached xclbin and npu instructions")
+                aircc_cache.copy_out(entry, "aie.xclbin", xclbin_file)
+                aircc_cache.copy_out(entry, "insts.txt", insts_file)
+            else:
+                aiecc_options = (
+                    (["-v"] if opts.verbose else [])
+                    + aiecc_flags
+                    + [
+                        "--xclbin-name=" + xclbin_file,
+                        "--npu-insts-name=" + insts_file,
+                        air_to_npu_file,
+                    ]
+                )
+                aiecc.run(air_to_npu_module, aiecc_options)
+                cache.put(
+                    "aiecc-npu",
+                    key,
+                    files={"aie.xclbin": xclbin_file, "insts.txt": insts_file},
+                )
         else:
             lower_airrt_to_airhost(
                 air_to_aie_module, air_placed_module, air_mlir_filename
             )
 
+    if cache.enabled():
+        print(cache.report())
+
 
 def main():
     global opts
@@ -57,12 +57,18 @@ class CostModel:
 
 class Runner:
     def __init__(
-        self, json_model, trace_filename=None, sim_granularity="herd", verbose=False
+        self,
+        json_model,
+        trace_filename=None,
+        sim_granularity="herd",
+        verbose=False,
+        trace_format="json",
     ):
         self.json_model = json_model
         self.trace_filename = trace_filename
         self.sim_granularity = sim_granularity
         self.verbose = verbose
+        self.trace_format = trace_format
 
     def run(self, module, function):
         air_module = _convert_module(module)
@@ -96,6 +102,7 @@ class Runner:
             function,
             self.sim_granularity,
             self.verbose,
+            self.trace_format,
         )
 
         os.unlink(json_tmpfile.name)
@@ -104,7 +111,9 @@ class Runner:
         # if the user didn't provide an output filename
         return_trace = None
         if trace_tmpfile:
-            return_trace = open(trace_tmpfile.name).read()
+            mode = "rb" if self.trace_format == "perfetto" else "r"
+            with open(trace_tmpfile.name, mode) as f:
+                return_trace = f.read()
             os.unlink(trace_tmpfile.name)
 
         return return_trace
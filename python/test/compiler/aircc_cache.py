@@ -0,0 +1,121 @@
+# ./python/test/compiler/aircc_cache.py -*- Python -*-
+
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# SPDX-License-Identifier: MIT
+
+# RUN: %PYTHON %s | FileCheck %s
+import os
+import tempfile
+
+from air.compiler.aircc.cache import (
+    CompilationCache,
+    copy_out,
+    entry_names,
+    fingerprint_files,
+    read_text,
+)
+
+
+def run(f):
+    print("\nTEST:", f.__name__)
+    f()
+    return f
+
+
+MODULE = """module {
+  func.func @f() {
+    return
+  }
+}
+"""
+
+
+# CHECK-LABEL: TEST: cache_hit_test
+# CHECK: miss: True
+# CHECK: hit: True
+# CHECK: module: True
+# CHECK: entries: ['insts.txt', 'module.mlir']
+# CHECK: insts: 0x1234
+# CHECK: aircc cache: 1 hits, 1 misses (airrt-to-npu 1/2 hits)
+@run
+def cache_hit_test():
+    with tempfile.TemporaryDirectory() as d:
+        cache = CompilationCache(os.path.join(d, "cache"))
+        key = cache.key("airrt-to-npu", MODULE, ["airrt-to-npu"])
+        print("miss:", cache.get("airrt-to-npu", key) is None)
+        insts = os.path.join(d, "insts.txt")
+        with open(insts, "w") as f:
+            f.write("0x1234")
+        cache.put(
+            "airrt-to-npu",
+            key,
+            texts={"module.mlir": MODULE},
+            files={"insts.txt": insts},
+        )
+        entry = cache.get("airrt-to-npu", key)
+        print("hit:", entry is not None)
+        print("module:", read_text(entry, "module.mlir") == MODULE)
+        print("entries:", entry_names(entry))
+        copy_out(entry, "insts.txt", os.path.join(d, "copy.txt"))
+        print("insts:", read_text(d, "copy.txt"))
+        print(cache.report())
+
+
+# CHECK-LABEL: TEST: cache_key_test
+# CHECK: whitespace: True
+# CHECK: options: False
+# CHECK: stage: False
+# CHECK: toolchain: False
+@run
+def cache_key_test():
+    cache = CompilationCache("")
+    key = cache.key("air-to-aie", MODULE, ["air-to-aie"])
+    spaced = MODULE.replace("\n", "  \n\n")
+    print("whitespace:", key == cache.key("air-to-aie", spaced, ["air-to-aie"]))
+    options = ["air-to-aie{device=npu1_4col}"]
+    print("options:", key == cache.key("air-to-aie", MODULE, options))
+    print("stage:", key == cache.key("air-place", MODULE, ["air-to-aie"]))
+    other = CompilationCache("", toolchain="other")
+    print("toolchain:", key == other.key("air-to-aie", MODULE, ["air-to-aie"]))
+
+
+# A cache without a directory is disabled
+# CHECK-LABEL: TEST: cache_disabled_test
+# CHECK: enabled: False
+# CHECK: miss: True
+# CHECK: stats: {}
+@run
+def cache_disabled_test():
+    cache = CompilationCache("")
+    key = cache.key("air-place", MODULE)
+    cache.put("air-place", key, texts={"module.mlir": MODULE})
+    print("enabled:", cache.enabled())
+    print("miss:", cache.get("air-place", key) is None)
+    print("stats:", cache.stats)
+
+
+# The toolchain fingerprint depends on file names and contents, not on where
+# the files are installed or when they were written
+# CHECK-LABEL: TEST: fingerprint_files_test
+# CHECK: moved: True
+# CHECK: touched: True
+# CHECK: changed: False
+# CHECK: missing: True
+@run
+def fingerprint_files_test():
+    with tempfile.TemporaryDirectory() as d:
+        for sub in ["a", "b"]:
+            os.makedirs(os.path.join(d, sub))
+            with open(os.path.join(d, sub, "air-opt"), "w") as f:
+                f.write("tool")
+        a = os.path.join(d, "a", "air-opt")
+        b = os.path.join(d, "b", "air-opt")
+        fingerprint = fingerprint_files([a])
+        print("moved:", fingerprint == fingerprint_files([b]))
+        os.utime(a, (0, 0))
+        print("touched:", fingerprint == fingerprint_files([a]))
+        with open(a, "w") as f:
+            f.write("tool 2")
+        print("changed:", fingerprint == fingerprint_files([a]))
+        missing = os.path.join(d, "missing")
+        print("missing:", fingerprint_files([b, missing, None]) == fingerprint)
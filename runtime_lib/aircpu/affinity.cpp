@@ -0,0 +1,171 @@
+//===- affinity.cpp ---------------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+#include "topology.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <tuple>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Parse a sysfs cpu list, e.g. "0-3,8,10-11"
+static std::vector<int> parse_cpu_list(const std::string &list) {
+  std::vector<int> ret;
+  size_t pos = 0;
+  while (pos < list.size()) {
+    size_t end = list.find(',', pos);
+    if (end == std::string::npos)
+      end = list.size();
+    std::string range = list.substr(pos, end - pos);
+    size_t dash = range.find('-');
+    try {
+      int lo = std::stoi(range.substr(0, dash));
+      int hi =
+          dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+      for (int c = lo; c <= hi; c++)
+        ret.push_back(c);
+    } catch (...) {
+    }
+    pos = end + 1;
+  }
+  return ret;
+}
+
+static bool read_line(const std::string &path, std::string &line) {
+  std::ifstream f(path);
+  return f && std::getline(f, line);
+}
+
+static int read_int(const std::string &path, int fallback) {
+  std::string line;
+  if (!read_line(path, line))
+    return fallback;
+  try {
+    return std::stoi(line);
+  } catch (...) {
+    return fallback;
+  }
+}
+
+air_topology &air_topology::get() {
+  static air_topology topology;
+  return topology;
+}
+
+air_topology::air_topology() {
+  const std::string sys = "/sys/devices/system/";
+  std::string line;
+  if (read_line(sys + "cpu/online", line))
+    cpus = parse_cpu_list(line);
+  if (cpus.empty())
+    return;
+  cpu_node.assign(*std::max_element(cpus.begin(), cpus.end()) + 1, 0);
+
+  // nodes are numbered densely from 0 on the systems we run on; stop at the
+  // first missing one
+  for (int n = 0;; n++) {
+    if (!read_line(sys + "node/node" + std::to_string(n) + "/cpulist", line))
+      break;
+    for (int c : parse_cpu_list(line))
+      if (c < (int)cpu_node.size())
+        cpu_node[c] = n;
+    nodes = n + 1;
+  }
+
+  std::vector<std::tuple<int, int, int, int>> order;
+  for (int c : cpus) {
+    std::string topo = sys + "cpu/cpu" + std::to_string(c) + "/topology/";
+    order.emplace_back(cpu_node[c], read_int(topo + "physical_package_id", 0),
+                       read_int(topo + "core_id", c), c);
+  }
+  std::sort(order.begin(), order.end());
+  for (size_t i = 0; i < order.size(); i++)
+    cpus[i] = std::get<3>(order[i]);
+}
+
+#ifdef __linux__
+// The affinity of the calling thread before it pinned a tile
+static thread_local cpu_set_t unpinned_set;
+static thread_local bool unpinned_saved = false;
+#endif
+
+void air_topology::pin_tile(size_t x, size_t y, size_t sx, size_t sy) {
+  if (cpus.empty() || !sx || !sy)
+    return;
+  pinned.store(true, std::memory_order_relaxed);
+  size_t tiles = sx * sy;
+  size_t tile = (x * sy + y) % tiles;
+  int cpu = cpus[tile * cpus.size() / tiles];
+#ifdef __linux__
+  if (!unpinned_saved)
+    unpinned_saved = !pthread_getaffinity_np(
+        pthread_self(), sizeof(unpinned_set), &unpinned_set);
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)cpu;
+#endif
+}
+
+void air_topology::unpin_tile() {
+#ifdef __linux__
+  if (!unpinned_saved)
+    return;
+  pthread_setaffinity_np(pthread_self(), sizeof(unpinned_set), &unpinned_set);
+  unpinned_saved = false;
+#endif
+}
+
+void air_topology::move_to_current_node(void *p, size_t bytes) {
+#if defined(__linux__) && defined(SYS_mbind)
+  if (nodes < 2 || !p)
+    return;
+  int cpu = sched_getcpu();
+  if (cpu < 0 || cpu >= (int)cpu_node.size())
+    return;
+  int node = cpu_node[cpu];
+
+  size_t page = sysconf(_SC_PAGESIZE);
+  uintptr_t begin = ((uintptr_t)p + page - 1) / page * page;
+  uintptr_t end = ((uintptr_t)p + bytes) / page * page;
+  if (begin >= end)
+    return;
+
+  // from <numaif.h>, which would add a libnuma dependency
+  const int mpol_preferred = 1;
+  const unsigned mpol_mf_move = 1 << 1;
+  unsigned long mask[4] = {0, 0, 0, 0};
+  if (node >= (int)(sizeof(mask) * 8))
+    return;
+  mask[node / (sizeof(long) * 8)] |= 1ul << (node % (sizeof(long) * 8));
+  syscall(SYS_mbind, (void *)begin, end - begin, mpol_preferred, mask,
+          sizeof(mask) * 8, mpol_mf_move);
+#else
+  (void)p;
+  (void)bytes;
+#endif
+}
+
+extern "C" {
+
+void _mlir_ciface_air_herd_pin_tile_I64_I64_I64_I64(uint64_t x, uint64_t y,
+                                                    uint64_t sx, uint64_t sy) {
+  air_topology::get().pin_tile(x, y, sx, sy);
+}
+
+void _mlir_ciface_air_herd_unpin_tile() { air_topology::get().unpin_tile(); }
+}
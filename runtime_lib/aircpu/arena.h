@@ -0,0 +1,79 @@
+//===- arena.h --------------------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef AIR_CPU_ARENA_H
+#define AIR_CPU_ARENA_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+// A size-class arena for runtime buffers which are created and destroyed
+// repeatedly, e.g. channel storage across the invocations of a function.
+// Requests are rounded up to a power of two of at least min_bytes, and freed
+// blocks are kept on a free list per size class for reuse instead of being
+// returned to the system. Blocks are aligned to a cache line, or to a page
+// once they span one, so that their pages can be moved between NUMA nodes.
+class air_arena {
+public:
+  static const size_t alignment = 64;
+  static const size_t page_bytes = 4096;
+  static const size_t min_bytes = 64;
+
+  ~air_arena() {
+    for (auto &blocks : free_lists)
+      for (void *p : blocks)
+        std::free(p);
+  }
+
+  void *allocate(size_t bytes) {
+    size_t cls = size_class(bytes);
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      if (cls < free_lists.size() && !free_lists[cls].empty()) {
+        void *p = free_lists[cls].back();
+        free_lists[cls].pop_back();
+        return p;
+      }
+    }
+    void *p = nullptr;
+    size_t block = min_bytes << cls;
+    if (posix_memalign(&p, block >= page_bytes ? page_bytes : alignment, block))
+      return nullptr;
+    return p;
+  }
+
+  void release(void *p, size_t bytes) {
+    if (!p)
+      return;
+    size_t cls = size_class(bytes);
+    std::lock_guard<std::mutex> lock(mtx);
+    if (cls >= free_lists.size())
+      free_lists.resize(cls + 1);
+    free_lists[cls].push_back(p);
+  }
+
+  // The arena shared by the runtime
+  static air_arena &get() {
+    static air_arena arena;
+    return arena;
+  }
+
+private:
+  static size_t size_class(size_t bytes) {
+    size_t cls = 0;
+    while ((min_bytes << cls) < bytes)
+      cls++;
+    return cls;
+  }
+
+  std::mutex mtx;
+  std::vector<std::vector<void *>> free_lists;
+};
+
+#endif // AIR_CPU_ARENA_H
@@ -0,0 +1,416 @@
+//===- aircpu_bench.cpp -----------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+// Microbenchmarks for the aircpu runtime. Every benchmark calls the runtime
+// through the same C entry points as code generated by air-to-async:
+//
+//   memcpy_nd     air.dma_memcpy_nd across ranks, strides and element types
+//   channel       air.channel put/get throughput across broadcast ratios,
+//                 producer counts and channel depths
+//   channel_rtt   air.channel put/get round-trip latency
+//   executor      tile dispatch through the parallel-for herd executor
+//
+// Results are written as JSON, one object per benchmark, so that runs can be
+// compared by scripts:
+//
+//   aircpu-bench [--filter <substring>] [--min-time-ms <ms>] [--out <file>]
+
+#include "air_tensor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+void _mlir_ciface_air_memcpy_nd_I32_M0D1I32_M0D1I32_I64_I64_I64(
+    uint32_t, void *, void *, uint64_t, uint64_t, uint64_t);
+void _mlir_ciface_air_memcpy_nd_I32_M0D1F32_M0D1F32_I64_I64_I64(
+    uint32_t, void *, void *, uint64_t, uint64_t, uint64_t);
+void _mlir_ciface_air_memcpy_nd_I32_M0D2I32_M0D2I32_I64_I64_I64_I64_I64_I64(
+    uint32_t, void *, void *, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t,
+    uint64_t);
+void _mlir_ciface_air_memcpy_nd_I32_M0D2F32_M0D2F32_I64_I64_I64_I64_I64_I64(
+    uint32_t, void *, void *, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t,
+    uint64_t);
+void _mlir_ciface_air_memcpy_nd_I32_M0D4I32_M0D4I32_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64(
+    uint32_t, void *, void *, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t,
+    uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t);
+void _mlir_ciface_air_memcpy_nd_I32_M0D4F32_M0D4F32_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64(
+    uint32_t, void *, void *, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t,
+    uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t);
+
+void _mlir_ciface_air_channel_create_M0D2I64_I64_I64_I64_I64_I64(
+    void *, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t);
+void _mlir_ciface_air_channel_destroy_M0D2I64(void *);
+void _mlir_ciface_air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(
+    void *, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t,
+    uint64_t, void *, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t,
+    uint64_t);
+void _mlir_ciface_air_channel_get_M0D2I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(
+    void *, uint64_t, uint64_t, void *, uint64_t, uint64_t, uint64_t, uint64_t,
+    uint64_t, uint64_t);
+
+uint64_t _mlir_ciface_air_executor_begin_rI64_I64_I64_I64(uint64_t, uint64_t,
+                                                         uint64_t);
+uint64_t _mlir_ciface_air_executor_workers_rI64_I64(uint64_t);
+uint64_t _mlir_ciface_air_executor_next_rI64_I64_I64(uint64_t, uint64_t);
+void _mlir_ciface_air_executor_end_I64(uint64_t);
+}
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct result_t {
+  std::string name;
+  std::vector<std::pair<std::string, std::string>> params;
+  uint64_t iterations;
+  double ns_per_iter;
+  // bytes moved per iteration, or 0 if the benchmark does not move data
+  uint64_t bytes_per_iter;
+};
+
+struct options_t {
+  std::string filter;
+  double min_time_ns = 2e8;
+  std::string out;
+};
+
+// Run `body(n)`, which performs n iterations, with a growing n until it takes
+// at least min_time_ns. Returns the time per iteration.
+double measure(const options_t &opts, std::function<void(uint64_t)> body,
+               uint64_t &iterations) {
+  body(1); // warm up
+  for (iterations = 1;; iterations *= 2) {
+    auto t0 = clock_type::now();
+    body(iterations);
+    double ns =
+        std::chrono::duration<double, std::nano>(clock_type::now() - t0)
+            .count();
+    if (ns >= opts.min_time_ns || iterations >= (1ull << 40))
+      return ns / iterations;
+  }
+}
+
+template <typename T, int R> struct tensor_buffer {
+  std::vector<T> storage;
+  tensor_t<T, R> desc;
+
+  tensor_buffer(std::vector<size_t> shape) {
+    size_t volume = 1;
+    for (int i = 0; i < R; i++) {
+      desc.shape[i] = shape[i];
+      volume *= shape[i];
+    }
+    storage.assign(volume, T(1));
+    desc.alloc = desc.data = storage.data();
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// memcpy_nd
+//===----------------------------------------------------------------------===//
+
+// A strided source read into a packed destination. Sizes and strides are
+// innermost first, as in the runtime; the source is large enough to cover the
+// pattern.
+struct memcpy_case {
+  const char *pattern;
+  int rank;
+  size_t size[4];
+  size_t stride[4];
+};
+
+template <typename T>
+void memcpy_nd(int rank, void *dst, void *src, const size_t *sz,
+               const size_t *st);
+
+template <>
+void memcpy_nd<int32_t>(int rank, void *dst, void *src, const size_t *sz,
+                        const size_t *st) {
+  if (rank == 1)
+    _mlir_ciface_air_memcpy_nd_I32_M0D1I32_M0D1I32_I64_I64_I64(0, dst, src, 0,
+                                                               sz[0], st[0]);
+  else if (rank == 2)
+    _mlir_ciface_air_memcpy_nd_I32_M0D2I32_M0D2I32_I64_I64_I64_I64_I64_I64(
+        0, dst, src, 0, 0, sz[1], sz[0], st[1], st[0]);
+  else
+    _mlir_ciface_air_memcpy_nd_I32_M0D4I32_M0D4I32_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64(
+        0, dst, src, 0, 0, 0, 0, sz[3], sz[2], sz[1], sz[0], st[3], st[2],
+        st[1], st[0]);
+}
+
+template <>
+void memcpy_nd<float>(int rank, void *dst, void *src, const size_t *sz,
+                      const size_t *st) {
+  if (rank == 1)
+    _mlir_ciface_air_memcpy_nd_I32_M0D1F32_M0D1F32_I64_I64_I64(0, dst, src, 0,
+                                                               sz[0], st[0]);
+  else if (rank == 2)
+    _mlir_ciface_air_memcpy_nd_I32_M0D2F32_M0D2F32_I64_I64_I64_I64_I64_I64(
+        0, dst, src, 0, 0, sz[1], sz[0], st[1], st[0]);
+  else
+    _mlir_ciface_air_memcpy_nd_I32_M0D4F32_M0D4F32_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64(
+        0, dst, src, 0, 0, 0, 0, sz[3], sz[2], sz[1], sz[0], st[3], st[2],
+        st[1], st[0]);
+}
+
+template <typename T>
+void bench_memcpy(const options_t &opts, const char *type,
+                  std::vector<result_t> &results) {
+  static const memcpy_case cases[] = {
+      {"contiguous", 1, {65536, 1, 1, 1}, {1, 1, 1, 1}},
+      {"stride2", 1, {32768, 1, 1, 1}, {2, 1, 1, 1}},
+      {"stride7", 1, {8192, 1, 1, 1}, {7, 1, 1, 1}},
+      {"tile_64x64_of_256", 2, {64, 64, 1, 1}, {1, 256, 1, 1}},
+      {"tile_8x8_of_256", 2, {8, 8, 1, 1}, {1, 256, 1, 1}},
+      {"transpose_64x64", 2, {64, 64, 1, 1}, {64, 1, 1, 1}},
+      {"blocked_4d", 4, {8, 8, 4, 4}, {1, 64, 8, 512}},
+  };
+  for (auto &c : cases) {
+    std::string name = std::string("memcpy_nd/") + type + "/" + c.pattern;
+    if (name.find(opts.filter) == std::string::npos)
+      continue;
+    size_t volume = 1, extent = 1;
+    for (int d = 0; d < 4; d++) {
+      volume *= c.size[d];
+      extent += (c.size[d] - 1) * c.stride[d];
+    }
+    // every rank is passed as a flat buffer; only the data pointer is read
+    tensor_buffer<T, 4> src({extent, 1, 1, 1});
+    tensor_buffer<T, 4> dst({volume, 1, 1, 1});
+    result_t r;
+    r.name = name;
+    r.params = {{"type", type},
+                {"rank", std::to_string(c.rank)},
+                {"elements", std::to_string(volume)}};
+    r.bytes_per_iter = volume * sizeof(T);
+    r.ns_per_iter = measure(
+        opts,
+        [&](uint64_t n) {
+          for (uint64_t i = 0; i < n; i++)
+            memcpy_nd<T>(c.rank, &dst.desc, &src.desc, c.size, c.stride);
+        },
+        r.iterations);
+    results.push_back(r);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// channel
+//===----------------------------------------------------------------------===//
+
+// A channel of `producers` indices, each broadcast to `bcast` consumers
+struct channel_buffer {
+  std::vector<uint64_t> storage;
+  tensor_t<uint64_t, 2> desc;
+  size_t producers, bcast, depth;
+
+  channel_buffer(size_t producers, size_t bcast, size_t depth)
+      : storage(producers, 0), producers(producers), bcast(bcast),
+        depth(depth) {
+    desc.alloc = desc.data = storage.data();
+    desc.shape[0] = 1;
+    desc.shape[1] = producers;
+    _mlir_ciface_air_channel_create_M0D2I64_I64_I64_I64_I64_I64(
+        &desc, 1, producers, 1, producers * bcast, depth);
+  }
+  ~channel_buffer() { _mlir_ciface_air_channel_destroy_M0D2I64(&desc); }
+
+  void put(size_t idx, tensor_buffer<int32_t, 2> &src, size_t rows,
+           size_t cols) {
+    _mlir_ciface_air_channel_put_M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(
+        &desc, 1, producers, 1, producers * bcast, depth, 0, idx, &src.desc,
+        0, 0, rows, cols, src.desc.shape[1], 1);
+  }
+  void get(size_t idx, tensor_buffer<int32_t, 2> &dst, size_t rows,
+           size_t cols) {
+    _mlir_ciface_air_channel_get_M0D2I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64(
+        &desc, 0, idx, &dst.desc, 0, 0, rows, cols, dst.desc.shape[1], 1);
+  }
+};
+
+void bench_channel(const options_t &opts, std::vector<result_t> &results) {
+  const size_t rows = 64, cols = 64;
+  for (size_t producers : {1, 2, 4})
+    for (size_t bcast : {1, 2, 4})
+      for (size_t depth : {1, 2}) {
+        std::string name = "channel/p" + std::to_string(producers) + "_b" +
+                           std::to_string(bcast) + "_d" +
+                           std::to_string(depth);
+        if (name.find(opts.filter) == std::string::npos)
+          continue;
+        result_t r;
+        r.name = name;
+        r.params = {{"producers", std::to_string(producers)},
+                    {"broadcast", std::to_string(bcast)},
+                    {"depth", std::to_string(depth)},
+                    {"elements", std::to_string(rows * cols)}};
+        // one iteration moves one tile from every producer to its consumers
+        r.bytes_per_iter = producers * bcast * rows * cols * sizeof(int32_t);
+        r.ns_per_iter = measure(
+            opts,
+            [&](uint64_t n) {
+              channel_buffer chan(producers, bcast, depth);
+              std::vector<std::thread> threads;
+              for (size_t p = 0; p < producers; p++) {
+                threads.emplace_back([&, p] {
+                  tensor_buffer<int32_t, 2> src({rows, cols});
+                  for (uint64_t i = 0; i < n; i++)
+                    chan.put(p, src, rows, cols);
+                });
+                for (size_t b = 0; b < bcast; b++)
+                  threads.emplace_back([&, p, b] {
+                    tensor_buffer<int32_t, 2> dst({rows, cols});
+                    for (uint64_t i = 0; i < n; i++)
+                      chan.get(p * bcast + b, dst, rows, cols);
+                  });
+              }
+              for (auto &t : threads)
+                t.join();
+            },
+            r.iterations);
+        results.push_back(r);
+      }
+}
+
+void bench_channel_rtt(const options_t &opts, std::vector<result_t> &results) {
+  for (size_t elements : {1, 1024}) {
+    std::string name = "channel_rtt/" + std::to_string(elements);
+    if (name.find(opts.filter) == std::string::npos)
+      continue;
+    result_t r;
+    r.name = name;
+    r.params = {{"elements", std::to_string(elements)}};
+    r.bytes_per_iter = 2 * elements * sizeof(int32_t);
+    r.ns_per_iter = measure(
+        opts,
+        [&](uint64_t n) {
+          channel_buffer ping(1, 1, 1), pong(1, 1, 1);
+          std::thread echo([&] {
+            tensor_buffer<int32_t, 2> buf({1, elements});
+            for (uint64_t i = 0; i < n; i++) {
+              ping.get(0, buf, 1, elements);
+              pong.put(0, buf, 1, elements);
+            }
+          });
+          tensor_buffer<int32_t, 2> buf({1, elements});
+          for (uint64_t i = 0; i < n; i++) {
+            ping.put(0, buf, 1, elements);
+            pong.get(0, buf, 1, elements);
+          }
+          echo.join();
+        },
+        r.iterations);
+    results.push_back(r);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// executor
+//===----------------------------------------------------------------------===//
+
+// Dispatch of empty tiles through the parallel-for executor, with one thread
+// per worker as in the generated code
+void bench_executor(const options_t &opts, std::vector<result_t> &results) {
+  for (uint64_t tiles : {16, 1024, 65536})
+    for (uint64_t chunk : {1, 16}) {
+      std::string name = "executor/t" + std::to_string(tiles) + "_c" +
+                         std::to_string(chunk);
+      if (name.find(opts.filter) == std::string::npos)
+        continue;
+      result_t r;
+      r.name = name;
+      r.params = {{"tiles", std::to_string(tiles)},
+                  {"chunk", std::to_string(chunk)},
+                  {"workers", std::to_string(std::max(
+                                  std::thread::hardware_concurrency(), 1u))}};
+      r.bytes_per_iter = 0;
+      r.ns_per_iter = measure(
+          opts,
+          [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+              uint64_t h = _mlir_ciface_air_executor_begin_rI64_I64_I64_I64(
+                  tiles, 0, chunk);
+              uint64_t workers = _mlir_ciface_air_executor_workers_rI64_I64(h);
+              std::vector<std::thread> threads;
+              for (uint64_t w = 0; w < workers; w++)
+                threads.emplace_back([&, w] {
+                  while (_mlir_ciface_air_executor_next_rI64_I64_I64(h, w) <
+                         tiles)
+                    ;
+                });
+              for (auto &t : threads)
+                t.join();
+              _mlir_ciface_air_executor_end_I64(h);
+            }
+          },
+          r.iterations);
+      results.push_back(r);
+    }
+}
+
+void write_json(FILE *f, const std::vector<result_t> &results) {
+  fprintf(f, "{\n  \"benchmarks\": [\n");
+  for (size_t i = 0; i < results.size(); i++) {
+    auto &r = results[i];
+    fprintf(f, "    {\"name\": \"%s\", ", r.name.c_str());
+    for (auto &p : r.params)
+      fprintf(f, "\"%s\": \"%s\", ", p.first.c_str(), p.second.c_str());
+    fprintf(f, "\"iterations\": %llu, \"ns_per_iter\": %.3f",
+            (unsigned long long)r.iterations, r.ns_per_iter);
+    if (r.bytes_per_iter)
+      fprintf(f, ", \"bytes_per_second\": %.1f",
+              r.bytes_per_iter * 1e9 / r.ns_per_iter);
+    fprintf(f, "}%s\n", i + 1 < results.size() ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  options_t opts;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+      opts.filter = argv[++i];
+    else if (!strcmp(argv[i], "--min-time-ms") && i + 1 < argc)
+      opts.min_time_ns = atof(argv[++i]) * 1e6;
+    else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+      opts.out = argv[++i];
+    else {
+      fprintf(stderr,
+              "usage: %s [--filter <substring>] [--min-time-ms <ms>] "
+              "[--out <file>]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  std::vector<result_t> results;
+  bench_memcpy<int32_t>(opts, "i32", results);
+  bench_memcpy<float>(opts, "f32", results);
+  bench_channel(opts, results);
+  bench_channel_rtt(opts, results);
+  bench_executor(opts, results);
+
+  FILE *f = opts.out.empty() ? stdout : fopen(opts.out.c_str(), "w");
+  if (!f) {
+    fprintf(stderr, "cannot open %s\n", opts.out.c_str());
+    return 1;
+  }
+  write_json(f, results);
+  if (f != stdout)
+    fclose(f);
+  return 0;
+}
@@ -3,28 +3,52 @@
 
 #include "air_channel.h"
 #include "air_tensor.h"
+#include "arena.h"
+#include "copy.h"
+#include "topology.h"
+#include "trace.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #define VERBOSE 0
 
-template <typename T, int R>
-static void _air_channel_put(tensor_t<uint64_t, 2> *channel, size_t *chnl_size,
-                             size_t *chnl_bcast_size, size_t *chnl_idx,
-                             tensor_t<T, R> *src, size_t *_offset,
-                             size_t *_size, size_t *_stride) {
-  size_t offset[4] = {0, 0, 0, 0};
-  size_t size[4] = {1, 1, 1, 1};
-  size_t stride[4] = {1, 1, 1, 1};
-  for (int i = 0; i < R; i++) {
-    offset[i] = _offset[i];
-    size[i] = _size[i];
-    stride[i] = _stride[i];
-  }
+// Channel creation and destruction are serialized by a registry lock. A
+// channel memref holds one channel_t pointer per channel index; its first
+// entry is published last, so that a non-zero data[0] means the channel is
+// fully created. Consumers which reach a channel before it is created block
+// on the registry condition variable.
+//
+// Puts and gets look up their channel_t without the lock. They count
+// themselves in channel_lookups from before they load the pointer until they
+// have entered the channel_t, so that a destroy which has unpublished the
+// pointers can wait for the count to drain before it waits for the channel
+// to go idle and frees it.
+static std::mutex channel_registry_mtx;
+static std::condition_variable channel_registry_cv;
+static std::atomic<int> channel_lookups{0};
 
-  // calculate broadcast ratio
-  size_t ratio[2] = {1, 1};
+// Destination of a get which waits for its data, left on the slot for the
+// producer (see channel_t). A put from a contiguous source writes it with the
+// get's own access pattern and sets delivered, so that the get skips its copy.
+struct air_channel_claim {
+  void *dst;
+  const air_copy_plan *plan;
+  bool delivered;
+};
+
+static channel_t *air_channel_load(tensor_t<uint64_t, 2> *channel,
+                                   size_t idx) {
+  return (channel_t *)__atomic_load_n(&channel->data[idx], __ATOMIC_SEQ_CST);
+}
+
+// calculate the broadcast ratio of a channel
+static void air_channel_ratio(size_t *chnl_size, size_t *chnl_bcast_size,
+                              size_t ratio[2]) {
   for (int i = 0; i < 2; i++) {
     // raise error if the channel size is not divisible by the broadcast size
     if (chnl_bcast_size[i] % chnl_size[i] != 0) {
@@ -34,42 +58,134 @@ static void _air_channel_put(tensor_t<uint64_t, 2> *channel, size_t *chnl_size,
     }
     ratio[i] = chnl_bcast_size[i] / chnl_size[i];
   }
+}
 
-  // channel->data is an array of pointers to channel_t objects
-  // if the channel is valid, channel->data[0] should be a valid memory address
-  // otherwise, allocate a new channel
-  if (channel->data[0] == 0) {
-    for (size_t i = 0; i < channel->shape[0] * channel->shape[1]; i++) {
-      channel_t<T> *new_channel = new channel_t<T>(size, ratio);
-      channel->data[i] = (uint64_t)new_channel;
+// Create the channel_t objects of a channel, or take another reference to
+// them if the channel already exists. Must be called with the registry lock
+// held.
+static void air_channel_create_locked(tensor_t<uint64_t, 2> *channel,
+                                      size_t ratio[2], size_t depth) {
+  if (uint64_t head = channel->data[0]) {
+    ((channel_t *)head)->users++;
+    return;
+  }
+  size_t count = channel->shape[0] * channel->shape[1];
+  for (size_t i = count; i-- > 0;) {
+    uint64_t new_channel = (uint64_t) new channel_t(ratio, depth);
+    __atomic_store_n(&channel->data[i], new_channel, __ATOMIC_RELEASE);
+  }
+  channel_registry_cv.notify_all();
+}
+
+static void _air_channel_create(tensor_t<uint64_t, 2> *channel,
+                                size_t *chnl_size, size_t *chnl_bcast_size,
+                                size_t chnl_depth) {
+  size_t ratio[2] = {1, 1};
+  air_channel_ratio(chnl_size, chnl_bcast_size, ratio);
+  std::lock_guard<std::mutex> lock(channel_registry_mtx);
+  air_channel_create_locked(channel, ratio, chnl_depth);
+}
+
+// Drop a reference to a channel. The last owner unpublishes every index of
+// the channel under the registry lock, then, without the lock, waits for the
+// puts and gets in flight, returns the slot storage to the arena and frees
+// the channel_t objects.
+static void _air_channel_destroy(tensor_t<uint64_t, 2> *channel) {
+  std::vector<channel_t *> chans;
+  {
+    std::lock_guard<std::mutex> lock(channel_registry_mtx);
+    channel_t *head = (channel_t *)channel->data[0];
+    if (!head || --head->users)
+      return;
+    size_t count = channel->shape[0] * channel->shape[1];
+    for (size_t i = 0; i < count; i++) {
+      chans.push_back((channel_t *)channel->data[i]);
+      __atomic_store_n(&channel->data[i], 0, __ATOMIC_SEQ_CST);
     }
   }
+  // lookups which loaded a pointer before it was unpublished enter the
+  // channel_t before they leave channel_lookups, and wait_idle() covers them
+  while (channel_lookups.load())
+    std::this_thread::yield();
+  for (channel_t *chan : chans) {
+    chan->wait_idle();
+    air_arena::get().release(chan->data, chan->slot_bytes * chan->depth);
+    delete chan;
+  }
+}
+
+template <typename T, int R>
+static void _air_channel_put(tensor_t<uint64_t, 2> *channel, size_t *chnl_size,
+                             size_t *chnl_bcast_size, size_t chnl_depth,
+                             size_t *chnl_idx, tensor_t<T, R> *src,
+                             size_t *_offset, size_t *_size, size_t *_stride) {
+  size_t offset[4] = {0, 0, 0, 0};
+  size_t size[4] = {1, 1, 1, 1};
+  size_t stride[4] = {1, 1, 1, 1};
+  for (int i = 0; i < R; i++) {
+    offset[i] = _offset[i];
+    size[i] = _size[i];
+    stride[i] = _stride[i];
+  }
+  uint64_t begin = air_trace_enabled ? air_trace_now() : 0;
+  uint64_t blocked = 0;
 
   size_t idx = chnl_idx[1] * chnl_size[1] + chnl_idx[0];
-  channel_t<T> *chan = (channel_t<T> *)channel->data[idx];
+  channel_t *chan = nullptr;
+  while (!chan) {
+    channel_lookups.fetch_add(1);
+    if ((chan = air_channel_load(channel, idx)))
+      chan->enter();
+    channel_lookups.fetch_sub(1);
+    if (chan)
+      break;
+    // channels are created by air_channel_create; if this module does not
+    // call it, create the channel on its first put instead
+    size_t ratio[2] = {1, 1};
+    air_channel_ratio(chnl_size, chnl_bcast_size, ratio);
+    std::lock_guard<std::mutex> lock(channel_registry_mtx);
+    if (!channel->data[0])
+      air_channel_create_locked(channel, ratio, chnl_depth);
+  }
+
+  // the first put sizes the slots of the channel
+  size_t bytes = size[0] * size[1] * size[2] * size[3] * sizeof(T);
+  if (!chan->reserve(bytes,
+                     [](size_t n) { return air_arena::get().allocate(n); })) {
+    std::cerr << "channel put is larger than the channel's buffers"
+              << std::endl;
+    exit(1);
+  }
 
-  // wait until the channel is empty
-  std::unique_lock<std::mutex> lock(chan->mtx);
-  chan->cv.wait(lock, [&chan] { return chan->token.load() == 0; });
+  // wait until the next slot in the channel is free
+  size_t pos;
+  T *slot = (T *)chan->acquire_write(pos);
+  if (air_trace_enabled)
+    blocked = air_trace_now() - begin;
 
   if (VERBOSE)
     std::cerr << "dst offset " << offset[1] << ", " << offset[0] << ", size "
               << size[1] << ", " << size[0] << ", stride " << stride[1] << ", "
               << stride[0] << std::endl;
-  size_t src_offset = 0;
-  for (size_t l = 0; l < size[3]; l++)
-    for (size_t k = 0; k < size[2]; k++)
-      for (size_t j = 0; j < size[1]; j++)
-        for (size_t i = 0; i < size[0]; i++) {
-          size_t idx =
-              ((offset[3] + l) * stride[3]) + ((offset[2] + k) * stride[2]) +
-              ((offset[1] + j) * stride[1]) + ((offset[0] + i) * stride[0]);
-          chan->data[src_offset++] = src->data[idx];
-        }
-
-  // mark the channel as full
-  chan->token.store(ratio[0] * ratio[1]);
-  chan->cv.notify_all();
+  // copy into the slot, so that the put returns as soon as a slot is free
+  // and the producer may reuse its buffer (or get from the same channel);
+  // a contiguous source goes straight to a consumer already waiting for it
+  air_copy_plan plan(offset, size, stride);
+  auto *claim = (air_channel_claim *)chan->take_claim(pos);
+  if (claim && plan.ndims == 1 && plan.stride[0] == 1 &&
+      claim->plan->volume() <= plan.volume()) {
+    air_copy_nd<T, false>((T *)claim->dst, src->data + plan.base,
+                          *claim->plan);
+    claim->delivered = true;
+  } else {
+    air_copy_nd<T, true>(src->data, slot, plan);
+  }
+  // publish the slot to every broadcast consumer
+  chan->release_write(pos);
+  if (air_trace_enabled)
+    air_trace_channel(channel->data, idx, true, begin, blocked, bytes,
+                      chan->readers);
+  chan->leave();
 }
 
 template <typename T, int R>
@@ -88,39 +204,56 @@ static void _air_channel_get(tensor_t<uint64_t, 2> *channel, size_t *chnl_idx,
     std::cerr << "dst offset " << offset[1] << ", " << offset[0] << ", size "
               << size[1] << ", " << size[0] << ", stride " << stride[1] << ", "
               << stride[0] << std::endl;
+  uint64_t begin = air_trace_enabled ? air_trace_now() : 0;
 
-  // if channel get called before channel put, wait until the channel becomes
-  // available
-  while (channel->data[0] == 0) {
-    // yield the processor
-    std::this_thread::yield();
+  channel_t *chan = nullptr;
+  size_t idx = 0, reader = 0;
+  while (!chan) {
+    channel_lookups.fetch_add(1);
+    // get bcast_ratio from the the first channel
+    if (channel_t *chan0 = air_channel_load(channel, 0)) {
+      size_t ratio0 = chan0->bcast_ratio[0];
+      size_t ratio1 = chan0->bcast_ratio[1];
+      idx = chnl_idx[1] / ratio1 * channel->shape[1] + chnl_idx[0] / ratio0;
+      reader = (chnl_idx[1] % ratio1) * ratio0 + chnl_idx[0] % ratio0;
+      if ((chan = air_channel_load(channel, idx)))
+        chan->enter(reader);
+    }
+    channel_lookups.fetch_sub(1);
+    if (chan)
+      break;
+    // if channel get called before the channel is created, block until it is
+    std::unique_lock<std::mutex> lock(channel_registry_mtx);
+    channel_registry_cv.wait(
+        lock, [&] { return air_channel_load(channel, 0) != nullptr; });
   }
-  // get bcast_ratio from the the first channel
-  channel_t<T> *chan0 = (channel_t<T> *)channel->data[0];
-  size_t ratio0 = chan0->bcast_ratio[0];
-  size_t ratio1 = chan0->bcast_ratio[1];
-  size_t idx = chnl_idx[1] / ratio1 * channel->shape[1] + chnl_idx[0] / ratio0;
-  channel_t<T> *chan = (channel_t<T> *)channel->data[idx];
-
-  // wait until the channel is full
-  std::unique_lock<std::mutex> lock(chan->mtx);
-  chan->cv.wait(lock, [&chan] { return chan->token.load() > 0; });
-
-  // copy data from buffer to dst
-  size_t dst_offset = 0;
-  for (size_t l = 0; l < size[3]; l++)
-    for (size_t k = 0; k < size[2]; k++)
-      for (size_t j = 0; j < size[1]; j++)
-        for (size_t i = 0; i < size[0]; i++) {
-          size_t idx =
-              ((offset[3] + l) * stride[3]) + ((offset[2] + k) * stride[2]) +
-              ((offset[1] + j) * stride[1]) + ((offset[0] + i) * stride[0]);
-          dst->data[idx] = chan->data[dst_offset++];
-        }
-
-  // each channel.get uses up one broadcast token
-  chan->token.fetch_sub(1);
-  chan->cv.notify_all();
+
+  // wait until the next slot for this broadcast consumer is full; broadcast
+  // consumers share the slot and read it concurrently
+  air_copy_plan plan(offset, size, stride);
+  air_channel_claim claim = {dst->data, &plan, false};
+  size_t pos;
+  T *slot = (T *)chan->acquire_read(reader, pos, &claim);
+  uint64_t blocked = air_trace_enabled ? air_trace_now() - begin : 0;
+
+  // with pinned tiles, keep the slots on the node of the first consumer
+  air_topology &topology = air_topology::get();
+  if (topology.pinning())
+    std::call_once(chan->placement_once, [&] {
+      topology.move_to_current_node(chan->data, chan->slot_bytes * chan->depth);
+    });
+
+  // copy data from buffer to dst, unless the producer delivered it there
+  if (!claim.delivered)
+    air_copy_nd<T, false>(dst->data, slot, plan);
+
+  // each channel.get releases the slot for one broadcast consumer
+  chan->release_read(pos);
+  if (air_trace_enabled)
+    air_trace_channel(channel->data, idx, false, begin, blocked,
+                      size[0] * size[1] * size[2] * size[3] * sizeof(T),
+                      chan->readers);
+  chan->leave(reader);
 }
 
 template <typename T, int R>
@@ -141,7 +274,7 @@ static void air_channel_get(void *c, uint64_t chnl_idx1, uint64_t chnl_idx0,
 
 template <typename T, int R>
 static void air_channel_put(void *c, uint64_t chnl_size1, uint64_t chnl_size0,
-                            uint64_t bsize1, uint64_t bsize0,
+                            uint64_t bsize1, uint64_t bsize0, uint64_t depth,
                             uint64_t chnl_idx1, uint64_t chnl_idx0, void *s,
                             uint64_t offset3, uint64_t offset2,
                             uint64_t offset1, uint64_t offset0, uint64_t size3,
@@ -156,8 +289,23 @@ static void air_channel_put(void *c, uint64_t chnl_size1, uint64_t chnl_size0,
   size_t offset[4] = {offset0, offset1, offset2, offset3};
   size_t size[4] = {size0, size1, size2, size3};
   size_t stride[4] = {stride0, stride1, stride2, stride3};
-  _air_channel_put<T, R>(channel, chnl_size, chnl_bcast_size, chnl_idx, src,
-                         offset, size, stride);
+  _air_channel_put<T, R>(channel, chnl_size, chnl_bcast_size, depth, chnl_idx,
+                         src, offset, size, stride);
+}
+
+extern "C" {
+void _mlir_ciface_air_channel_create_M0D2I64_I64_I64_I64_I64_I64(
+    void *c, uint64_t chnl_size1, uint64_t chnl_size0, uint64_t bsize1,
+    uint64_t bsize0, uint64_t depth) {
+  tensor_t<uint64_t, 2> *channel = (tensor_t<uint64_t, 2> *)c;
+  size_t chnl_size[2] = {chnl_size0, chnl_size1};
+  size_t chnl_bcast_size[2] = {bsize0, bsize1};
+  _air_channel_create(channel, chnl_size, chnl_bcast_size, depth);
+}
+
+void _mlir_ciface_air_channel_destroy_M0D2I64(void *c) {
+  _air_channel_destroy((tensor_t<uint64_t, 2> *)c);
+}
 }
 
 // 4D
@@ -176,12 +324,12 @@ static void air_channel_put(void *c, uint64_t chnl_size1, uint64_t chnl_size0,
 #define mlir_air_channel_put_4d(mangle, type)                                  \
   void _mlir_ciface_air_channel_put_##mangle(                                  \
       void *c, uint64_t chnl_size1, uint64_t chnl_size0, uint64_t bsize1,      \
-      uint64_t bsize0, uint64_t chnl_idx1, uint64_t chnl_idx0, void *s,        \
-      uint64_t offset3, uint64_t offset2, uint64_t offset1, uint64_t offset0,  \
-      uint64_t size3, uint64_t size2, uint64_t size1, uint64_t size0,          \
-      uint64_t stride3, uint64_t stride2, uint64_t stride1,                    \
+      uint64_t bsize0, uint64_t depth, uint64_t chnl_idx1, uint64_t chnl_idx0, \
+      void *s, uint64_t offset3, uint64_t offset2, uint64_t offset1,           \
+      uint64_t offset0, uint64_t size3, uint64_t size2, uint64_t size1,        \
+      uint64_t size0, uint64_t stride3, uint64_t stride2, uint64_t stride1,    \
       uint64_t stride0) {                                                      \
-    air_channel_put<type, 4>(c, chnl_size1, chnl_size0, bsize1, bsize0,        \
+    air_channel_put<type, 4>(c, chnl_size1, chnl_size0, bsize1, bsize0, depth, \
                              chnl_idx1, chnl_idx0, s, offset3, offset2,        \
                              offset1, offset0, size3, size2, size1, size0,     \
                              stride3, stride2, stride1, stride0);              \
@@ -202,11 +350,11 @@ static void air_channel_put(void *c, uint64_t chnl_size1, uint64_t chnl_size0,
 #define mlir_air_channel_put_3d(mangle, type)                                  \
   void _mlir_ciface_air_channel_put_##mangle(                                  \
       void *c, uint64_t chnl_size1, uint64_t chnl_size0, uint64_t bsize1,      \
-      uint64_t bsize0, uint64_t chnl_idx1, uint64_t chnl_idx0, void *s,        \
-      uint64_t offset2, uint64_t offset1, uint64_t offset0, uint64_t size2,    \
-      uint64_t size1, uint64_t size0, uint64_t stride2, uint64_t stride1,      \
-      uint64_t stride0) {                                                      \
-    air_channel_put<type, 3>(c, chnl_size1, chnl_size0, bsize1, bsize0,        \
+      uint64_t bsize0, uint64_t depth, uint64_t chnl_idx1, uint64_t chnl_idx0, \
+      void *s, uint64_t offset2, uint64_t offset1, uint64_t offset0,           \
+      uint64_t size2, uint64_t size1, uint64_t size0, uint64_t stride2,        \
+      uint64_t stride1, uint64_t stride0) {                                    \
+    air_channel_put<type, 3>(c, chnl_size1, chnl_size0, bsize1, bsize0, depth, \
                              chnl_idx1, chnl_idx0, s, 0, offset2, offset1,     \
                              offset0, 1, size2, size1, size0, 1, stride2,      \
                              stride1, stride0);                                \
@@ -226,10 +374,10 @@ static void air_channel_put(void *c, uint64_t chnl_size1, uint64_t chnl_size0,
 #define mlir_air_channel_put_2d(mangle, type)                                  \
   void _mlir_ciface_air_channel_put_##mangle(                                  \
       void *c, uint64_t chnl_size1, uint64_t chnl_size0, uint64_t bsize1,      \
-      uint64_t bsize0, uint64_t chnl_idx1, uint64_t chnl_idx0, void *s,        \
-      uint64_t offset1, uint64_t offset0, uint64_t size1, uint64_t size0,      \
-      uint64_t stride1, uint64_t stride0) {                                    \
-    air_channel_put<type, 2>(c, chnl_size1, chnl_size0, bsize1, bsize0,        \
+      uint64_t bsize0, uint64_t depth, uint64_t chnl_idx1, uint64_t chnl_idx0, \
+      void *s, uint64_t offset1, uint64_t offset0, uint64_t size1,             \
+      uint64_t size0, uint64_t stride1, uint64_t stride0) {                    \
+    air_channel_put<type, 2>(c, chnl_size1, chnl_size0, bsize1, bsize0, depth, \
                              chnl_idx1, chnl_idx0, s, 0, 0, offset1, offset0,  \
                              1, 1, size1, size0, 1, 1, stride1, stride0);      \
   }
@@ -246,54 +394,41 @@ static void air_channel_put(void *c, uint64_t chnl_size1, uint64_t chnl_size0,
 #define mlir_air_channel_put_1d(mangle, type)                                  \
   void _mlir_ciface_air_channel_put_##mangle(                                  \
       void *c, uint64_t chnl_size1, uint64_t chnl_size0, uint64_t bsize1,      \
-      uint64_t bsize0, uint64_t chnl_idx1, uint64_t chnl_idx0, void *s,        \
-      uint64_t offset0, uint64_t size0, uint64_t stride0) {                    \
-    air_channel_put<type, 1>(c, chnl_size1, chnl_size0, bsize1, bsize0,        \
+      uint64_t bsize0, uint64_t depth, uint64_t chnl_idx1, uint64_t chnl_idx0, \
+      void *s, uint64_t offset0, uint64_t size0, uint64_t stride0) {           \
+    air_channel_put<type, 1>(c, chnl_size1, chnl_size0, bsize1, bsize0, depth, \
                              chnl_idx1, chnl_idx0, s, 0, 0, 0, offset0, 1, 1,  \
                              1, size0, 1, 1, 1, stride0);                      \
   }
 
-extern "C" {
-// 4D
-mlir_air_channel_get_4d(
-    M0D2I64_I64_I64_M0D4I32_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64,
-    int32_t);
-mlir_air_channel_put_4d(
-    M0D2I64_I64_I64_I64_I64_I64_I64_M0D4I32_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64,
-    int32_t);
-mlir_air_channel_get_4d(
-    M0D2I64_I64_I64_M0D4F32_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64,
-    float);
-mlir_air_channel_put_4d(
-    M0D2I64_I64_I64_I64_I64_I64_I64_M0D4F32_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64,
-    float);
-
-// 3D
-mlir_air_channel_get_3d(
-    M0D2I64_I64_I64_M0D3I32_I64_I64_I64_I64_I64_I64_I64_I64_I64, int32_t);
-mlir_air_channel_put_3d(
-    M0D2I64_I64_I64_I64_I64_I64_I64_M0D3I32_I64_I64_I64_I64_I64_I64_I64_I64_I64,
-    int32_t);
-mlir_air_channel_get_3d(
-    M0D2I64_I64_I64_M0D3F32_I64_I64_I64_I64_I64_I64_I64_I64_I64, float);
-mlir_air_channel_put_3d(
-    M0D2I64_I64_I64_I64_I64_I64_I64_M0D3F32_I64_I64_I64_I64_I64_I64_I64_I64_I64,
-    float);
+// Instantiate the put and get entry points of every rank for an element type,
+// given its mangled name. bf16 and f16 share the F16 mangling.
+#define mlir_air_channel(M, type)                                              \
+  mlir_air_channel_get_4d(                                                     \
+      M0D2I64_I64_I64_M0D4##M##_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64, \
+      type);                                                                   \
+  mlir_air_channel_put_4d(                                                     \
+      M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D4##M##_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64, \
+      type);                                                                   \
+  mlir_air_channel_get_3d(                                                     \
+      M0D2I64_I64_I64_M0D3##M##_I64_I64_I64_I64_I64_I64_I64_I64_I64, type);    \
+  mlir_air_channel_put_3d(                                                     \
+      M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D3##M##_I64_I64_I64_I64_I64_I64_I64_I64_I64, \
+      type);                                                                   \
+  mlir_air_channel_get_2d(M0D2I64_I64_I64_M0D2##M##_I64_I64_I64_I64_I64_I64,   \
+                          type);                                               \
+  mlir_air_channel_put_2d(                                                     \
+      M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D2##M##_I64_I64_I64_I64_I64_I64,   \
+      type);                                                                   \
+  mlir_air_channel_get_1d(M0D2I64_I64_I64_M0D1##M##_I64_I64_I64, type);        \
+  mlir_air_channel_put_1d(                                                     \
+      M0D2I64_I64_I64_I64_I64_I64_I64_I64_M0D1##M##_I64_I64_I64, type)
 
-// 2D
-mlir_air_channel_get_2d(M0D2I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64,
-                        int32_t);
-mlir_air_channel_put_2d(
-    M0D2I64_I64_I64_I64_I64_I64_I64_M0D2I32_I64_I64_I64_I64_I64_I64, int32_t);
-mlir_air_channel_get_2d(M0D2I64_I64_I64_M0D2F32_I64_I64_I64_I64_I64_I64, float);
-mlir_air_channel_put_2d(
-    M0D2I64_I64_I64_I64_I64_I64_I64_M0D2F32_I64_I64_I64_I64_I64_I64, float);
-
-// 1D
-mlir_air_channel_get_1d(M0D2I64_I64_I64_M0D1I32_I64_I64_I64, int32_t);
-mlir_air_channel_put_1d(M0D2I64_I64_I64_I64_I64_I64_I64_M0D1I32_I64_I64_I64,
-                        int32_t);
-mlir_air_channel_get_1d(M0D2I64_I64_I64_M0D1F32_I64_I64_I64, float);
-mlir_air_channel_put_1d(M0D2I64_I64_I64_I64_I64_I64_I64_M0D1F32_I64_I64_I64,
-                        float);
+extern "C" {
+mlir_air_channel(I8, int8_t);
+mlir_air_channel(I16, int16_t);
+mlir_air_channel(F16, uint16_t);
+mlir_air_channel(I32, int32_t);
+mlir_air_channel(F32, float);
+mlir_air_channel(I64, int64_t);
 }
@@ -0,0 +1,183 @@
+//===- copy.h ---------------------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef AIR_CPU_COPY_H
+#define AIR_CPU_COPY_H
+
+#include <cstddef>
+#include <cstring>
+
+// Copy engine for the strided 4-d access patterns of air.dma_memcpy_nd and
+// air.channel put/get. One side of the copy is addressed by the access pattern
+// (element index sum((offset[d] + i[d]) * stride[d]), dimension 0 innermost),
+// the other side is a packed buffer.
+//
+// Dimensions of size one are dropped and dimensions which continue a
+// contiguous run are folded into it, so that e.g. a whole-tensor copy becomes a
+// single memcpy. The copy then runs a loop nest of exactly the remaining rank,
+// with index arithmetic hoisted out of the innermost loop. The innermost loop
+// uses memcpy for unit strides (of a compile-time length for common short
+// runs) and a constant-stride loop, which the compiler can vectorize as a
+// gather/scatter, for small fixed strides.
+struct air_copy_plan {
+  size_t base;
+  int ndims;
+  size_t size[4];
+  size_t stride[4];
+
+  air_copy_plan(size_t offset[4], size_t _size[4], size_t _stride[4]) {
+    base = 0;
+    ndims = 0;
+    bool empty = false;
+    for (int d = 0; d < 4; d++) {
+      base += offset[d] * _stride[d];
+      empty |= _size[d] == 0;
+      if (_size[d] == 1)
+        continue;
+      if (ndims && _stride[d] == stride[ndims - 1] * size[ndims - 1]) {
+        size[ndims - 1] *= _size[d];
+        continue;
+      }
+      size[ndims] = _size[d];
+      stride[ndims] = _stride[d];
+      ndims++;
+    }
+    if (!ndims || empty) {
+      ndims = 1;
+      size[0] = empty ? 0 : 1;
+      stride[0] = 1;
+    }
+    for (int d = ndims; d < 4; d++) {
+      size[d] = 1;
+      stride[d] = 0;
+    }
+  }
+
+  size_t volume() const { return size[0] * size[1] * size[2] * size[3]; }
+};
+
+// Copy one run of n elements between the strided and the packed side
+template <typename T, bool ToPacked, size_t S>
+static inline void air_copy_run_fixed(T *__restrict strided,
+                                      T *__restrict packed, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (ToPacked)
+      packed[i] = strided[i * S];
+    else
+      strided[i * S] = packed[i];
+  }
+}
+
+template <typename T, bool ToPacked>
+static inline void air_copy_run(T *__restrict strided, T *__restrict packed,
+                                size_t n, size_t stride) {
+  switch (stride) {
+  case 1:
+    if (ToPacked)
+      std::memcpy(packed, strided, n * sizeof(T));
+    else
+      std::memcpy(strided, packed, n * sizeof(T));
+    return;
+  case 2:
+    air_copy_run_fixed<T, ToPacked, 2>(strided, packed, n);
+    return;
+  case 4:
+    air_copy_run_fixed<T, ToPacked, 4>(strided, packed, n);
+    return;
+  default:
+    for (size_t i = 0; i < n; i++) {
+      if (ToPacked)
+        packed[i] = strided[i * stride];
+      else
+        strided[i * stride] = packed[i];
+    }
+  }
+}
+
+// Innermost run of a length known at compile time, for unit strides
+template <typename T, bool ToPacked, size_t N> struct air_copy_fixed_run {
+  void operator()(T *__restrict strided, T *__restrict packed) const {
+    if (ToPacked)
+      std::memcpy(packed, strided, N * sizeof(T));
+    else
+      std::memcpy(strided, packed, N * sizeof(T));
+  }
+};
+
+template <typename T, bool ToPacked> struct air_copy_generic_run {
+  size_t n;
+  size_t stride;
+  void operator()(T *strided, T *packed) const {
+    air_copy_run<T, ToPacked>(strided, packed, n, stride);
+  }
+};
+
+// Loop nest of exactly R dimensions, the innermost of which is one run
+template <typename T, bool ToPacked, int R, typename Run> struct air_copy_loop {
+  static void run(T *strided, T *&packed, const air_copy_plan &plan,
+                  const Run &copy_run) {
+    for (size_t i = 0; i < plan.size[R - 1]; i++)
+      air_copy_loop<T, ToPacked, R - 1, Run>::run(
+          strided + i * plan.stride[R - 1], packed, plan, copy_run);
+  }
+};
+
+template <typename T, bool ToPacked, typename Run>
+struct air_copy_loop<T, ToPacked, 1, Run> {
+  static void run(T *strided, T *&packed, const air_copy_plan &plan,
+                  const Run &copy_run) {
+    copy_run(strided, packed);
+    packed += plan.size[0];
+  }
+};
+
+template <typename T, bool ToPacked, int R>
+static void air_copy_nd_rank(T *strided, T *packed,
+                             const air_copy_plan &plan) {
+  T *base = strided + plan.base;
+  // short contiguous runs, e.g. the rows of a small tile, use a fixed-size
+  // copy which the compiler expands inline
+  if (plan.stride[0] == 1) {
+    switch (plan.size[0]) {
+#define AIR_COPY_FIXED_RUN(N)                                                  \
+  case N:                                                                      \
+    air_copy_loop<T, ToPacked, R, air_copy_fixed_run<T, ToPacked, N>>::run(     \
+        base, packed, plan, air_copy_fixed_run<T, ToPacked, N>());             \
+    return;
+      AIR_COPY_FIXED_RUN(4)
+      AIR_COPY_FIXED_RUN(8)
+      AIR_COPY_FIXED_RUN(16)
+      AIR_COPY_FIXED_RUN(32)
+      AIR_COPY_FIXED_RUN(64)
+#undef AIR_COPY_FIXED_RUN
+    default:
+      break;
+    }
+  }
+  air_copy_generic_run<T, ToPacked> copy_run{plan.size[0], plan.stride[0]};
+  air_copy_loop<T, ToPacked, R, air_copy_generic_run<T, ToPacked>>::run(
+      base, packed, plan, copy_run);
+}
+
+// Copy between the access pattern of a plan on "strided" and the packed buffer
+// "packed". With ToPacked, data moves from the strided to the packed side.
+// Dispatches to a loop nest of exactly the plan's (collapsed) rank.
+template <typename T, bool ToPacked>
+static void air_copy_nd(T *strided, T *packed, const air_copy_plan &plan) {
+  switch (plan.ndims) {
+  case 1:
+    return air_copy_nd_rank<T, ToPacked, 1>(strided, packed, plan);
+  case 2:
+    return air_copy_nd_rank<T, ToPacked, 2>(strided, packed, plan);
+  case 3:
+    return air_copy_nd_rank<T, ToPacked, 3>(strided, packed, plan);
+  default:
+    return air_copy_nd_rank<T, ToPacked, 4>(strided, packed, plan);
+  }
+}
+
+#endif // AIR_CPU_COPY_H
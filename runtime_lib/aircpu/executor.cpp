@@ -0,0 +1,106 @@
+//===- executor.cpp ---------------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+// Work-stealing tile scheduler for the parallel-for lowering of air.herd,
+// air.segment and air.launch (air-to-async herd-executor=parallel-for).
+//
+// The generated code starts one async task per worker, and each task asks the
+// scheduler for the next tile of the iteration space until it is exhausted.
+// Every worker owns a contiguous range of tiles, so neighbouring tiles stay on
+// the same worker. A worker which runs out of tiles steals the upper half of
+// another worker's remaining range, but never fewer than `chunk` tiles.
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+struct air_executor_t {
+  struct worker_t {
+    std::mutex mtx;
+    // remaining tiles [lo, hi) owned by the worker
+    size_t lo;
+    size_t hi;
+    // keep the ranges of different workers on different cache lines
+    char pad[64];
+  };
+
+  size_t total;
+  size_t chunk;
+  size_t num_workers;
+  std::unique_ptr<worker_t[]> workers;
+
+  air_executor_t(size_t total, size_t max_workers, size_t chunk)
+      : total(total), chunk(std::max<size_t>(chunk, 1)) {
+    if (!max_workers)
+      max_workers = std::max(std::thread::hardware_concurrency(), 1u);
+    // at least one chunk per worker, and at least one worker
+    size_t chunks = (total + this->chunk - 1) / this->chunk;
+    num_workers = std::max<size_t>(std::min(max_workers, chunks), 1);
+    workers.reset(new worker_t[num_workers]);
+    for (size_t w = 0; w < num_workers; w++) {
+      workers[w].lo = total * w / num_workers;
+      workers[w].hi = total * (w + 1) / num_workers;
+    }
+  }
+
+  // Returns the next tile for a worker, or `total` once every tile is taken
+  size_t next(size_t w) {
+    worker_t &self = workers[w % num_workers];
+    {
+      std::lock_guard<std::mutex> lock(self.mtx);
+      if (self.lo < self.hi)
+        return self.lo++;
+    }
+    for (size_t k = 1; k < num_workers; k++) {
+      worker_t &victim = workers[(w + k) % num_workers];
+      size_t lo, hi;
+      {
+        std::lock_guard<std::mutex> lock(victim.mtx);
+        size_t remaining = victim.hi - victim.lo;
+        if (!remaining)
+          continue;
+        size_t take = std::max(remaining / 2, std::min(chunk, remaining));
+        hi = victim.hi;
+        lo = hi - take;
+        victim.hi = lo;
+      }
+      std::lock_guard<std::mutex> lock(self.mtx);
+      self.lo = lo + 1;
+      self.hi = hi;
+      return lo;
+    }
+    return total;
+  }
+};
+
+} // namespace
+
+extern "C" {
+
+uint64_t _mlir_ciface_air_executor_begin_rI64_I64_I64_I64(uint64_t total,
+                                                         uint64_t workers,
+                                                         uint64_t chunk) {
+  return (uint64_t) new air_executor_t(total, workers, chunk);
+}
+
+uint64_t _mlir_ciface_air_executor_workers_rI64_I64(uint64_t handle) {
+  return ((air_executor_t *)handle)->num_workers;
+}
+
+uint64_t _mlir_ciface_air_executor_next_rI64_I64_I64(uint64_t handle,
+                                                    uint64_t worker) {
+  return ((air_executor_t *)handle)->next(worker);
+}
+
+void _mlir_ciface_air_executor_end_I64(uint64_t handle) {
+  delete (air_executor_t *)handle;
+}
+}
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: MIT
 
 #include "air_tensor.h"
+#include "copy.h"
 
 #include <cstdint>
 #include <cstdio>
@@ -22,16 +23,8 @@ static void air_memcpy_nd_dst(tensor_t<T, R> *dst, tensor_t<T, R> *src,
   if (VERBOSE)
     printf("dst offset %lu, %lu, size %lu, %lu, stride %lu, %lu\n", offset[1],
            offset[0], size[1], size[0], stride[1], stride[0]);
-  size_t src_offset = 0;
-  for (size_t l = 0; l < size[3]; l++)
-    for (size_t k = 0; k < size[2]; k++)
-      for (size_t j = 0; j < size[1]; j++)
-        for (size_t i = 0; i < size[0]; i++) {
-          size_t idx =
-              ((offset[3] + l) * stride[3]) + ((offset[2] + k) * stride[2]) +
-              ((offset[1] + j) * stride[1]) + ((offset[0] + i) * stride[0]);
-          dst->data[idx] = src->data[src_offset++];
-        }
+  air_copy_nd<T, false>(dst->data, src->data,
+                        air_copy_plan(offset, size, stride));
 }
 
 template <typename T, int R>
@@ -48,16 +41,8 @@ static void air_memcpy_nd_src(tensor_t<T, R> *dst, tensor_t<T, R> *src,
   if (VERBOSE)
     printf("src offset %lu, %lu, size %lu, %lu, stride %lu, %lu\n", offset[1],
            offset[0], size[1], size[0], stride[1], stride[0]);
-  size_t dst_offset = 0;
-  for (size_t l = 0; l < size[3]; l++)
-    for (size_t k = 0; k < size[2]; k++)
-      for (size_t j = 0; j < size[1]; j++)
-        for (size_t i = 0; i < size[0]; i++) {
-          size_t idx =
-              ((offset[3] + l) * stride[3]) + ((offset[2] + k) * stride[2]) +
-              ((offset[1] + j) * stride[1]) + ((offset[0] + i) * stride[0]);
-          dst->data[dst_offset++] = src->data[idx];
-        }
+  air_copy_nd<T, true>(src->data, dst->data,
+                       air_copy_plan(offset, size, stride));
 }
 
 // 4D
@@ -170,51 +155,32 @@ static void air_memcpy_nd_4d_dst(uint32_t id, void *d, uint64_t offset3,
     air_memcpy_nd_4d_dst<type, 1>(id, d, 0, 0, 0, offset0, 1, 1, 1, size0, 1,  \
                                   1, 1, stride0, s);                           \
   }
-extern "C" {
-
-// 4D
-
-mlir_air_dma_nd_memcpy_4d_src(
-    I32_M0D4I32_M0D4I32_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64,
-    int32_t);
-mlir_air_dma_nd_memcpy_4d_dst(
-    I32_M0D4I32_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_M0D4I32,
-    int32_t);
-
-mlir_air_dma_nd_memcpy_4d_src(
-    I32_M0D4F32_M0D4F32_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64, float);
-mlir_air_dma_nd_memcpy_4d_dst(
-    I32_M0D4F32_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_M0D4F32, float);
-
-// 3D
-
-mlir_air_dma_nd_memcpy_3d_dst(
-    I32_M0D3I32_I64_I64_I64_I64_I64_I64_I64_I64_I64_M0D3I32, int32_t);
-mlir_air_dma_nd_memcpy_3d_src(
-    I32_M0D3I32_M0D3I32_I64_I64_I64_I64_I64_I64_I64_I64_I64, int32_t);
+// Instantiate the src and dst entry points of every rank for an element type,
+// given its mangled name. bf16 and f16 share the F16 mangling; a copy only
+// moves bits, so one 16-bit kernel serves both.
+#define mlir_air_dma_nd_memcpy(M, type)                                        \
+  mlir_air_dma_nd_memcpy_4d_src(                                               \
+      I32_M0D4##M##_M0D4##M##_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64, \
+      type);                                                                   \
+  mlir_air_dma_nd_memcpy_4d_dst(                                               \
+      I32_M0D4##M##_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_I64_M0D4##M,   \
+      type);                                                                   \
+  mlir_air_dma_nd_memcpy_3d_src(                                               \
+      I32_M0D3##M##_M0D3##M##_I64_I64_I64_I64_I64_I64_I64_I64_I64, type);      \
+  mlir_air_dma_nd_memcpy_3d_dst(                                               \
+      I32_M0D3##M##_I64_I64_I64_I64_I64_I64_I64_I64_I64_M0D3##M, type);        \
+  mlir_air_dma_nd_memcpy_2d_src(                                               \
+      I32_M0D2##M##_M0D2##M##_I64_I64_I64_I64_I64_I64, type);                  \
+  mlir_air_dma_nd_memcpy_2d_dst(                                               \
+      I32_M0D2##M##_I64_I64_I64_I64_I64_I64_M0D2##M, type);                    \
+  mlir_air_dma_nd_memcpy_1d_src(I32_M0D1##M##_M0D1##M##_I64_I64_I64, type);    \
+  mlir_air_dma_nd_memcpy_1d_dst(I32_M0D1##M##_I64_I64_I64_M0D1##M, type)
 
-mlir_air_dma_nd_memcpy_3d_dst(
-    I32_M0D3F32_I64_I64_I64_I64_I64_I64_I64_I64_I64_M0D3F32, float);
-mlir_air_dma_nd_memcpy_3d_src(
-    I32_M0D3F32_M0D3F32_I64_I64_I64_I64_I64_I64_I64_I64_I64, float);
-
-// 2D
-
-mlir_air_dma_nd_memcpy_2d_src(I32_M0D2I32_M0D2I32_I64_I64_I64_I64_I64_I64,
-                              int32_t);
-mlir_air_dma_nd_memcpy_2d_dst(I32_M0D2I32_I64_I64_I64_I64_I64_I64_M0D2I32,
-                              int32_t);
-
-mlir_air_dma_nd_memcpy_2d_src(I32_M0D2F32_M0D2F32_I64_I64_I64_I64_I64_I64,
-                              float);
-mlir_air_dma_nd_memcpy_2d_dst(I32_M0D2F32_I64_I64_I64_I64_I64_I64_M0D2F32,
-                              float);
-
-// 1D
-
-mlir_air_dma_nd_memcpy_1d_src(I32_M0D1I32_M0D1I32_I64_I64_I64, int32_t);
-mlir_air_dma_nd_memcpy_1d_dst(I32_M0D1I32_I64_I64_I64_M0D1I32, int32_t);
-
-mlir_air_dma_nd_memcpy_1d_dst(I32_M0D1F32_I64_I64_I64_M0D1F32, float);
-mlir_air_dma_nd_memcpy_1d_src(I32_M0D1F32_M0D1F32_I64_I64_I64, float);
+extern "C" {
+mlir_air_dma_nd_memcpy(I8, int8_t);
+mlir_air_dma_nd_memcpy(I16, int16_t);
+mlir_air_dma_nd_memcpy(F16, uint16_t);
+mlir_air_dma_nd_memcpy(I32, int32_t);
+mlir_air_dma_nd_memcpy(F32, float);
+mlir_air_dma_nd_memcpy(I64, int64_t);
 }
@@ -0,0 +1,55 @@
+//===- topology.h -----------------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef AIR_CPU_TOPOLOGY_H
+#define AIR_CPU_TOPOLOGY_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// The host's CPU layout, read from sysfs, used to pin herd tiles to cores
+// (air-to-async pin-herd-tiles) and to place channel storage on the NUMA node
+// of its consumer. Without sysfs (or off Linux) there is a single node and
+// pinning does nothing.
+class air_topology {
+public:
+  // The topology shared by the runtime
+  static air_topology &get();
+
+  // Pin the calling thread to the core of herd tile (x, y) of a sx * sy herd.
+  // Tiles are taken in row-major order and assigned to cores in contiguous
+  // blocks, with cores ordered by NUMA node, so that neighbouring tiles share
+  // a node. Enables NUMA placement of channel storage. The thread's previous
+  // affinity is saved for unpin_tile().
+  void pin_tile(size_t x, size_t y, size_t sx, size_t sy);
+
+  // Restore the affinity the calling thread had before pin_tile(), so that a
+  // pool thread which ran a tile does not stay pinned for its next tasks
+  void unpin_tile();
+
+  // Whether any tile was pinned, i.e. the placement policy is in effect
+  bool pinning() const { return pinned.load(std::memory_order_relaxed); }
+
+  // Move the pages wholly inside [p, p + bytes) to the NUMA node of the
+  // calling thread. Best effort: failures are ignored.
+  void move_to_current_node(void *p, size_t bytes);
+
+  size_t num_nodes() const { return nodes; }
+
+private:
+  air_topology();
+
+  // online cpus, ordered by node, then package and core
+  std::vector<int> cpus;
+  // node of each cpu, indexed by cpu number
+  std::vector<int> cpu_node;
+  size_t nodes = 1;
+  std::atomic<bool> pinned{false};
+};
+
+#endif // AIR_CPU_TOPOLOGY_H
@@ -0,0 +1,466 @@
+//===- trace.cpp ------------------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+#include "trace.h"
+#include "air_tensor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+enum air_trace_kind : uint32_t { put, get, tile, herd };
+
+struct air_trace_event {
+  uint64_t begin;
+  uint64_t end;
+  // channel memref data for put and get
+  const void *channel;
+  uint32_t kind;
+  uint32_t idx;
+  int64_t pid;
+  int64_t tid;
+};
+
+struct air_channel_stats {
+  uint64_t puts = 0;
+  uint64_t gets = 0;
+  uint64_t put_bytes = 0;
+  uint64_t get_bytes = 0;
+  uint64_t put_blocked_ns = 0;
+  uint64_t get_blocked_ns = 0;
+  size_t fanout = 1;
+};
+
+struct air_tile_stats {
+  uint64_t runs = 0;
+  uint64_t busy_ns = 0;
+  uint64_t idle_ns = 0;
+};
+
+// A tile between air_trace_tile_begin and air_trace_tile_end. Owned by the
+// thread which began it; a tile which resumes on another thread (after an
+// async.await) is ended there, and freed by its owner once it sees `done`.
+struct air_trace_tile {
+  int64_t herd;
+  uint64_t x, y, sy;
+  uint64_t herd_begin;
+  uint64_t begin;
+  std::atomic<uint64_t> blocked{0};
+  std::atomic<bool> done{false};
+  air_trace_tile *prev;
+};
+
+// The events and counters recorded by one thread
+struct air_trace_thread {
+  int64_t id;
+  // grows up to `capacity` events, then wraps around
+  std::vector<air_trace_event> ring;
+  size_t capacity;
+  // number of events recorded, including those overwritten since
+  uint64_t count = 0;
+  std::map<std::pair<const void *, size_t>, air_channel_stats> channels;
+  std::map<std::tuple<int64_t, uint64_t, uint64_t>, air_tile_stats> tiles;
+  std::map<int64_t, std::pair<uint64_t, uint64_t>> herd_sizes;
+  // innermost tile started on this thread
+  air_trace_tile *tile = nullptr;
+
+  void record(const air_trace_event &e) {
+    if (ring.size() < capacity)
+      ring.push_back(e);
+    else
+      ring[count % capacity] = e;
+    count++;
+  }
+
+  // The tile channel operations are attributed to, dropping the tiles which
+  // were ended on other threads
+  air_trace_tile *current_tile() {
+    while (tile && tile->done.load(std::memory_order_acquire)) {
+      air_trace_tile *prev = tile->prev;
+      delete tile;
+      tile = prev;
+    }
+    return tile;
+  }
+};
+
+// Tile (x, y) of a herd with sy columns, as numbered by air-runner: ten
+// threads per core, starting from 1
+int64_t air_trace_tile_tid(uint64_t x, uint64_t y, uint64_t sy) {
+  return (x * sy + y) * 10 + 1;
+}
+
+class air_trace_registry {
+public:
+  static air_trace_registry &get() {
+    static air_trace_registry registry;
+    return registry;
+  }
+
+  ~air_trace_registry() { dump(); }
+
+  air_trace_thread *thread() {
+    static thread_local air_trace_thread *t = nullptr;
+    if (!t) {
+      std::lock_guard<std::mutex> lock(mtx);
+      threads.emplace_back(new air_trace_thread);
+      t = threads.back().get();
+      t->id = threads.size();
+      t->capacity = capacity;
+    }
+    return t;
+  }
+
+  void name_channel(const void *channel, std::string name) {
+    std::lock_guard<std::mutex> lock(mtx);
+    channel_names[channel] = name;
+  }
+
+  uint64_t epoch;
+
+private:
+  air_trace_registry() {
+    epoch = air_trace_now();
+    const char *path = getenv("AIR_CPU_TRACE");
+    out_path = path ? path : "";
+    capacity = 1 << 16;
+    if (const char *events = getenv("AIR_CPU_TRACE_EVENTS"))
+      capacity = std::max(1L, atol(events));
+  }
+
+  std::string channel_name(const void *channel) {
+    auto it = channel_names.find(channel);
+    if (it != channel_names.end())
+      return it->second;
+    char name[32];
+    snprintf(name, sizeof(name), "channel@%p", channel);
+    return name;
+  }
+
+  void dump();
+  void dump_stats(uint64_t dropped);
+
+  std::mutex mtx;
+  std::vector<std::unique_ptr<air_trace_thread>> threads;
+  std::map<const void *, std::string> channel_names;
+  std::string out_path;
+  size_t capacity;
+};
+
+// Chrome trace timestamps are in us; write ns as us with 3 d.p.
+void air_trace_write_ts(FILE *f, uint64_t ns) {
+  fprintf(f, "%llu.%03llu", (unsigned long long)(ns / 1000),
+          (unsigned long long)(ns % 1000));
+}
+
+void air_trace_write_metadata(FILE *f, const char *item, const char *arg,
+                              const std::string &entry, int64_t pid,
+                              int64_t tid = -1) {
+  fprintf(f, "{\n  \"name\": \"%s\",\n  \"ph\": \"M\",\n  \"pid\": %lld,\n",
+          item, (long long)pid);
+  if (tid != -1)
+    fprintf(f, "  \"tid\": %lld,\n", (long long)tid);
+  fprintf(f, "  \"args\": {\n    \"%s\": \"%s\"\n  }\n},\n", arg,
+          entry.c_str());
+}
+
+void air_trace_registry::dump() {
+  std::lock_guard<std::mutex> lock(mtx);
+  if (out_path.empty())
+    return;
+
+  // merge the counters and the events still in the rings
+  std::map<std::pair<int64_t, int64_t>, std::string> thread_names;
+  std::map<int64_t, std::pair<uint64_t, uint64_t>> herd_sizes;
+  std::vector<air_trace_event> events;
+  uint64_t dropped = 0;
+  for (auto &t : threads) {
+    uint64_t kept = std::min<uint64_t>(t->count, t->ring.size());
+    dropped += t->count - kept;
+    for (uint64_t i = t->count - kept; i < t->count; i++)
+      events.push_back(t->ring[i % t->ring.size()]);
+    thread_names[{0, t->id}] = "thread " + std::to_string(t->id);
+    for (auto &h : t->herd_sizes)
+      herd_sizes[h.first] = h.second;
+  }
+  for (auto &t : threads)
+    for (auto &s : t->tiles) {
+      int64_t herd;
+      uint64_t x, y;
+      std::tie(herd, x, y) = s.first;
+      int64_t tid = air_trace_tile_tid(x, y, herd_sizes[herd].second);
+      thread_names[{herd, tid}] =
+          "core [" + std::to_string(x) + "," + std::to_string(y) + "]";
+    }
+
+  // split every event into begin and end, nesting the events which begin or
+  // end at the same time by their duration
+  struct edge {
+    uint64_t ts;
+    bool begin;
+    uint64_t duration;
+    const air_trace_event *event;
+  };
+  std::vector<edge> edges;
+  for (auto &e : events) {
+    edges.push_back({e.begin, true, e.end - e.begin, &e});
+    edges.push_back({e.end, false, e.end - e.begin, &e});
+  }
+  std::stable_sort(edges.begin(), edges.end(),
+                   [](const edge &a, const edge &b) {
+                     if (a.ts != b.ts)
+                       return a.ts < b.ts;
+                     if (a.begin != b.begin)
+                       return !a.begin;
+                     return a.begin ? a.duration > b.duration
+                                    : a.duration < b.duration;
+                   });
+
+  FILE *f = fopen(out_path.c_str(), "w");
+  if (!f) {
+    fprintf(stderr, "aircpu: cannot write trace to %s\n", out_path.c_str());
+    return;
+  }
+  fprintf(f, "[\n");
+  air_trace_write_metadata(f, "process_name", "name", "host", 0);
+  for (auto &h : herd_sizes) {
+    air_trace_write_metadata(f, "process_name", "name",
+                             "air.herd[" + std::to_string(h.second.first) +
+                                 ", " + std::to_string(h.second.second) + "]",
+                             h.first);
+    air_trace_write_metadata(f, "process_sort_index", "sort_index",
+                             std::to_string(h.first), h.first);
+  }
+  for (auto &t : thread_names) {
+    air_trace_write_metadata(f, "thread_name", "name", t.second,
+                             t.first.first, t.first.second);
+    air_trace_write_metadata(f, "thread_sort_index", "sort_index",
+                             std::to_string(t.first.second), t.first.first,
+                             t.first.second);
+  }
+  for (auto &e : edges) {
+    const air_trace_event &ev = *e.event;
+    std::string name;
+    if (ev.kind == air_trace_kind::put)
+      name = "ChannelPutOp@" + channel_name(ev.channel);
+    else if (ev.kind == air_trace_kind::get)
+      name = "ChannelGetOp@" + channel_name(ev.channel);
+    else if (ev.kind == air_trace_kind::herd)
+      name = "HerdOp";
+    else
+      name = thread_names[{ev.pid, ev.tid}];
+    fprintf(f,
+            "{\n  \"name\": \"%s\",\n  \"cat\": \"layer\",\n  \"ph\": "
+            "\"%s\",\n  \"ts\": ",
+            name.c_str(), e.begin ? "B" : "E");
+    air_trace_write_ts(f, e.ts >= epoch ? e.ts - epoch : 0);
+    fprintf(f, ",\n  \"pid\": %lld,\n  \"tid\": %lld,\n  \"args\": {}\n},\n",
+            (long long)ev.pid, (long long)ev.tid);
+  }
+  fprintf(f, "{}]\n");
+  fclose(f);
+
+  dump_stats(dropped);
+}
+
+void air_trace_registry::dump_stats(uint64_t dropped) {
+  std::map<std::pair<const void *, size_t>, air_channel_stats> channels;
+  std::map<std::tuple<int64_t, uint64_t, uint64_t>, air_tile_stats> tiles;
+  for (auto &t : threads) {
+    for (auto &c : t->channels) {
+      auto &s = channels[c.first];
+      s.puts += c.second.puts;
+      s.gets += c.second.gets;
+      s.put_bytes += c.second.put_bytes;
+      s.get_bytes += c.second.get_bytes;
+      s.put_blocked_ns += c.second.put_blocked_ns;
+      s.get_blocked_ns += c.second.get_blocked_ns;
+      s.fanout = std::max(s.fanout, c.second.fanout);
+    }
+    for (auto &c : t->tiles) {
+      auto &s = tiles[c.first];
+      s.runs += c.second.runs;
+      s.busy_ns += c.second.busy_ns;
+      s.idle_ns += c.second.idle_ns;
+    }
+  }
+
+  FILE *f = fopen((out_path + ".stats.json").c_str(), "w");
+  if (!f)
+    return;
+  fprintf(f, "{\n  \"channels\": [");
+  const char *sep = "\n";
+  for (auto &c : channels) {
+    auto &s = c.second;
+    fprintf(f,
+            "%s    {\"name\": \"%s\", \"index\": %zu, \"fanout\": %zu, "
+            "\"puts\": %llu, \"gets\": %llu, \"put_bytes\": %llu, "
+            "\"get_bytes\": %llu, \"put_blocked_ns\": %llu, "
+            "\"get_blocked_ns\": %llu}",
+            sep, channel_name(c.first.first).c_str(), c.first.second,
+            s.fanout, (unsigned long long)s.puts, (unsigned long long)s.gets,
+            (unsigned long long)s.put_bytes, (unsigned long long)s.get_bytes,
+            (unsigned long long)s.put_blocked_ns,
+            (unsigned long long)s.get_blocked_ns);
+    sep = ",\n";
+  }
+  fprintf(f, "\n  ],\n  \"tiles\": [");
+  sep = "\n";
+  for (auto &c : tiles) {
+    int64_t herd;
+    uint64_t x, y;
+    std::tie(herd, x, y) = c.first;
+    fprintf(f,
+            "%s    {\"herd\": %lld, \"tile\": [%llu, %llu], \"runs\": %llu, "
+            "\"busy_ns\": %llu, \"idle_ns\": %llu}",
+            sep, (long long)herd, (unsigned long long)x,
+            (unsigned long long)y, (unsigned long long)c.second.runs,
+            (unsigned long long)c.second.busy_ns,
+            (unsigned long long)c.second.idle_ns);
+    sep = ",\n";
+  }
+  fprintf(f, "\n  ],\n  \"dropped_events\": %llu\n}\n",
+          (unsigned long long)dropped);
+  fclose(f);
+}
+
+bool air_trace_init() {
+  if (!getenv("AIR_CPU_TRACE"))
+    return false;
+  // construct the registry now, so that it outlives the runtime's users
+  air_trace_registry::get();
+  return true;
+}
+
+} // namespace
+
+const bool air_trace_enabled = air_trace_init();
+
+uint64_t air_trace_now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void air_trace_channel(const void *channel, size_t idx, bool put,
+                       uint64_t begin, uint64_t blocked, size_t bytes,
+                       size_t fanout) {
+  uint64_t end = air_trace_now();
+  air_trace_thread *t = air_trace_registry::get().thread();
+  air_trace_event e{begin,
+                    end,
+                    channel,
+                    put ? air_trace_kind::put : air_trace_kind::get,
+                    (uint32_t)idx,
+                    0,
+                    t->id};
+  if (air_trace_tile *tile = t->current_tile()) {
+    tile->blocked.fetch_add(blocked, std::memory_order_relaxed);
+    e.pid = tile->herd;
+    e.tid = air_trace_tile_tid(tile->x, tile->y, tile->sy);
+  }
+  t->record(e);
+
+  auto &s = t->channels[{channel, idx}];
+  s.fanout = fanout;
+  if (put) {
+    s.puts++;
+    s.put_bytes += bytes;
+    s.put_blocked_ns += blocked;
+  } else {
+    s.gets++;
+    s.get_bytes += bytes;
+    s.get_blocked_ns += blocked;
+  }
+}
+
+extern "C" {
+
+void _mlir_ciface_air_trace_channel_name_M0D2I64_M0D1I8(void *c, void *n) {
+  if (!air_trace_enabled)
+    return;
+  tensor_t<uint64_t, 2> *channel = (tensor_t<uint64_t, 2> *)c;
+  tensor_t<char, 1> *name = (tensor_t<char, 1> *)n;
+  air_trace_registry::get().name_channel(
+      channel->data, std::string(name->data + name->offset, name->shape[0]));
+}
+
+// Returns the start time of the herd, to be passed to the calls below
+uint64_t _mlir_ciface_air_trace_herd_begin_rI64_I64_I64_I64(uint64_t herd,
+                                                            uint64_t sx,
+                                                            uint64_t sy) {
+  if (!air_trace_enabled)
+    return 0;
+  air_trace_registry::get().thread()->herd_sizes[herd] = {sx, sy};
+  return air_trace_now();
+}
+
+void _mlir_ciface_air_trace_herd_end_I64_I64(uint64_t herd, uint64_t begin) {
+  if (!air_trace_enabled)
+    return;
+  air_trace_thread *t = air_trace_registry::get().thread();
+  t->record({begin, air_trace_now(), nullptr, air_trace_kind::herd, 0,
+             (int64_t)herd, 0});
+}
+
+// Returns a handle to the running tile for air_trace_tile_end
+uint64_t _mlir_ciface_air_trace_tile_begin_rI64_I64_I64_I64_I64_I64_I64(
+    uint64_t herd, uint64_t herd_begin, uint64_t x, uint64_t y, uint64_t sx,
+    uint64_t sy) {
+  (void)sx;
+  if (!air_trace_enabled)
+    return 0;
+  air_trace_thread *t = air_trace_registry::get().thread();
+  air_trace_tile *tile = new air_trace_tile;
+  tile->herd = herd;
+  tile->x = x;
+  tile->y = y;
+  tile->sy = sy;
+  tile->herd_begin = herd_begin;
+  tile->begin = air_trace_now();
+  tile->prev = t->current_tile();
+  t->tile = tile;
+  return (uint64_t)tile;
+}
+
+// A tile is busy from its start to its end, except while blocked on a
+// channel; it is idle while blocked and from the start of its herd to its own
+void _mlir_ciface_air_trace_tile_end_I64(uint64_t handle) {
+  air_trace_tile *tile = (air_trace_tile *)handle;
+  if (!tile)
+    return;
+  uint64_t end = air_trace_now();
+  air_trace_thread *t = air_trace_registry::get().thread();
+  int64_t tid = air_trace_tile_tid(tile->x, tile->y, tile->sy);
+  t->record(
+      {tile->begin, end, nullptr, air_trace_kind::tile, 0, tile->herd, tid});
+
+  uint64_t blocked = tile->blocked.load(std::memory_order_relaxed);
+  uint64_t span = end - tile->begin;
+  auto &s = t->tiles[std::make_tuple(tile->herd, tile->x, tile->y)];
+  s.runs++;
+  s.busy_ns += span > blocked ? span - blocked : 0;
+  s.idle_ns += blocked + (tile->begin - tile->herd_begin);
+
+  if (t->tile == tile) {
+    t->tile = tile->prev;
+    delete tile;
+  } else {
+    tile->done.store(true, std::memory_order_release);
+  }
+}
+}
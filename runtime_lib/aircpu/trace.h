@@ -0,0 +1,38 @@
+//===- trace.h --------------------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+// SPDX-License-Identifier: MIT
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef AIR_CPU_TRACE_H
+#define AIR_CPU_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Runtime instrumentation of channels and herd tiles, enabled by setting
+// AIR_CPU_TRACE to an output path. Each thread records events into a ring
+// buffer of its own (AIR_CPU_TRACE_EVENTS events, by default 65536; older
+// events are overwritten) and keeps exact per-channel and per-tile counters.
+// At exit the events are written to the path in the Chrome trace layout of
+// air-runner, and the counters to <path>.stats.json.
+//
+// Herd and tile events come from the calls air-to-async emits with its
+// `trace` option. Channel events are attributed to the tile last started on
+// the calling thread, or to the host process (pid 0) outside of tiles.
+
+// Whether tracing is enabled; set once when the runtime is loaded
+extern const bool air_trace_enabled;
+
+// Monotonic time in ns
+uint64_t air_trace_now();
+
+// Record a put (or get) on index idx of the channel whose memref data is
+// `channel`, which started at `begin` and spent `blocked` ns waiting for a
+// free (or full) slot.
+void air_trace_channel(const void *channel, size_t idx, bool put,
+                       uint64_t begin, uint64_t blocked, size_t bytes,
+                       size_t fanout);
+
+#endif // AIR_CPU_TRACE_H
@@ -12,21 +12,210 @@
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <new>
 #include <stdlib.h>
+#include <thread>
 
-template <typename T> struct channel_t {
-  T *data;
+// A bounded ring buffer of `depth` slots, each holding one channel transfer.
+// Producers and (possibly broadcast) consumers claim positions in the ring
+// with atomic counters. Each slot carries a sequence number which encodes
+// whether it is free for the producer at position p (2 * p) or holds the data
+// of position p (2 * p + 1). A slot is freed for position p + depth once every
+// broadcast consumer has read it. Threads spin briefly on the sequence number
+// before parking on the condition variable.
+//
+// Broadcast consumers all read the one buffer published in a slot, which is
+// immutable until the last of them releases it, and never take the lock on
+// the way. The state of each slot and of each consumer sits on a cache line
+// of its own, so that consumers only share the slot's sequence number and
+// reader count.
+//
+// The slot storage is untyped and owned by the caller: it is attached by the
+// first producer through reserve(), so that a channel can be created before
+// the element type and transfer size are known.
+//
+// On a channel without broadcast, a consumer which reaches its slot before the
+// producer leaves a claim (its destination, opaque to the channel) on the
+// slot. The producer takes the claim when it acquires the slot and may write
+// straight into the consumer's destination instead of into the slot, so that
+// the data moves once. Neither side waits for the other to do so: a consumer
+// which arrives late reads the slot as usual.
+struct channel_t {
+  struct alignas(64) slot_t {
+    std::atomic<size_t> seq;
+    // Number of broadcast consumers yet to read the slot
+    std::atomic<size_t> pending;
+    // Claim left by a waiting consumer, or the slot's own address once the
+    // producer has taken it
+    std::atomic<void *> claim;
+  };
+
+  struct alignas(64) lane_t {
+    // Next position to claim; one lane per broadcast consumer and one shared
+    // by the producers
+    std::atomic<size_t> pos;
+    // Number of threads inside a put or get on the lane
+    std::atomic<int> active;
+  };
+
+  char *data;
+  size_t slot_bytes;
+  size_t depth;
   size_t bcast_ratio[2];
-  std::atomic<int> token;
+  // Number of consumers which read every slot
+  size_t readers;
+
+  slot_t *slots;
+  // lanes[0, readers) belong to the consumers, lanes[readers] to producers
+  lane_t *lanes;
+
+  // Number of owners which created the channel, guarded by the creator
+  size_t users;
+
+  std::atomic<int> waiters;
   std::mutex mtx;
   std::condition_variable cv;
+  std::once_flag storage_once;
+  // lets the runtime place the storage (e.g. on a NUMA node) once
+  std::once_flag placement_once;
+
+  static const int spin_count = 1024;
 
-  channel_t(size_t sizes[4], size_t ratio[2]) {
-    data = new T[sizes[0] * sizes[1] * sizes[2] * sizes[3]];
+  channel_t(size_t ratio[2], size_t depth = 1) {
+    data = nullptr;
+    slot_bytes = 0;
+    this->depth = depth ? depth : 1;
     bcast_ratio[0] = ratio[0];
     bcast_ratio[1] = ratio[1];
-    token.store(0);
-    cv.notify_all();
+    readers = ratio[0] * ratio[1];
+    slots = new_lines<slot_t>(this->depth);
+    for (size_t i = 0; i < this->depth; i++) {
+      slots[i].seq.store(2 * i);
+      slots[i].pending.store(0);
+      slots[i].claim.store(nullptr);
+    }
+    lanes = new_lines<lane_t>(readers + 1);
+    for (size_t i = 0; i <= readers; i++) {
+      lanes[i].pos.store(0);
+      lanes[i].active.store(0);
+    }
+    users = 1;
+    waiters.store(0);
+  }
+
+  ~channel_t() {
+    free(slots);
+    free(lanes);
+  }
+
+  // Attach storage for slots of at least `bytes` bytes, allocated with
+  // alloc(total_bytes), on the first call. Returns false if the storage
+  // attached earlier is too small.
+  template <typename Alloc> bool reserve(size_t bytes, Alloc alloc) {
+    std::call_once(storage_once, [&] {
+      // keep every slot cache line aligned
+      slot_bytes = (bytes + 63) / 64 * 64;
+      data = (char *)alloc(slot_bytes * depth);
+    });
+    return data && bytes <= slot_bytes;
+  }
+
+  // Claim the next position for writing and wait until its slot is free.
+  // Returns the slot's buffer.
+  void *acquire_write(size_t &pos) {
+    pos = lanes[readers].pos.fetch_add(1);
+    slot_t &s = slots[pos % depth];
+    wait_until([&] { return s.seq.load() == 2 * pos; });
+    return data + (pos % depth) * slot_bytes;
+  }
+
+  // Take the claim a consumer left on an acquired write position, if any. A
+  // consumer can no longer leave one afterwards. Whatever the producer writes
+  // to the claim must happen before release_write().
+  void *take_claim(size_t pos) {
+    slot_t &s = slots[pos % depth];
+    return s.claim.exchange(&s);
+  }
+
+  // Publish the data written at a position to all consumers
+  void release_write(size_t pos) {
+    slot_t &s = slots[pos % depth];
+    s.pending.store(readers);
+    s.seq.store(2 * pos + 1);
+    wake();
+  }
+
+  // Claim the next position for a broadcast consumer and wait until its data
+  // is published. Returns the slot's buffer. Without broadcast, a non-null
+  // claim is left on the slot if the producer has not acquired it yet.
+  void *acquire_read(size_t reader, size_t &pos, void *claim = nullptr) {
+    pos = lanes[reader % readers].pos.fetch_add(1);
+    slot_t &s = slots[pos % depth];
+    if (claim && readers == 1) {
+      wait_until([&] { return s.seq.load() >= 2 * pos; });
+      void *none = nullptr;
+      if (s.seq.load() == 2 * pos)
+        s.claim.compare_exchange_strong(none, claim);
+    }
+    wait_until([&] { return s.seq.load() == 2 * pos + 1; });
+    return data + (pos % depth) * slot_bytes;
+  }
+
+  // Mark a position as read by one consumer; the last one frees the slot
+  void release_read(size_t pos) {
+    slot_t &s = slots[pos % depth];
+    if (s.pending.fetch_sub(1) == 1) {
+      s.claim.store(nullptr);
+      s.seq.store(2 * (pos + depth));
+      wake();
+    }
+  }
+
+  // Track the threads using the channel, so that it is only destroyed once
+  // every put and get on it has returned. Producers use enter() and leave(),
+  // consumers the variants taking their broadcast index.
+  void enter() { lanes[readers].active.fetch_add(1); }
+  void leave() { leave_lane(lanes[readers]); }
+  void enter(size_t reader) { lanes[reader % readers].active.fetch_add(1); }
+  void leave(size_t reader) { leave_lane(lanes[reader % readers]); }
+  void wait_idle() {
+    for (size_t i = 0; i <= readers; i++)
+      wait_until([&] { return lanes[i].active.load() == 0; });
+  }
+
+private:
+  // An array of n default-initialized T on cache line boundaries, to be
+  // released with free()
+  template <typename T> static T *new_lines(size_t n) {
+    void *p = nullptr;
+    if (posix_memalign(&p, alignof(T), n * sizeof(T)))
+      abort();
+    return new (p) T[n];
+  }
+
+  void leave_lane(lane_t &lane) {
+    if (lane.active.fetch_sub(1) == 1)
+      wake();
+  }
+
+  template <typename Pred> void wait_until(Pred pred) {
+    for (int i = 0; i < spin_count; i++) {
+      if (pred())
+        return;
+      if (i >= spin_count / 2)
+        std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mtx);
+    waiters.fetch_add(1);
+    cv.wait(lock, pred);
+    waiters.fetch_sub(1);
+  }
+
+  void wake() {
+    if (waiters.load() > 0) {
+      std::lock_guard<std::mutex> lock(mtx);
+      cv.notify_all();
+    }
   }
 };
 
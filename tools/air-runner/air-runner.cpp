@@ -62,11 +62,43 @@ LogicalResult run(int argc, char **argv, llvm::StringRef toolName) {
                                        llvm::cl::value_desc("bool"),
                                        llvm::cl::init(false));
 
+  static llvm::cl::opt<std::string> clLaunchIterations(
+      "launch-iterations",
+      llvm::cl::desc("simulate every iteration of each air.launch, or simulate "
+                     "the first and replay its latency for the rest (pick "
+                     "from simulate and replay); launches which depend on "
+                     "their induction variables are always simulated in full"),
+      llvm::cl::value_desc("string"), llvm::cl::init("simulate"));
+
+  static llvm::cl::opt<std::string> clTraceFormat(
+      "trace-format",
+      llvm::cl::desc("trace output format (pick from json, json-compact and "
+                     "perfetto)"),
+      llvm::cl::value_desc("string"), llvm::cl::init("json"));
+
+  static llvm::cl::opt<std::string> clTraceFilter(
+      "trace-filter",
+      llvm::cl::desc("comma-separated hierarchy levels (launch, segment, herd) "
+                     "and event kinds (e.g. dma, channel, execute) to trace; "
+                     "traces everything if empty"),
+      llvm::cl::value_desc("string"), llvm::cl::init(""));
+
   llvm::InitLLVM y(argc, argv);
   llvm::cl::ParseCommandLineOptions(argc, argv, toolName);
 
   verbose = clVerbose;
   sim_granularity = clSimGranularity;
+  if (clLaunchIterations != "simulate" && clLaunchIterations != "replay") {
+    llvm::errs() << "Unknown launch iteration mode " << clLaunchIterations
+                 << "\n";
+    return failure();
+  }
+  if (!xilinx::air::isTraceFormat(clTraceFormat)) {
+    llvm::errs() << "Unknown trace format " << clTraceFormat
+                 << " (expected one of " << xilinx::air::getTraceFormats()
+                 << ")\n";
+    return failure();
+  }
   // herd_slots = clHerdSlots;
   // dispatch_slots = clDispatchSlots;
 
@@ -125,7 +157,9 @@ LogicalResult run(int argc, char **argv, llvm::StringRef toolName) {
     if (!jsonModel)
       llvm_unreachable("failed to parse model json\n");
 
-    xilinx::air::AIRRunner runner(os, *jsonModel, sim_granularity, clVerbose);
+    xilinx::air::AIRRunner runner(os, *jsonModel, sim_granularity, clVerbose,
+                                  clLaunchIterations, clTraceFormat,
+                                  clTraceFilter);
 
     // The number of outputs of the function in the IR.
     unsigned numOutputs = 0;